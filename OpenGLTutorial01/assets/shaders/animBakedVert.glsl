@@ -0,0 +1,99 @@
+#version 430
+
+#include "sharedUniforms.glsl"
+
+// animInstancedVert.glsl for cBakedAnimation: no palettes from the CPU at all, each instance
+// only says which baked clip it plays and how far in, and the bones come out of the baked texture
+layout (location = 0) in vec3 aPos;
+// sPackedSkinnedVertex: normal, tangent and bitangent packed as one quaternion,
+// the sign of w is the bitangent's handedness
+layout (location = 1) in vec4 aTangentFrame;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 5) in uvec4 aBoneIDs;
+layout (location = 6) in vec4 aBoneWeights;
+
+// sBakedInstance
+struct BakedInstance
+{
+	mat4 model;
+	vec4 clip;		// firstFrame, numFrames, framesPerSecond, time in seconds
+};
+layout (std430, binding = 2) readonly buffer BakedInstances
+{
+	BakedInstance bakedInstances[];
+};
+
+// A row per frame, three texels per bone holding the rows of its 3x4 palette matrix
+uniform sampler2D bakedBones;
+uniform int numBonesUsed;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+out vec3 fTangent;		// For bump (or normal) mapping
+out vec3 fBitangent;	// For bump (or normal) mapping
+
+// Same as cVertexQuantizer::decodeTangentFrame
+void decodeTangentFrame(vec4 encoded, out vec3 normal, out vec3 tangent, out vec3 bitangent)
+{
+	vec4 q = normalize(encoded);
+	tangent = vec3(1.0 - 2.0 * (q.y * q.y + q.z * q.z), 2.0 * (q.x * q.y + q.w * q.z), 2.0 * (q.x * q.z - q.w * q.y));
+	normal = vec3(2.0 * (q.x * q.z + q.w * q.y), 2.0 * (q.y * q.z - q.w * q.x), 1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+	bitangent = cross(normal, tangent) * (encoded.w < 0.0 ? -1.0 : 1.0);
+}
+
+// The bone's palette blended between two frames, left as three rows
+void fetchBone(int bone, int frameFrom, int frameTo, float factor, out vec4 row0, out vec4 row1, out vec4 row2)
+{
+	int column = bone * 3;
+	row0 = mix(texelFetch(bakedBones, ivec2(column, frameFrom), 0), texelFetch(bakedBones, ivec2(column, frameTo), 0), factor);
+	row1 = mix(texelFetch(bakedBones, ivec2(column + 1, frameFrom), 0), texelFetch(bakedBones, ivec2(column + 1, frameTo), 0), factor);
+	row2 = mix(texelFetch(bakedBones, ivec2(column + 2, frameFrom), 0), texelFetch(bakedBones, ivec2(column + 2, frameTo), 0), factor);
+}
+
+void main()
+{
+	vec4 vertPosition = vec4(aPos, 1.0f);
+
+	mat4 model = bakedInstances[gl_InstanceID].model;
+	vec4 clip = bakedInstances[gl_InstanceID].clip;
+
+	// Wraps like cAnimationClip::getAnimationTime, the last frame blending back into the first
+	int numFrames = int(clip.y);
+	float frame = mod(clip.w * clip.z, clip.y);
+	int frameIndex = min(int(frame), numFrames - 1);
+	int frameFrom = int(clip.x) + frameIndex;
+	int frameTo = int(clip.x) + (frameIndex + 1) % numFrames;
+	float factor = frame - float(frameIndex);
+
+	vec4 row0 = vec4(0.0);
+	vec4 row1 = vec4(0.0);
+	vec4 row2 = vec4(0.0);
+	for (int influence = 0; influence < 4; influence++)
+	{
+		if (aBoneWeights[influence] == 0.0)
+			continue;
+		vec4 boneRow0, boneRow1, boneRow2;
+		fetchBone(min(int(aBoneIDs[influence]), numBonesUsed - 1), frameFrom, frameTo, factor, boneRow0, boneRow1, boneRow2);
+		row0 += boneRow0 * aBoneWeights[influence];
+		row1 += boneRow1 * aBoneWeights[influence];
+		row2 += boneRow2 * aBoneWeights[influence];
+	}
+	mat4 BoneTransform = transpose(mat4(row0, row1, row2, vec4(0.0, 0.0, 0.0, 1.0)));
+	vertPosition = BoneTransform * vertPosition;
+
+	gl_Position = viewProjection * model * vertPosition;
+
+	// Inverse transform to keep ONLY rotation...
+	mat4 matNormal = inverse( transpose(BoneTransform * model) );
+
+	vec3 normal, tangent, bitangent;
+	decodeTangentFrame(aTangentFrame, normal, tangent, bitangent);
+	Normal = mat3(matNormal) * normal;
+	fTangent = mat3(matNormal) * tangent;
+	fBitangent = mat3(matNormal) * bitangent;
+
+	FragPos = (model * vertPosition).xyz;
+
+	TexCoords = aTexCoord;
+}
@@ -0,0 +1,69 @@
+#version 430
+
+#include "sharedUniforms.glsl"
+
+// animVert.glsl for cSkinnedInstanceRenderer: one draw for every instance of a mesh,
+// with each instance's model matrix and bone palette read from buffers by gl_InstanceID
+layout (location = 0) in vec3 aPos;
+// sPackedSkinnedVertex: normal, tangent and bitangent packed as one quaternion,
+// the sign of w is the bitangent's handedness
+layout (location = 1) in vec4 aTangentFrame;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 5) in uvec4 aBoneIDs;
+layout (location = 6) in vec4 aBoneWeights;
+
+// numBonesUsed palettes after each other, one per instance. No fixed cap on the bone count
+layout (std430, binding = 0) readonly buffer BonePalettes
+{
+	mat4 bonePalettes[];
+};
+layout (std430, binding = 1) readonly buffer InstanceModels
+{
+	mat4 instanceModels[];
+};
+
+uniform int numBonesUsed;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+out vec3 fTangent;		// For bump (or normal) mapping
+out vec3 fBitangent;	// For bump (or normal) mapping
+
+// Same as cVertexQuantizer::decodeTangentFrame
+void decodeTangentFrame(vec4 encoded, out vec3 normal, out vec3 tangent, out vec3 bitangent)
+{
+	vec4 q = normalize(encoded);
+	tangent = vec3(1.0 - 2.0 * (q.y * q.y + q.z * q.z), 2.0 * (q.x * q.y + q.w * q.z), 2.0 * (q.x * q.z - q.w * q.y));
+	normal = vec3(2.0 * (q.x * q.z + q.w * q.y), 2.0 * (q.y * q.z - q.w * q.x), 1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+	bitangent = cross(normal, tangent) * (encoded.w < 0.0 ? -1.0 : 1.0);
+}
+
+void main()
+{
+	vec4 vertPosition = vec4(aPos, 1.0f);
+
+	mat4 model = instanceModels[gl_InstanceID];
+	int paletteStart = gl_InstanceID * numBonesUsed;
+
+	mat4 BoneTransform = bonePalettes[ paletteStart + int(aBoneIDs[0]) ] * aBoneWeights[0];
+	BoneTransform += bonePalettes[ paletteStart + int(aBoneIDs[1]) ] * aBoneWeights[1];
+	BoneTransform += bonePalettes[ paletteStart + int(aBoneIDs[2]) ] * aBoneWeights[2];
+	BoneTransform += bonePalettes[ paletteStart + int(aBoneIDs[3]) ] * aBoneWeights[3];
+	vertPosition = BoneTransform * vertPosition;
+
+	gl_Position = viewProjection * model * vertPosition;
+
+	// Inverse transform to keep ONLY rotation...
+	mat4 matNormal = inverse( transpose(BoneTransform * model) );
+
+	vec3 normal, tangent, bitangent;
+	decodeTangentFrame(aTangentFrame, normal, tangent, bitangent);
+	Normal = mat3(matNormal) * normal;
+	fTangent = mat3(matNormal) * tangent;
+	fBitangent = mat3(matNormal) * bitangent;
+
+	FragPos = (model * vertPosition).xyz;
+
+	TexCoords = aTexCoord;
+}
@@ -1,16 +1,16 @@
 #version 430
 
+#include "sharedUniforms.glsl"
+
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
+// sPackedSkinnedVertex: normal, tangent and bitangent packed as one quaternion,
+// the sign of w is the bitangent's handedness
+layout (location = 1) in vec4 aTangentFrame;
 layout (location = 2) in vec2 aTexCoord;
-layout (location = 3) in vec3 aTangent;
-layout (location = 4) in vec3 aBitangent;
-layout (location = 5) in vec4 aBoneIDs;
+layout (location = 5) in uvec4 aBoneIDs;
 layout (location = 6) in vec4 aBoneWeights;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 const int MAXNUMBEROFBONES = 100;
 uniform mat4 bones[MAXNUMBEROFBONES];
 // Pass the acutal number you are using to control how often this loops
@@ -22,6 +22,15 @@ out vec2 TexCoords;
 out vec3 fTangent;		// For bump (or normal) mapping
 out vec3 fBitangent;	// For bump (or normal) mapping
 
+// Same as cVertexQuantizer::decodeTangentFrame
+void decodeTangentFrame(vec4 encoded, out vec3 normal, out vec3 tangent, out vec3 bitangent)
+{
+	vec4 q = normalize(encoded);
+	tangent = vec3(1.0 - 2.0 * (q.y * q.y + q.z * q.z), 2.0 * (q.x * q.y + q.w * q.z), 2.0 * (q.x * q.z - q.w * q.y));
+	normal = vec3(2.0 * (q.x * q.z + q.w * q.y), 2.0 * (q.y * q.z - q.w * q.x), 1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+	bitangent = cross(normal, tangent) * (encoded.w < 0.0 ? -1.0 : 1.0);
+}
+
 void main()
 {
     //gl_Position = MVP * vec4(vPos, 0.0, 1.0);	
@@ -29,13 +38,13 @@ void main()
 	
 	mat4 matModel = model;	
 
-	mat4 BoneTransform = bones[ int(aBoneIDs[0]) ] * aBoneWeights[0];
-	BoneTransform += bones[ int(aBoneIDs[1]) ] * aBoneWeights[1];
-	BoneTransform += bones[ int(aBoneIDs[2]) ] * aBoneWeights[2];
-	BoneTransform += bones[ int(aBoneIDs[3]) ] * aBoneWeights[3];
+	mat4 BoneTransform = bones[ aBoneIDs[0] ] * aBoneWeights[0];
+	BoneTransform += bones[ aBoneIDs[1] ] * aBoneWeights[1];
+	BoneTransform += bones[ aBoneIDs[2] ] * aBoneWeights[2];
+	BoneTransform += bones[ aBoneIDs[3] ] * aBoneWeights[3];
 	vertPosition = BoneTransform * vertPosition;
 	
-	mat4 matMVP = projection * view * model;		// m = p * v * m;
+	mat4 matMVP = viewProjection * model;		// m = p * v * m;
 	
 	// Final screen space position	
 	gl_Position = matMVP * vertPosition;	
@@ -43,9 +52,11 @@ void main()
 	// Inverse transform to keep ONLY rotation...
 	mat4 matNormal = inverse( transpose(BoneTransform * model) );
 	
-	Normal = mat3(matNormal) * normalize(aNormal.xyz);
-	fTangent = 	mat3(matNormal) * normalize(aTangent.xyz);
-	fBitangent = 	mat3(matNormal) * normalize(aBitangent.xyz);
+	vec3 normal, tangent, bitangent;
+	decodeTangentFrame(aTangentFrame, normal, tangent, bitangent);
+	Normal = mat3(matNormal) * normal;
+	fTangent = 	mat3(matNormal) * tangent;
+	fBitangent = 	mat3(matNormal) * bitangent;
 	
 	FragPos = (model * vertPosition).xyz;
 	
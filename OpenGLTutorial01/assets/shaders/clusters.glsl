@@ -0,0 +1,49 @@
+// Pulled in with #include "clusters.glsl", after sharedUniforms.glsl and lights.glsl. The view frustum is cut into
+// CLUSTERS_X by CLUSTERS_Y screen tiles and CLUSTERS_Z depth slices, the slices spaced exponentially so the near
+// ones stay thin. cLightClusterPass (lightClusterComp.glsl) lists the point and spot lights touching each cluster
+// once per view. CLUSTERS_X, CLUSTERS_Y, CLUSTERS_Z and MAX_CLUSTER_LIGHTS are its constants, defined for every
+// shader by cLightClusterPass::defineShaderConstants
+
+// Per cluster: how many point lights, how many spot lights. Their indices start at cluster * MAX_CLUSTER_LIGHTS
+// in clusterLightIndices, the spot lights first
+layout (std430, binding = 6) buffer ClusterCounts
+{
+	uvec2 clusterCounts[];
+};
+
+layout (std430, binding = 7) buffer ClusterLightIndices
+{
+	uint clusterLightIndices[];
+};
+
+// The near and far planes, back out of a glm::perspective projection
+float getClusterNear()
+{
+	return projection[3][2] / (projection[2][2] - 1.0);
+}
+
+float getClusterFar()
+{
+	return projection[3][2] / (projection[2][2] + 1.0);
+}
+
+// Distance in front of the camera where the slice starts
+float getSliceDepth(int slice)
+{
+	float clipNear = getClusterNear();
+	return clipNear * pow(getClusterFar() / clipNear, float(slice) / float(CLUSTERS_Z));
+}
+
+int getClusterIndex(vec3 worldPosition)
+{
+	vec4 clipPosition = viewProjection * vec4(worldPosition, 1.0);
+	vec2 ndc = clipPosition.xy / clipPosition.w;
+	ivec2 tile = clamp(ivec2((ndc * 0.5 + 0.5) * vec2(CLUSTERS_X, CLUSTERS_Y)), ivec2(0), ivec2(CLUSTERS_X - 1, CLUSTERS_Y - 1));
+
+	float clipNear = getClusterNear();
+	float viewDepth = -(view * vec4(worldPosition, 1.0)).z;
+	float slice = log(max(viewDepth, clipNear) / clipNear) / log(getClusterFar() / clipNear) * float(CLUSTERS_Z);
+	int sliceIndex = clamp(int(slice), 0, CLUSTERS_Z - 1);
+
+	return (sliceIndex * CLUSTERS_Y + tile.y) * CLUSTERS_X + tile.x;
+}
@@ -1,4 +1,9 @@
 #version 450 core
+
+#include "sharedUniforms.glsl"
+#include "lights.glsl"
+#include "clusters.glsl"
+
 out vec4 FragColor;
 
 struct Material
@@ -17,44 +22,6 @@ struct Material
 	float shininess;
 };
 
-struct DirLight
-{
-	vec3 direction;
-	
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
-
-struct PointLight
-{
-	vec3 position;
-	
-	float constant;
-	float linear;
-	float quadratic;
-	
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
-
-struct SpotLight
-{
-	vec3 position;
-	vec3 direction;
-	float cutOff;
-	float outerCutOff;
-	
-	float constant;
-	float linear;
-	float quadratic;
-	
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
-
 in vec2 TexCoords;
 in vec3 Normal;
 in vec3 FragPos;
@@ -66,22 +33,17 @@ uniform samplerCube skybox;
 uniform vec3 objectColor;
 uniform vec3 lightColor;
 uniform vec3 lightPos;
-uniform vec3 cameraPos;
 uniform int reflectRefract;
 
-#define NUM_POINT_LIGHTS 4
-
 uniform Material material;
-uniform DirLight dirLight;
-uniform PointLight pointLights[NUM_POINT_LIGHTS];
-uniform SpotLight spotLight;
 
 float near = 0.1;
 float far = 100.0;
 
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcDirLight(DirLight light, vec3 albedo, vec3 normal, vec3 viewDir);
+vec3 CalcPointLight(PointLight light, vec3 albedo, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcSpotLight(SpotLight light, vec3 albedo, vec3 normal, vec3 fragPos, vec3 viewDir);
+float CalcRangeFade(float distance, float radius);
 float LinearizeDepth(float depth);
 
 void main()
@@ -94,16 +56,32 @@ void main()
 	{
 		//Using textures and lighting
 		vec3 norm = normalize(Normal);
-		vec3 viewDir = normalize(cameraPos - FragPos);
+		vec3 viewDir = normalize(cameraPosition.xyz - FragPos);
+		
+		vec3 albedo = vec3(texture(material.texture_diffuse1, TexCoords));
+		vec3 result = vec3(0.0);
 		
-		vec3 result = CalcDirLight(dirLight, norm, viewDir);
+		//However many lights cLightManager has, no recompiling needed
+		for (uint i = 0; i < numDirLights; i++)
+		{
+			result += CalcDirLight(dirLights[i], albedo, norm, viewDir);
+		}
 		
-		for (int i = 0; i < NUM_POINT_LIGHTS; i++)
+		//Point and spot lights only from this fragment's cluster, as listed by cLightClusterPass,
+		//so the cost stays about the same however many lights the scene has
+		int cluster = getClusterIndex(FragPos);
+		uvec2 counts = clusterCounts[cluster];
+		uint first = uint(cluster) * uint(MAX_CLUSTER_LIGHTS);
+		for (uint i = 0; i < counts.y; i++)
 		{
-			result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);
+			result += CalcSpotLight(spotLights[clusterLightIndices[first + i]], albedo, norm, FragPos, viewDir);
 		}
 		
-		result += CalcSpotLight(spotLight, norm, FragPos, viewDir);
+		first += counts.y;
+		for (uint i = 0; i < counts.x; i++)
+		{
+			result += CalcPointLight(pointLights[clusterLightIndices[first + i]], albedo, norm, FragPos, viewDir);
+		}
 		
 		FragColor = vec4(result, 1.0);
 	}
@@ -124,7 +102,7 @@ void main()
 
 }
 
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
+vec3 CalcDirLight(DirLight light, vec3 albedo, vec3 normal, vec3 viewDir)
 {
 	vec3 lightDir = normalize(-light.direction);
 	//diffuse shading
@@ -133,15 +111,15 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
 	vec3 reflectDir = reflect(-lightDir, normal);
 	float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
 	//combine results
-	vec3 ambient = light.ambient * vec3(texture(material.texture_diffuse1, TexCoords));
-	vec3 diffuse = light.diffuse * diff * vec3(texture(material.texture_diffuse1, TexCoords));
+	vec3 ambient = light.ambient * albedo;
+	vec3 diffuse = light.diffuse * diff * albedo;
 	//vec3 specular = light.specular * spec * vec3(texture(material.texture_specular1, TexCoords));	
 	vec3 specular = vec3(0.0);
 	
 	return (ambient + diffuse + specular);
 }
 
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+vec3 CalcPointLight(PointLight light, vec3 albedo, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
 	vec3 lightDir = normalize(light.position - fragPos);
 	//diffuse shading
@@ -153,9 +131,10 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 	float distance = length(light.position - fragPos);
 	float attenuation = 1.0 / (light.constant + light.linear * distance + 
 						light.quadratic * (distance * distance));
+	attenuation *= CalcRangeFade(distance, light.radius);
 	//combine result
-	vec3 ambient = light.ambient * vec3(texture(material.texture_diffuse1, TexCoords));
-	vec3 diffuse = light.diffuse * diff * vec3(texture(material.texture_diffuse1, TexCoords));
+	vec3 ambient = light.ambient * albedo;
+	vec3 diffuse = light.diffuse * diff * albedo;
 	//vec3 specular = light.specular * spec * vec3(texture(material.texture_specular1, TexCoords));
 	vec3 specular = vec3(0.0);	
 	ambient *= attenuation;
@@ -165,7 +144,7 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 	return (ambient + diffuse + specular);
 }
 
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+vec3 CalcSpotLight(SpotLight light, vec3 albedo, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
 	vec3 lightDir = normalize(light.position - fragPos);
 	//diffuse shading
@@ -177,13 +156,14 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 	float distance = length(light.position - fragPos);
 	float attenuation = 1.0 / (light.constant + light.linear * distance + 
 						light.quadratic * (distance * distance));
+	attenuation *= CalcRangeFade(distance, light.radius);
 	//spotlight intensity
 	float theta = dot(lightDir, normalize(-light.direction));
 	float epsilon = light.cutOff - light.outerCutOff;
 	float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
 	
-	vec3 ambient = light.ambient * vec3(texture(material.texture_diffuse1, TexCoords));
-	vec3 diffuse = light.diffuse * diff * vec3(texture(material.texture_diffuse1, TexCoords));
+	vec3 ambient = light.ambient * albedo;
+	vec3 diffuse = light.diffuse * diff * albedo;
 	//vec3 specular = light.specular * spec * vec3(texture(material.texture_specular1, TexCoords));
 	vec3 specular = vec3(0.0);
 	ambient *= attenuation * intensity;
@@ -193,6 +173,14 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 	return (ambient + diffuse + specular);
 }
 
+//Takes the light the rest of the way to zero at its radius, so the cluster edges it's culled at don't show
+float CalcRangeFade(float distance, float radius)
+{
+	float ratio = distance / radius;
+	float fade = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+	return fade * fade;
+}
+
 float LinearizeDepth(float depth)
 {
 	float z = depth * 2.0 - 1.0; // back to NDC 
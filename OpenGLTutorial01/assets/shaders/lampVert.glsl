@@ -1,11 +1,12 @@
 #version 330 core
+
+#include "sharedUniforms.glsl"
+
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
 layout (location = 2) in vec2 aTexCoord;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 out vec3 vertexColor;
 out vec2 TexCoord;
@@ -13,7 +14,7 @@ out vec2 TexCoord;
 void main()
 {
 	//gl_Position = transform * vec4(aPos, 1.0);
-	gl_Position = projection * view * model * vec4(aPos, 1.0);
+	gl_Position = viewProjection * model * vec4(aPos, 1.0);
 	vertexColor = aColor;
 	TexCoord = aTexCoord;
 }
\ No newline at end of file
@@ -0,0 +1,107 @@
+#version 430
+
+// cLightClusterPass: one invocation per cluster, listing the point and spot lights whose spheres reach its box.
+// Runs straight after cSharedUniforms::setView, so ViewData is the camera it culls for
+layout (local_size_x = 64) in;
+
+#include "sharedUniforms.glsl"
+#include "lights.glsl"
+#include "clusters.glsl"
+
+// Read back by cLightClusterPass, laid out like sClusterOverflow, zeroed before every dispatch
+layout (std430, binding = 8) buffer ClusterOverflow
+{
+	uint overflowClusters;
+	uint overflowLights;
+	uint largestCluster;
+};
+
+// A batch of lights in view space, centre and radius. The group loads each light once between it,
+// instead of every cluster reading and transforming every light itself
+shared vec4 batchSpheres[64];
+
+bool sphereTouchesBox(vec4 sphere, vec3 boxMin, vec3 boxMax)
+{
+	vec3 offset = sphere.xyz - clamp(sphere.xyz, boxMin, boxMax);
+	return dot(offset, offset) <= sphere.w * sphere.w;
+}
+
+void main()
+{
+	int cluster = int(gl_GlobalInvocationID.x);
+	bool inGrid = cluster < CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+
+	// The cluster's view space box: the tile's four corner rays, cut at the slice's near and far depths
+	int tileX = cluster % CLUSTERS_X;
+	int tileY = (cluster / CLUSTERS_X) % CLUSTERS_Y;
+	int slice = cluster / (CLUSTERS_X * CLUSTERS_Y);
+	float clipNear = getClusterNear();
+	float sliceNear = getSliceDepth(slice);
+	float sliceFar = getSliceDepth(slice + 1);
+	mat4 inverseProjection = inverse(projection);
+	vec2 tileSize = vec2(2.0 / float(CLUSTERS_X), 2.0 / float(CLUSTERS_Y));
+	vec2 tileMin = vec2(-1.0) + vec2(tileX, tileY) * tileSize;
+	vec3 boxMin = vec3(1.0e30);
+	vec3 boxMax = vec3(-1.0e30);
+	for (int corner = 0; corner < 4; corner++)
+	{
+		vec2 ndc = tileMin + vec2(corner & 1, corner >> 1) * tileSize;
+		vec4 nearPoint = inverseProjection * vec4(ndc, -1.0, 1.0);
+		// On the near plane, so scaling it moves it along the ray to any other depth
+		vec3 ray = nearPoint.xyz / (nearPoint.w * clipNear);
+		boxMin = min(boxMin, min(ray * sliceNear, ray * sliceFar));
+		boxMax = max(boxMax, max(ray * sliceNear, ray * sliceFar));
+	}
+
+	uint first = uint(max(cluster, 0)) * uint(MAX_CLUSTER_LIGHTS);
+	uint numListed = 0u;
+	uint numSpotsListed = 0u;
+	// Every light reaching the box, including any there was no room to list
+	uint numReaching = 0u;
+
+	// Spot lights then point lights, so the list comes out spot lights first and a full cluster drops
+	// point lights rather than the fewer, brighter spots. Every invocation runs every batch, even off
+	// the end of the grid, because they all have to reach the barriers
+	uint numLights = numSpotLights + numPointLights;
+	for (uint batchStart = 0u; batchStart < numLights; batchStart += gl_WorkGroupSize.x)
+	{
+		uint light = batchStart + gl_LocalInvocationIndex;
+		if (light < numSpotLights)
+		{
+			batchSpheres[gl_LocalInvocationIndex] = vec4((view * vec4(spotLights[light].position, 1.0)).xyz, spotLights[light].radius);
+		}
+		else if (light < numLights)
+		{
+			uint point = light - numSpotLights;
+			batchSpheres[gl_LocalInvocationIndex] = vec4((view * vec4(pointLights[point].position, 1.0)).xyz, pointLights[point].radius);
+		}
+		barrier();
+
+		uint batchSize = min(gl_WorkGroupSize.x, numLights - batchStart);
+		for (uint index = 0u; inGrid && index < batchSize; index++)
+		{
+			if (!sphereTouchesBox(batchSpheres[index], boxMin, boxMax))
+				continue;
+			numReaching++;
+			if (numListed == uint(MAX_CLUSTER_LIGHTS))
+				continue;
+			uint lightIndex = batchStart + index;
+			bool isSpot = lightIndex < numSpotLights;
+			clusterLightIndices[first + numListed] = isSpot ? lightIndex : lightIndex - numSpotLights;
+			numListed++;
+			numSpotsListed += isSpot ? 1u : 0u;
+		}
+		barrier();
+	}
+
+	if (inGrid)
+	{
+		clusterCounts[cluster] = uvec2(numListed - numSpotsListed, numSpotsListed);
+		atomicMax(largestCluster, numReaching);
+		if (numReaching > numListed)
+		{
+			atomicAdd(overflowClusters, 1u);
+			atomicAdd(overflowLights, numReaching - numListed);
+		}
+	}
+}
@@ -0,0 +1,62 @@
+// Pulled in with #include "lights.glsl". Filled by cLightManager, one storage buffer per kind of light:
+// a count, then the lights back to back. std430, so each vec3 shares its 16 bytes with the float after it,
+// and the layouts have to stay the same as sDirectionalLight, sPointLight and sSpotLight
+struct DirLight
+{
+	vec3 direction;
+	float padding0;
+	vec3 ambient;
+	float padding1;
+	vec3 diffuse;
+	float padding2;
+	vec3 specular;
+	float padding3;
+};
+
+struct PointLight
+{
+	vec3 position;
+	float constant;
+	vec3 ambient;
+	float linear;
+	vec3 diffuse;
+	float quadratic;
+	vec3 specular;
+	float radius;		// past this it adds less than 1/256, so cLightClusterPass culls it
+};
+
+struct SpotLight
+{
+	vec3 position;
+	float constant;
+	vec3 direction;
+	float linear;
+	vec3 ambient;
+	float quadratic;
+	vec3 diffuse;
+	float cutOff;
+	vec3 specular;
+	float outerCutOff;
+	float radius;		// culled as the whole sphere, not just the cone
+	float padding0;
+	float padding1;
+	float padding2;
+};
+
+layout (std430, binding = 3) readonly buffer DirectionalLights
+{
+	uint numDirLights;
+	DirLight dirLights[];
+};
+
+layout (std430, binding = 4) readonly buffer PointLights
+{
+	uint numPointLights;
+	PointLight pointLights[];
+};
+
+layout (std430, binding = 5) readonly buffer SpotLights
+{
+	uint numSpotLights;
+	SpotLight spotLights[];
+};
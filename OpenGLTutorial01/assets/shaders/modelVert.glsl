@@ -1,4 +1,7 @@
 #version 330 core
+
+#include "sharedUniforms.glsl"
+
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
@@ -6,11 +9,22 @@ layout (location = 2) in vec2 aTexCoords;
 out vec2 TexCoords;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+//Set by cMesh for meshes using sCompactVertex: position and UV arrive as 0-1 inside the mesh bounds
+uniform bool compactVertices;
+uniform vec3 positionMin;
+uniform vec3 positionExtent;
+uniform vec2 texCoordMin;
+uniform vec2 texCoordExtent;
 
 void main()
 {
-    TexCoords = aTexCoords;    
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vec3 position = aPos;
+    TexCoords = aTexCoords;
+    if (compactVertices)
+    {
+        position = positionMin + aPos * positionExtent;
+        TexCoords = texCoordMin + aTexCoords * texCoordExtent;
+    }
+    gl_Position = viewProjection * model * vec4(position, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+#version 430
+
+// cSkinningPass: animVert.glsl's skinning done once a frame for every view, written out in world space
+// as sPreSkinnedVertex for the static vertex shaders to draw
+layout (local_size_x = 64) in;
+
+// sPackedSkinnedVertex, ten words each: position (3 floats), tangent frame (4 snorm16),
+// texture coordinates (2 floats), bone IDs (4 bytes), bone weights (4 unorm16)
+layout (std430, binding = 0) readonly buffer SourceVertices
+{
+	uint sourceWords[];
+};
+// sPreSkinnedVertex, twelve floats each: position, normal, texture coordinates, tangent and handedness
+layout (std430, binding = 1) writeonly buffer SkinnedVertices
+{
+	float skinnedFloats[];
+};
+// Every object's palette back to back
+layout (std430, binding = 2) readonly buffer BonePalettes
+{
+	mat4 bonePalettes[];
+};
+
+uniform mat4 model;
+uniform int paletteStart;
+uniform int numBonesUsed;
+uniform int numVertices;
+
+// Same as cVertexQuantizer::decodeTangentFrame
+void decodeTangentFrame(vec4 encoded, out vec3 normal, out vec3 tangent, out vec3 bitangent)
+{
+	vec4 q = normalize(encoded);
+	tangent = vec3(1.0 - 2.0 * (q.y * q.y + q.z * q.z), 2.0 * (q.x * q.y + q.w * q.z), 2.0 * (q.x * q.z - q.w * q.y));
+	normal = vec3(2.0 * (q.x * q.z + q.w * q.y), 2.0 * (q.y * q.z - q.w * q.x), 1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+	bitangent = cross(normal, tangent) * (encoded.w < 0.0 ? -1.0 : 1.0);
+}
+
+void main()
+{
+	int vertex = int(gl_GlobalInvocationID.x);
+	if (vertex >= numVertices)
+		return;
+
+	int word = vertex * 10;
+	vec3 position = uintBitsToFloat(uvec3(sourceWords[word], sourceWords[word + 1], sourceWords[word + 2]));
+	vec4 tangentFrame = vec4(unpackSnorm2x16(sourceWords[word + 3]), unpackSnorm2x16(sourceWords[word + 4]));
+	vec2 texCoord = uintBitsToFloat(uvec2(sourceWords[word + 5], sourceWords[word + 6]));
+	uint boneWord = sourceWords[word + 7];
+	ivec4 boneIDs = ivec4(boneWord & 0xffu, (boneWord >> 8) & 0xffu, (boneWord >> 16) & 0xffu, boneWord >> 24);
+	boneIDs = min(boneIDs, ivec4(numBonesUsed - 1)) + paletteStart;
+	vec4 boneWeights = vec4(unpackUnorm2x16(sourceWords[word + 8]), unpackUnorm2x16(sourceWords[word + 9]));
+
+	mat4 BoneTransform = bonePalettes[ boneIDs[0] ] * boneWeights[0];
+	BoneTransform += bonePalettes[ boneIDs[1] ] * boneWeights[1];
+	BoneTransform += bonePalettes[ boneIDs[2] ] * boneWeights[2];
+	BoneTransform += bonePalettes[ boneIDs[3] ] * boneWeights[3];
+	mat4 world = model * BoneTransform;
+
+	// Inverse transpose of the 3x3 keeps normals square to the surface under non uniform scale
+	mat3 matNormal = transpose(inverse(mat3(world)));
+
+	vec3 normal, tangent, bitangent;
+	decodeTangentFrame(tangentFrame, normal, tangent, bitangent);
+	vec3 worldPosition = (world * vec4(position, 1.0)).xyz;
+	vec3 worldNormal = normalize(matNormal * normal);
+	vec3 worldTangent = normalize(mat3(world) * tangent);
+
+	int first = vertex * 12;
+	skinnedFloats[first] = worldPosition.x;
+	skinnedFloats[first + 1] = worldPosition.y;
+	skinnedFloats[first + 2] = worldPosition.z;
+	skinnedFloats[first + 3] = worldNormal.x;
+	skinnedFloats[first + 4] = worldNormal.y;
+	skinnedFloats[first + 5] = worldNormal.z;
+	skinnedFloats[first + 6] = texCoord.x;
+	skinnedFloats[first + 7] = texCoord.y;
+	skinnedFloats[first + 8] = worldTangent.x;
+	skinnedFloats[first + 9] = worldTangent.y;
+	skinnedFloats[first + 10] = worldTangent.z;
+	skinnedFloats[first + 11] = tangentFrame.w < 0.0 ? -1.0 : 1.0;
+}
@@ -0,0 +1,16 @@
+// Pulled into the other shaders with #include "sharedUniforms.glsl" (cShader expands it), so it has no #version.
+// Filled by cSharedUniforms: FrameData once a frame, ViewData once per view. cShaderProgram binds both blocks
+// at link time; the layouts have to stay the same as sFrameUniforms and sViewUniforms
+layout (std140) uniform FrameData
+{
+	vec4 frameTiming;		// seconds since start, seconds since last frame
+	vec4 frameResolution;	// width, height, 1 / width, 1 / height
+};
+
+layout (std140) uniform ViewData
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition;	// w unused
+};
@@ -1,14 +1,16 @@
 #version 330 core
+
+#include "sharedUniforms.glsl"
+
 layout (location = 0) in vec3 aPos;
 
 out vec3 TexCoords;
 
-uniform mat4 projection;
-uniform mat4 view;
 
 void main()
 {
     TexCoords = aPos;
-    vec4 pos = projection * view * vec4(aPos, 1.0);
+    // Rotation only, so the box stays centred on the camera
+    vec4 pos = projection * mat4(mat3(view)) * vec4(aPos, 1.0);
 	gl_Position = pos.xyww;
 }  
\ No newline at end of file
@@ -1,12 +1,20 @@
 #version 450 core
+
+#include "sharedUniforms.glsl"
+
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform vec3 cameraPos;
+
+//Set by cMesh for meshes using sCompactVertex: position and UV arrive as 0-1 inside the mesh bounds,
+//the normal as an octahedral encoded xy pair
+uniform bool compactVertices;
+uniform vec3 positionMin;
+uniform vec3 positionExtent;
+uniform vec2 texCoordMin;
+uniform vec2 texCoordExtent;
 
 out vec3 FragPos;
 out vec3 Normal;
@@ -14,19 +22,40 @@ out vec2 TexCoords;
 out vec3 reflectedVector;
 out vec3 refractedVector;
 
+vec3 decodeNormal(vec2 encoded)
+{
+	vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	if (normal.z < 0.0)
+	{
+		vec2 signs = vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+		normal.xy = (1.0 - abs(normal.yx)) * signs;
+	}
+	return normalize(normal);
+}
+
 void main()
 {
-	vec3 worldPosition = vec3(model * vec4(aPos, 1.0));
-	gl_Position = projection * view * model * vec4(aPos, 1.0);
+	vec3 position = aPos;
+	vec3 normal = aNormal;
+	vec2 texCoord = aTexCoord;
+	if (compactVertices)
+	{
+		position = positionMin + aPos * positionExtent;
+		normal = decodeNormal(aNormal.xy);
+		texCoord = texCoordMin + aTexCoord * texCoordExtent;
+	}
+
+	vec3 worldPosition = vec3(model * vec4(position, 1.0));
+	gl_Position = viewProjection * vec4(worldPosition, 1.0);
 	FragPos = worldPosition;
 	//Inverse transpose removes the "translation" effects of transformation
 	//leaving only rotation and scale
-	vec3 outNormal = mat3(transpose(inverse(model))) * aNormal;
+	vec3 outNormal = mat3(transpose(inverse(model))) * normal;
 	Normal = outNormal;
-	vec4 reflectNormal = model * vec4(aNormal, 1.0);
-	TexCoords = aTexCoord;
+	vec4 reflectNormal = model * vec4(normal, 1.0);
+	TexCoords = texCoord;
 	
-	vec3 viewVector = normalize(worldPosition - cameraPos);
+	vec3 viewVector = normalize(worldPosition - cameraPosition.xyz);
 	
 	reflectedVector = reflect(viewVector, normalize(outNormal));
 	refractedVector = refract(viewVector, normalize(outNormal), 1.00/1.33);
@@ -0,0 +1,844 @@
+#include "cAnimationBenchmark.h"
+
+#include <chrono>
+#include <iostream>
+#include <cmath>
+
+#include "cSkinnedMesh.h"
+#include "cSkinnedMeshRegistry.h"
+#include "cAnimationInstance.h"
+#include "cAnimationClipLibrary.h"
+#include "cAnimationUpdater.h"
+#include "cPoseBatchSampler.h"
+#include "cBakedAnimation.h"
+#include "cClipCompressor.h"
+#include "cPoseCache.h"
+#include "cSkinnedGameObject.h"
+#include "cSkinningPass.h"
+#include "cVertexQuantizer.h"
+
+namespace
+{
+	const int NUM_ITERATIONS = 2000;
+
+	//Steps through the clip at an odd stride so consecutive calls don't land on the same keys
+	float benchmarkTime(int iteration, float durationSeconds)
+	{
+		return fmodf(iteration * 0.0137f, durationSeconds);
+	}
+
+	float largestDifference(const std::vector<glm::mat4>& first, const std::vector<glm::mat4>& second)
+	{
+		float largest = 0.0f;
+		for (int bone = 0; bone < first.size() && bone < second.size(); bone++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				glm::vec4 difference = glm::abs(first[bone][column] - second[bone][column]);
+				largest = glm::max(largest, glm::max(glm::max(difference.x, difference.y), glm::max(difference.z, difference.w)));
+			}
+		}
+		return largest;
+	}
+
+	//A spine with four limbs hanging off its top, five fingers on the end of each, every node a bone,
+	//and a clip that turns each one. Roughly the size of a game character, for timing crowds without a model on disk
+	const unsigned int NUM_LIMBS = 4;
+	const unsigned int NUM_LIMB_BONES = 4;
+	const unsigned int NUM_FINGERS = 5;
+	const unsigned int NUM_FINGER_BONES = 3;
+	const unsigned int NUM_SPINE_BONES = 4;
+	const unsigned int NUM_CLIP_KEYS = 31;
+
+	aiNode* makeSyntheticNode(const std::string& name, unsigned int numChildren)
+	{
+		aiNode* node = new aiNode(name);
+		node->mTransformation = aiMatrix4x4(aiVector3D(1.0f), aiQuaternion(), aiVector3D(0.0f, 0.1f, 0.0f));
+		node->mNumChildren = numChildren;
+		node->mChildren = numChildren > 0 ? new aiNode*[numChildren] : NULL;
+		return node;
+	}
+
+	aiNode* makeSyntheticSkeleton(std::vector<std::string>& nodeNames)
+	{
+		aiNode* root = makeSyntheticNode("spine0", 1);
+		nodeNames.push_back("spine0");
+		aiNode* parent = root;
+		for (unsigned int spine = 1; spine < NUM_SPINE_BONES; spine++)
+		{
+			std::string name = "spine" + std::to_string(spine);
+			aiNode* node = makeSyntheticNode(name, spine + 1 < NUM_SPINE_BONES ? 1 : NUM_LIMBS);
+			node->mParent = parent;
+			parent->mChildren[0] = node;
+			nodeNames.push_back(name);
+			parent = node;
+		}
+
+		aiNode* chest = parent;
+		for (unsigned int limb = 0; limb < NUM_LIMBS; limb++)
+		{
+			parent = chest;
+			for (unsigned int bone = 0; bone < NUM_LIMB_BONES; bone++)
+			{
+				std::string name = "limb" + std::to_string(limb) + "_" + std::to_string(bone);
+				aiNode* node = makeSyntheticNode(name, bone + 1 < NUM_LIMB_BONES ? 1 : NUM_FINGERS);
+				node->mParent = parent;
+				parent->mChildren[parent == chest ? limb : 0] = node;
+				nodeNames.push_back(name);
+				parent = node;
+			}
+
+			aiNode* hand = parent;
+			for (unsigned int finger = 0; finger < NUM_FINGERS; finger++)
+			{
+				parent = hand;
+				for (unsigned int bone = 0; bone < NUM_FINGER_BONES; bone++)
+				{
+					std::string name = "finger" + std::to_string(limb) + "_" + std::to_string(finger) + "_" + std::to_string(bone);
+					aiNode* node = makeSyntheticNode(name, bone + 1 < NUM_FINGER_BONES ? 1 : 0);
+					node->mParent = parent;
+					parent->mChildren[parent == hand ? finger : 0] = node;
+					nodeNames.push_back(name);
+					parent = node;
+				}
+			}
+		}
+		return root;
+	}
+
+	aiAnimation* makeSyntheticAnimation(const std::vector<std::string>& nodeNames)
+	{
+		aiAnimation* animation = new aiAnimation();
+		animation->mDuration = NUM_CLIP_KEYS - 1;
+		animation->mTicksPerSecond = 30.0;
+		animation->mNumChannels = (unsigned int)nodeNames.size();
+		animation->mChannels = new aiNodeAnim*[nodeNames.size()];
+		for (unsigned int channelIndex = 0; channelIndex < nodeNames.size(); channelIndex++)
+		{
+			aiNodeAnim* nodeAnim = new aiNodeAnim();
+			nodeAnim->mNodeName = aiString(nodeNames[channelIndex]);
+			nodeAnim->mNumPositionKeys = 1;
+			nodeAnim->mPositionKeys = new aiVectorKey[1];
+			nodeAnim->mPositionKeys[0] = aiVectorKey(0.0, aiVector3D(0.0f, 0.1f, 0.0f));
+			nodeAnim->mNumRotationKeys = NUM_CLIP_KEYS;
+			nodeAnim->mRotationKeys = new aiQuatKey[NUM_CLIP_KEYS];
+			for (unsigned int key = 0; key < NUM_CLIP_KEYS; key++)
+			{
+				//One full swing over the clip, so it loops without a jump like a real walk cycle does
+				float angle = sinf(key * glm::two_pi<float>() / (NUM_CLIP_KEYS - 1) + channelIndex) * 0.5f;
+				nodeAnim->mRotationKeys[key] = aiQuatKey(key, aiQuaternion(aiVector3D(0.0f, 0.0f, 1.0f), angle));
+			}
+			animation->mChannels[channelIndex] = nodeAnim;
+		}
+		return animation;
+	}
+
+	//The clip the way most exporters write one: every channel keyed on every frame, whether it moves or not
+	void keyEveryFrame(cAnimationClip& clip)
+	{
+		for (unsigned int channelIndex = 0; channelIndex < clip.channels.size(); channelIndex++)
+		{
+			sAnimationChannel& channel = clip.channels[channelIndex];
+			std::vector<float> times;
+			for (float time = 0.0f; time <= clip.duration; time += 1.0f)
+			{
+				times.push_back(time);
+			}
+			channel.positionValues.assign(times.size(), channel.positionValues[0]);
+			channel.positionTimes = times;
+			channel.scalingValues.assign(times.size(), channel.scalingValues[0]);
+			channel.scalingTimes = times;
+		}
+	}
+}
+
+int cAnimationBenchmark::run(const std::string& modelFile, const std::vector<std::string>& clipFiles)
+{
+	const unsigned int keyCounts[] = { 30, 300, 3000, 30000 };
+	for (int index = 0; index < sizeof(keyCounts) / sizeof(keyCounts[0]); index++)
+	{
+		benchmarkKeySearch(keyCounts[index]);
+	}
+
+	benchmarkUniforms(10000);
+
+	std::vector<std::string> nodeNames;
+	aiNode* syntheticRoot = makeSyntheticSkeleton(nodeNames);
+	aiAnimation* syntheticAnimation = makeSyntheticAnimation(nodeNames);
+	std::map<std::string, unsigned int> boneNameToIndex;
+	for (unsigned int nodeIndex = 0; nodeIndex < nodeNames.size(); nodeIndex++)
+	{
+		boneNameToIndex[nodeNames[nodeIndex]] = nodeIndex;
+	}
+	cSkeleton syntheticSkeleton;
+	syntheticSkeleton.build(syntheticRoot, boneNameToIndex, std::vector<glm::mat4>(nodeNames.size(), glm::mat4(1.0f)));
+	cAnimationClip syntheticClip(syntheticAnimation, "synthetic crowd");
+	sClipBinding syntheticBinding;
+	syntheticSkeleton.bindClip(&syntheticClip, syntheticBinding);
+	delete syntheticAnimation;
+	delete syntheticRoot;
+
+	const unsigned int crowdSizes[] = { 1, 100, 1000 };
+	for (int index = 0; index < sizeof(crowdSizes) / sizeof(crowdSizes[0]); index++)
+	{
+		benchmarkCrowd(syntheticSkeleton, syntheticBinding, crowdSizes[index]);
+	}
+
+	sPoseSamplerError samplerError = cPoseBatchSampler::measureError(100000);
+	std::cout << "Batched sampler (" << cPoseBatchSampler::getInstructionSet() << "): largest difference from slerp "
+		<< samplerError.maxReferenceError << " (tolerance " << samplerError.referenceTolerance << "), SIMD against scalar "
+		<< samplerError.maxScalarDifference << " (tolerance " << samplerError.scalarTolerance << ") "
+		<< (samplerError.withinTolerance() ? "OK" : "FAILED") << std::endl;
+	for (int index = 0; index < sizeof(crowdSizes) / sizeof(crowdSizes[0]); index++)
+	{
+		benchmarkBatchSampling(syntheticSkeleton, syntheticBinding, crowdSizes[index]);
+	}
+	benchmarkLod(syntheticSkeleton, syntheticBinding, 1000);
+	benchmarkPoseCache(syntheticSkeleton, syntheticBinding, 1000, 20, 0.0f);
+	benchmarkPoseCache(syntheticSkeleton, syntheticBinding, 1000, 20, 1.0f / 60.0f);
+	benchmarkPoseCache(syntheticSkeleton, syntheticBinding, 1000, 1000, 1.0f / 60.0f);
+	benchmarkPoseCache(syntheticSkeleton, syntheticBinding, 1000, 1000, 1.0f / 15.0f);
+	benchmarkBaking(syntheticSkeleton, syntheticBinding);
+	benchmarkCompression(syntheticSkeleton, syntheticBinding);
+	cAnimationClip exportedClip = syntheticClip;
+	exportedClip.name = "synthetic crowd, keyed every frame";
+	keyEveryFrame(exportedClip);
+	sClipBinding exportedBinding;
+	syntheticSkeleton.bindClip(&exportedClip, exportedBinding);
+	benchmarkCompression(syntheticSkeleton, exportedBinding);
+
+	if (modelFile.empty())
+		return 0;
+
+	cSkinnedMeshRegistry& registry = cSkinnedMeshRegistry::getInstance();
+	cSkinnedMesh& mesh = *registry.acquire(modelFile);
+	if (!mesh.Scene)
+	{
+		std::cout << "Could not load " << modelFile << std::endl;
+		registry.release(&mesh);
+		return 1;
+	}
+	std::cout << modelFile << ": " << mesh.NumBones << " bones, " << mesh.Skeleton.getNumNodes() << " skeleton nodes, loaded in "
+		<< mesh.LoadTimeMs << " ms" << std::endl;
+	benchmarkSharedInstances(modelFile, 100);
+	benchmarkPreSkinning(modelFile, 100);
+	if (mesh.DefaultClip.clip)
+	{
+		for (int index = 0; index < sizeof(crowdSizes) / sizeof(crowdSizes[0]); index++)
+		{
+			benchmarkCrowd(mesh.Skeleton, mesh.DefaultClip, crowdSizes[index]);
+		}
+	}
+
+	if (mesh.DefaultClip.clip)
+	{
+		benchmarkClipBinding(mesh, modelFile, mesh.Scene->mAnimations[0]);
+	}
+	for (int index = 0; index < clipFiles.size(); index++)
+	{
+		if (!mesh.LoadMeshAnimation(clipFiles[index]))
+		{
+			std::cout << "Could not load " << clipFiles[index] << std::endl;
+			continue;
+		}
+		//The library has already thrown its scene away, so the reference path gets its own copy
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(clipFiles[index].c_str(), 0);
+		benchmarkClipBinding(mesh, clipFiles[index], scene ? scene->mAnimations[0] : NULL);
+	}
+	if (mesh.DefaultClip.clip)
+	{
+		benchmarkCompression(mesh.Skeleton, mesh.DefaultClip);
+	}
+	std::map<std::string, sClipBinding>::const_iterator itClip = mesh.MapAnimationNameToClip.begin();
+	for (itClip; itClip != mesh.MapAnimationNameToClip.end(); itClip++)
+	{
+		benchmarkCompression(mesh.Skeleton, itClip->second);
+	}
+	cAnimationClipLibrary::getInstance().printReport();
+	{
+		cBakedAnimation baked(&mesh);
+		baked.printReport();
+	}
+
+	registry.release(&mesh);
+	return 0;
+}
+
+void cAnimationBenchmark::benchmarkSharedInstances(const std::string& modelFile, unsigned int numInstances)
+{
+	cSkinnedMeshRegistry& registry = cSkinnedMeshRegistry::getInstance();
+	std::vector<cSkinnedMesh*> meshes;
+	std::vector<cAnimationInstance*> instances;
+
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+	for (unsigned int index = 0; index < numInstances; index++)
+	{
+		meshes.push_back(registry.acquire(modelFile));
+		instances.push_back(new cAnimationInstance(meshes.back()));
+	}
+	std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+	std::cout << numInstances << " more instances of " << modelFile << " in " << elapsed.count() << " ms" << std::endl;
+	registry.printReport();
+
+	for (unsigned int index = 0; index < numInstances; index++)
+	{
+		delete instances[index];
+		registry.release(meshes[index]);
+	}
+}
+
+void cAnimationBenchmark::benchmarkUniforms(unsigned int numDraws)
+{
+	const int numBones = 64;
+	cShaderProgram program;
+	program.compileProgram("assets/shaders/", "animVert.glsl", "animFrag.glsl");
+	program.useProgram();
+	std::vector<glm::mat4> palette(numBones, glm::mat4(1.0f));
+	glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+
+	//What every set function did before the table: a glGetUniformLocation per call
+	glFinish();
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+	for (unsigned int draw = 0; draw < numDraws; draw++)
+	{
+		glUniform1i(glGetUniformLocation(program.ID, "numBonesUsed"), numBones);
+		glUniformMatrix4fv(glGetUniformLocation(program.ID, "bones"), numBones, GL_FALSE, glm::value_ptr(palette[0]));
+		glUniformMatrix4fv(glGetUniformLocation(program.ID, "model"), 1, GL_FALSE, glm::value_ptr(model));
+	}
+	glFinish();
+	std::chrono::duration<float, std::micro> queried = std::chrono::high_resolution_clock::now() - startTime;
+
+	startTime = std::chrono::high_resolution_clock::now();
+	for (unsigned int draw = 0; draw < numDraws; draw++)
+	{
+		program.setInt("numBonesUsed", numBones);
+		program.setMat4("bones", numBones, palette[0]);
+		program.setMat4("model", model);
+	}
+	glFinish();
+	std::chrono::duration<float, std::micro> byName = std::chrono::high_resolution_clock::now() - startTime;
+
+	sUniform<int> numBonesUsedUniform = program.getUniform<int>("numBonesUsed");
+	sUniform<glm::mat4> bonesUniform = program.getUniform<glm::mat4>("bones");
+	sUniform<glm::mat4> modelUniform = program.getUniform<glm::mat4>("model");
+	startTime = std::chrono::high_resolution_clock::now();
+	for (unsigned int draw = 0; draw < numDraws; draw++)
+	{
+		numBonesUsedUniform.set(numBones);
+		bonesUniform.setArray(palette.data(), numBones);
+		modelUniform.set(model);
+	}
+	glFinish();
+	std::chrono::duration<float, std::micro> byHandle = std::chrono::high_resolution_clock::now() - startTime;
+
+	std::cout << "Uniforms for one skinned draw (" << numBones << " bones), over " << numDraws << " draws: glGetUniformLocation every time "
+		<< queried.count() / numDraws << " us, by name " << byName.count() / numDraws << " us, through sUniform "
+		<< byHandle.count() / numDraws << " us per draw" << std::endl;
+
+	glUseProgram(0);
+	glDeleteProgram(program.ID);
+}
+
+void cAnimationBenchmark::benchmarkPreSkinning(const std::string& modelFile, unsigned int numObjects)
+{
+	const int numFrames = 60;
+
+	//Spread out, turned and scaled differently, so the model and normal matrices are part of what's checked
+	std::vector<cSkinnedGameObject*> objects;
+	for (unsigned int index = 0; index < numObjects; index++)
+	{
+		glm::vec3 position((float)(index % 10) * 3.0f, 0.0f, (float)(index / 10) * 3.0f);
+		glm::vec3 scale(1.0f + (index % 3) * 0.25f, 1.0f, 1.0f + (index % 5) * 0.1f);
+		objects.push_back(new cSkinnedGameObject(modelFile, modelFile, position, scale, glm::vec3(0.0f, index * 0.37f, 0.0f)));
+		//The mesh's own animation, which runs off defaultAnimState
+		objects.back()->animToPlay = modelFile;
+		objects.back()->LodTiers.clear();
+		for (unsigned int step = 0; step <= index % 7; step++)
+		{
+			objects.back()->Update(glm::vec3(0.0f));
+		}
+	}
+
+	cSkinningPass pass;
+	pass.skin(objects);
+	glFinish();
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		pass.skin(objects);
+	}
+	glFinish();
+	std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+	//Reads every object's output back and skins the same vertices here the way animVert.glsl does
+	float largestPosition = 0.0f;
+	float largestNormal = 0.0f;
+	std::vector<sPreSkinnedVertex> skinned;
+	for (unsigned int index = 0; index < numObjects; index++)
+	{
+		cSkinnedGameObject* object = objects[index];
+		cSkinnedMesh* mesh = object->GetMesh();
+		const std::vector<glm::mat4>& palette = object->GetBonePalette();
+		glm::mat4 model = object->GetModelMatrix();
+		for (unsigned int subMesh = 0; subMesh < mesh->GetNumMeshes() && !palette.empty(); subMesh++)
+		{
+			const std::vector<sPackedSkinnedVertex>& source = mesh->GetSubMesh(subMesh).skinnedVertices;
+			skinned.resize(source.size());
+			glBindBuffer(GL_ARRAY_BUFFER, object->PreSkinnedVertices->GetVertexBuffer(subMesh));
+			glGetBufferSubData(GL_ARRAY_BUFFER, 0, skinned.size() * sizeof(sPreSkinnedVertex), skinned.data());
+			for (unsigned int vertex = 0; vertex < source.size(); vertex++)
+			{
+				glm::mat4 boneTransform(0.0f);
+				for (int influence = 0; influence < 4; influence++)
+				{
+					unsigned int bone = glm::min((unsigned int)source[vertex].BoneID[influence], (unsigned int)palette.size() - 1);
+					boneTransform += palette[bone] * (source[vertex].BoneWeights[influence] / 65535.0f);
+				}
+				glm::mat4 world = model * boneTransform;
+				glm::vec3 normal, tangent, bitangent;
+				cVertexQuantizer::decodeTangentFrame(source[vertex].TangentFrame, normal, tangent, bitangent);
+				glm::vec3 position = glm::vec3(world * glm::vec4(source[vertex].Position, 1.0f));
+				normal = glm::normalize(glm::transpose(glm::inverse(glm::mat3(world))) * normal);
+
+				largestPosition = glm::max(largestPosition, glm::distance(position, skinned[vertex].Position));
+				largestNormal = glm::max(largestNormal, glm::distance(normal, skinned[vertex].Normal));
+			}
+		}
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	std::cout << "Pre-skinned " << pass.lastObjects << " objects (" << pass.lastVertices << " vertices, " << pass.lastDispatches
+		<< " dispatches) in " << elapsed.count() / numFrames << " ms per frame, once for every view. Largest difference from the CPU: position "
+		<< largestPosition << ", normal " << largestNormal << std::endl;
+
+	for (unsigned int index = 0; index < numObjects; index++)
+	{
+		delete objects[index];
+	}
+}
+
+void cAnimationBenchmark::benchmarkCrowd(const cSkeleton& skeleton, const sClipBinding& binding, unsigned int numInstances)
+{
+	const int numFrames = 60;
+	float durationSeconds = binding.clip->duration / binding.clip->ticksPerSecond;
+
+	std::vector<sSkeletonPose> poses(numInstances);
+	for (unsigned int instance = 0; instance < numInstances; instance++)
+	{
+		skeleton.allocatePose(poses[instance]);
+	}
+
+	//Every instance a little out of step with the others, like a crowd that didn't all spawn on the same frame
+	std::function<void(int, unsigned int, unsigned int)> evaluateRange = [&](int frame, unsigned int begin, unsigned int end)
+	{
+		for (unsigned int instance = begin; instance < end; instance++)
+		{
+			float seconds = fmodf(frame / 60.0f + instance * 0.031f, durationSeconds);
+			skeleton.evaluate(binding, binding.clip->getAnimationTime(seconds), poses[instance]);
+		}
+	};
+
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		evaluateRange(frame, 0, numInstances);
+	}
+	std::chrono::duration<float, std::milli> serialElapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+	cAnimationUpdater updater;
+	startTime = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		updater.parallelFor(numInstances, [&evaluateRange, frame](unsigned int begin, unsigned int end)
+		{
+			evaluateRange(frame, begin, end);
+		});
+	}
+	std::chrono::duration<float, std::milli> parallelElapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+	std::cout << numInstances << " instances of " << skeleton.getNumBones() << " bones: one thread " << serialElapsed.count() / numFrames
+		<< " ms, " << updater.getNumThreads() << " threads " << parallelElapsed.count() / numFrames << " ms per frame ("
+		<< serialElapsed.count() / parallelElapsed.count() << "x)" << std::endl;
+}
+
+void cAnimationBenchmark::benchmarkBatchSampling(const cSkeleton& skeleton, const sClipBinding& binding, unsigned int numInstances)
+{
+	const int numFrames = 60;
+	float durationSeconds = binding.clip->duration / binding.clip->ticksPerSecond;
+
+	std::vector<sSkeletonPose> poses(numInstances), batchPoses(numInstances);
+	std::vector<sSkeletonPose*> batchPosePointers(numInstances);
+	std::vector<float> animationTimes(numInstances);
+	for (unsigned int instance = 0; instance < numInstances; instance++)
+	{
+		skeleton.allocatePose(poses[instance]);
+		skeleton.allocatePose(batchPoses[instance]);
+		batchPosePointers[instance] = &batchPoses[instance];
+	}
+
+	cPoseBatchSampler sampler;
+	std::chrono::duration<float, std::milli> serialElapsed(0.0f), batchElapsed(0.0f), scalarElapsed(0.0f);
+	float largest = 0.0f;
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		for (unsigned int instance = 0; instance < numInstances; instance++)
+		{
+			animationTimes[instance] = binding.clip->getAnimationTime(fmodf(frame / 60.0f + instance * 0.031f, durationSeconds));
+		}
+
+		std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+		for (unsigned int instance = 0; instance < numInstances; instance++)
+		{
+			skeleton.evaluate(binding, animationTimes[instance], poses[instance]);
+		}
+		serialElapsed += std::chrono::high_resolution_clock::now() - startTime;
+
+		sampler.useSimd = false;
+		startTime = std::chrono::high_resolution_clock::now();
+		sampler.evaluate(skeleton, binding, animationTimes.data(), batchPosePointers.data(), numInstances);
+		scalarElapsed += std::chrono::high_resolution_clock::now() - startTime;
+
+		sampler.useSimd = true;
+		startTime = std::chrono::high_resolution_clock::now();
+		sampler.evaluate(skeleton, binding, animationTimes.data(), batchPosePointers.data(), numInstances);
+		batchElapsed += std::chrono::high_resolution_clock::now() - startTime;
+	}
+	for (unsigned int instance = 0; instance < numInstances; instance++)
+	{
+		largest = glm::max(largest, largestDifference(poses[instance].palette, batchPoses[instance].palette));
+	}
+
+	std::cout << numInstances << " instances: one at a time " << serialElapsed.count() / numFrames << " ms, batched scalar "
+		<< scalarElapsed.count() / numFrames << " ms, batched " << cPoseBatchSampler::getInstructionSet() << " "
+		<< batchElapsed.count() / numFrames << " ms per frame (" << serialElapsed.count() / batchElapsed.count()
+		<< "x), largest palette difference " << largest << std::endl;
+}
+
+void cAnimationBenchmark::benchmarkLod(const cSkeleton& skeleton, const sClipBinding& binding, unsigned int numInstances)
+{
+	const int numFrames = 240;
+	const float stepSeconds = 1.0f / 60.0f;
+	float durationSeconds = binding.clip->duration / binding.clip->ticksPerSecond;
+	std::vector<sAnimationLodTier> tiers = cAnimationInstance::getDefaultLodTiers();
+
+	//A crowd spread evenly out to 100 units from the camera, half again past the last tier boundary
+	std::vector<cAnimationInstance*> fullInstances, lodInstances;
+	std::vector<unsigned int> instanceTiers;
+	std::vector<unsigned int> numPerTier(tiers.size(), 0);
+	for (unsigned int instance = 0; instance < numInstances; instance++)
+	{
+		fullInstances.push_back(new cAnimationInstance(&skeleton, &binding));
+		lodInstances.push_back(new cAnimationInstance(&skeleton, &binding));
+		instanceTiers.push_back(cAnimationInstance::selectLodTier(tiers, 100.0f * instance / numInstances, 1.0f, 0));
+		numPerTier[instanceTiers.back()]++;
+	}
+
+	std::chrono::duration<float, std::milli> fullElapsed(0.0f), lodElapsed(0.0f);
+	//Worst gap between the blended and the true palette, per tier. Only tiers that keep every bone are compared,
+	//the last one moves the fingers to their bind pose on purpose
+	std::vector<float> largestPerTier(tiers.size(), 0.0f);
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+		for (unsigned int instance = 0; instance < numInstances; instance++)
+		{
+			fullInstances[instance]->evaluate(fmodf(frame * stepSeconds + instance * 0.031f, durationSeconds));
+		}
+		fullElapsed += std::chrono::high_resolution_clock::now() - startTime;
+
+		startTime = std::chrono::high_resolution_clock::now();
+		for (unsigned int instance = 0; instance < numInstances; instance++)
+		{
+			const sAnimationLodTier& tier = tiers[instanceTiers[instance]];
+			lodInstances[instance]->evaluateLod(fmodf(frame * stepSeconds + instance * 0.031f, durationSeconds), stepSeconds,
+				tier.updateInterval, tier.skipDetailNodes);
+		}
+		lodElapsed += std::chrono::high_resolution_clock::now() - startTime;
+
+		for (unsigned int instance = 0; instance < numInstances; instance++)
+		{
+			unsigned int tier = instanceTiers[instance];
+			if (!tiers[tier].skipDetailNodes)
+			{
+				float difference = largestDifference(fullInstances[instance]->pose.palette, lodInstances[instance]->pose.palette);
+				largestPerTier[tier] = glm::max(largestPerTier[tier], difference);
+			}
+		}
+	}
+
+	std::cout << numInstances << " instances with level of detail: every frame " << fullElapsed.count() / numFrames << " ms, tiered "
+		<< lodElapsed.count() / numFrames << " ms per frame (" << fullElapsed.count() / lodElapsed.count() << "x)" << std::endl;
+	for (unsigned int tier = 0; tier < tiers.size(); tier++)
+	{
+		std::cout << "  tier " << tier << ": " << numPerTier[tier] << " instances, every " << tiers[tier].updateInterval << " frames"
+			<< (tiers[tier].skipDetailNodes ? ", detail bones skipped" : "");
+		if (!tiers[tier].skipDetailNodes)
+			std::cout << ", largest palette difference from every frame " << largestPerTier[tier];
+		std::cout << std::endl;
+	}
+
+	//One character walking slowly back and forth over the boundary into the tier without fingers, jittering a little as
+	//it goes. Counts how often it changes tier (two per pass is the least possible) and the biggest jump in its palette
+	//from one frame to the next
+	cAnimationInstance pacing(&skeleton, &binding);
+	std::vector<glm::mat4> lastPalette;
+	unsigned int pacingTier = 0;
+	unsigned int tierChanges = 0;
+	float largestJump = 0.0f;
+	float boundary = tiers.size() > 1 ? tiers[tiers.size() - 2].maxDistance : 0.0f;
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		float distance = boundary * 1.05f + (boundary * 0.05f + 1.0f) * sinf(frame * 0.05f) + 0.3f * sinf(frame * 2.5f);
+		unsigned int tier = cAnimationInstance::selectLodTier(tiers, distance, 1.0f, pacingTier);
+		tierChanges += tier != pacingTier && frame > 0 ? 1 : 0;
+		pacingTier = tier;
+		pacing.evaluateLod(fmodf(frame * stepSeconds, durationSeconds), stepSeconds, tiers[tier].updateInterval, tiers[tier].skipDetailNodes);
+		if (!lastPalette.empty())
+			largestJump = glm::max(largestJump, largestDifference(lastPalette, pacing.pose.palette));
+		lastPalette = pacing.pose.palette;
+	}
+	std::cout << "  walking over the " << boundary << " unit boundary: " << tierChanges << " tier changes in " << numFrames
+		<< " frames, largest palette change between frames " << largestJump << std::endl;
+
+	for (unsigned int instance = 0; instance < numInstances; instance++)
+	{
+		delete fullInstances[instance];
+		delete lodInstances[instance];
+	}
+}
+
+void cAnimationBenchmark::benchmarkPoseCache(const cSkeleton& skeleton, const sClipBinding& binding, unsigned int numInstances, unsigned int numGroups, float quantumSeconds)
+{
+	const int numFrames = 60;
+	const float stepSeconds = 1.0f / 60.0f;
+	float durationSeconds = binding.clip->duration / binding.clip->ticksPerSecond;
+
+	std::vector<cAnimationInstance*> instances, cachedInstances;
+	std::vector<float> phases;
+	for (unsigned int instance = 0; instance < numInstances; instance++)
+	{
+		instances.push_back(new cAnimationInstance(&skeleton, &binding));
+		cachedInstances.push_back(new cAnimationInstance(&skeleton, &binding));
+		phases.push_back((instance % numGroups) * 0.031f);
+	}
+
+	cPoseCache poseCache(quantumSeconds);
+	std::chrono::duration<float, std::milli> elapsed(0.0f), cachedElapsed(0.0f);
+	float largest = 0.0f;
+	for (int frame = 0; frame < numFrames; frame++)
+	{
+		std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+		for (unsigned int instance = 0; instance < numInstances; instance++)
+		{
+			instances[instance]->evaluate(fmodf(frame * stepSeconds + phases[instance], durationSeconds));
+		}
+		elapsed += std::chrono::high_resolution_clock::now() - startTime;
+
+		startTime = std::chrono::high_resolution_clock::now();
+		poseCache.beginFrame();
+		for (unsigned int instance = 0; instance < numInstances; instance++)
+		{
+			cachedInstances[instance]->evaluate(fmodf(frame * stepSeconds + phases[instance], durationSeconds), false, &poseCache);
+		}
+		cachedElapsed += std::chrono::high_resolution_clock::now() - startTime;
+
+		for (unsigned int instance = 0; instance < numInstances; instance++)
+		{
+			largest = glm::max(largest, largestDifference(instances[instance]->pose.palette, cachedInstances[instance]->pose.palette));
+		}
+	}
+
+	std::cout << numInstances << " instances in " << numGroups << " groups, " << quantumSeconds * 1000.0f << " ms buckets: "
+		<< elapsed.count() / numFrames << " ms uncached, " << cachedElapsed.count() / numFrames << " ms cached per frame ("
+		<< elapsed.count() / cachedElapsed.count() << "x), largest palette difference " << largest << std::endl << "  ";
+	poseCache.printReport();
+
+	for (unsigned int instance = 0; instance < numInstances; instance++)
+	{
+		delete instances[instance];
+		delete cachedInstances[instance];
+	}
+}
+
+void cAnimationBenchmark::benchmarkCompression(const cSkeleton& skeleton, const sClipBinding& binding)
+{
+	cAnimationClip compressedClip = *binding.clip;
+	sClipCompressionReport report = cClipCompressor::compress(compressedClip);
+	cClipCompressor::printReport(compressedClip, report);
+	sClipBinding compressedBinding;
+	skeleton.bindClip(&compressedClip, compressedBinding);
+
+	float durationSeconds = binding.clip->duration / binding.clip->ticksPerSecond;
+	sSkeletonPose pose, compressedPose;
+	skeleton.allocatePose(pose);
+	skeleton.allocatePose(compressedPose);
+
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+	for (int iteration = 0; iteration < NUM_ITERATIONS; iteration++)
+	{
+		skeleton.evaluate(binding, binding.clip->getAnimationTime(benchmarkTime(iteration, durationSeconds)), pose);
+	}
+	std::chrono::duration<float, std::micro> rawElapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+	startTime = std::chrono::high_resolution_clock::now();
+	for (int iteration = 0; iteration < NUM_ITERATIONS; iteration++)
+	{
+		skeleton.evaluate(compressedBinding, compressedClip.getAnimationTime(benchmarkTime(iteration, durationSeconds)), compressedPose);
+	}
+	std::chrono::duration<float, std::micro> compressedElapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+	float largest = 0.0f;
+	for (int iteration = 0; iteration < NUM_ITERATIONS; iteration++)
+	{
+		float animationTime = binding.clip->getAnimationTime(benchmarkTime(iteration, durationSeconds));
+		skeleton.evaluate(binding, animationTime, pose);
+		skeleton.evaluate(compressedBinding, animationTime, compressedPose);
+		largest = glm::max(largest, largestDifference(pose.palette, compressedPose.palette));
+	}
+
+	std::cout << "  pose " << rawElapsed.count() / NUM_ITERATIONS << " us as loaded, " << compressedElapsed.count() / NUM_ITERATIONS
+		<< " us compressed, largest palette difference " << largest << std::endl;
+}
+
+void cAnimationBenchmark::benchmarkBaking(const cSkeleton& skeleton, const sClipBinding& binding)
+{
+	const float framesPerSecond[] = { 15.0f, 30.0f, 60.0f };
+	for (int index = 0; index < sizeof(framesPerSecond) / sizeof(framesPerSecond[0]); index++)
+	{
+		std::vector<float> rows;
+		sBakedClip baked;
+		std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+		cBakedAnimation::bakeClip(skeleton, binding, framesPerSecond[index], rows, baked);
+		std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+		std::cout << "Baked " << skeleton.getNumBones() << " bones at " << framesPerSecond[index] << " fps: " << baked.numFrames
+			<< " frames, " << baked.bytes / 1024 << " KB, baked and checked in " << elapsed.count() << " ms, largest palette error "
+			<< baked.maxError << std::endl;
+	}
+}
+
+void cAnimationBenchmark::benchmarkClipBinding(cSkinnedMesh& mesh, const std::string& animationName, const aiAnimation* sceneAnimation)
+{
+	const sClipBinding& binding = mesh.FindClip(animationName);
+	if (!binding.clip || !sceneAnimation)
+	{
+		std::cout << animationName << ": no animation to benchmark" << std::endl;
+		return;
+	}
+	float durationSeconds = binding.clip->duration / binding.clip->ticksPerSecond;
+
+	std::vector<glm::mat4> finalTransforms, globals, offsets;
+	std::vector<glm::mat4> referenceTransforms;
+
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+	for (int iteration = 0; iteration < NUM_ITERATIONS; iteration++)
+	{
+		mesh.BoneTransformFromScene(benchmarkTime(iteration, durationSeconds), sceneAnimation, referenceTransforms, globals, offsets);
+	}
+	std::chrono::duration<float, std::micro> sceneElapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+	startTime = std::chrono::high_resolution_clock::now();
+	for (int iteration = 0; iteration < NUM_ITERATIONS; iteration++)
+	{
+		mesh.BoneTransform(benchmarkTime(iteration, durationSeconds), binding, finalTransforms, globals, offsets);
+	}
+	std::chrono::duration<float, std::micro> compiledElapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+	//What game objects do: evaluate straight into a pose they own, with no copies out
+	sSkeletonPose pose;
+	mesh.Skeleton.allocatePose(pose);
+	startTime = std::chrono::high_resolution_clock::now();
+	for (int iteration = 0; iteration < NUM_ITERATIONS; iteration++)
+	{
+		mesh.EvaluatePose(benchmarkTime(iteration, durationSeconds), binding, pose);
+	}
+	std::chrono::duration<float, std::micro> poseElapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+	float numBones = (float)mesh.NumBones * NUM_ITERATIONS;
+	std::cout << animationName << ": aiScene path " << numBones / sceneElapsed.count() << " bones/us, compiled clip "
+		<< numBones / compiledElapsed.count() << " bones/us (" << sceneElapsed.count() / compiledElapsed.count() << "x), into caller pose "
+		<< numBones / poseElapsed.count() << " bones/us (" << sceneElapsed.count() / poseElapsed.count() << "x)";
+
+	float time = benchmarkTime(NUM_ITERATIONS / 3, durationSeconds);
+	mesh.BoneTransformFromScene(time, sceneAnimation, referenceTransforms, globals, offsets);
+	mesh.BoneTransform(time, binding, finalTransforms, globals, offsets);
+	std::cout << ", largest difference " << largestDifference(referenceTransforms, finalTransforms) << std::endl;
+}
+
+void cAnimationBenchmark::benchmarkKeySearch(unsigned int numKeys)
+{
+	//One channel with a key every tick, the same layout a baked clip from a DCC tool has
+	aiAnimation animation;
+	animation.mDuration = numKeys - 1;
+	animation.mTicksPerSecond = 30.0;
+	animation.mNumChannels = 1;
+	animation.mChannels = new aiNodeAnim*[1];
+	aiNodeAnim* nodeAnim = new aiNodeAnim();
+	animation.mChannels[0] = nodeAnim;
+	nodeAnim->mNumRotationKeys = numKeys;
+	nodeAnim->mRotationKeys = new aiQuatKey[numKeys];
+	for (unsigned int key = 0; key < numKeys; key++)
+	{
+		nodeAnim->mRotationKeys[key].mTime = key;
+		nodeAnim->mRotationKeys[key].mValue = aiQuaternion(aiVector3D(0.0f, 1.0f, 0.0f), key * 0.01f);
+	}
+
+	cAnimationClip clip(&animation, "synthetic");
+	cAnimationClip uniformClip(&animation, "synthetic uniform");
+	uniformClip.resampleUniform(1.0f);
+	const std::vector<float>& times = clip.channels[0].rotationTimes;
+	const std::vector<float>& uniformTimes = uniformClip.channels[0].rotationTimes;
+
+	//Forward playback at 60 frames a second, looping, like a game object would drive it
+	const int numLookups = 200000;
+	float step = clip.ticksPerSecond / 60.0f;
+	float factor;
+	unsigned int checksum = 0;
+
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+	for (int lookup = 0; lookup < numLookups; lookup++)
+	{
+		//What cSkinnedMesh::FindRotation does on the aiNodeAnim
+		float time = fmodf(lookup * step, clip.duration);
+		unsigned int key = 0;
+		for (unsigned int index = 0; index != numKeys - 1; index++)
+		{
+			if (time < times[index + 1])
+			{
+				key = index;
+				break;
+			}
+		}
+		checksum += key;
+	}
+	std::chrono::duration<float, std::nano> linearElapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+	startTime = std::chrono::high_resolution_clock::now();
+	for (int lookup = 0; lookup < numLookups; lookup++)
+	{
+		checksum += clip.findKey(times, fmodf(lookup * step, clip.duration), NULL, factor);
+	}
+	std::chrono::duration<float, std::nano> binaryElapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+	unsigned int cursor = 0;
+	startTime = std::chrono::high_resolution_clock::now();
+	for (int lookup = 0; lookup < numLookups; lookup++)
+	{
+		checksum += clip.findKey(times, fmodf(lookup * step, clip.duration), &cursor, factor);
+	}
+	std::chrono::duration<float, std::nano> cursorElapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+	startTime = std::chrono::high_resolution_clock::now();
+	for (int lookup = 0; lookup < numLookups; lookup++)
+	{
+		checksum += uniformClip.findKey(uniformTimes, fmodf(lookup * step, clip.duration), NULL, factor);
+	}
+	std::chrono::duration<float, std::nano> uniformElapsed = std::chrono::high_resolution_clock::now() - startTime;
+
+	//Printing the checksum stops the compiler from throwing the loops away
+	std::cout << numKeys << " keys: linear " << linearElapsed.count() / numLookups << " ns, binary search "
+		<< binaryElapsed.count() / numLookups << " ns, cursor " << cursorElapsed.count() / numLookups << " ns, uniform "
+		<< uniformElapsed.count() / numLookups << " ns per lookup (checksum " << checksum << ")" << std::endl;
+}
@@ -0,0 +1,51 @@
+#ifndef _HG_cAnimationBenchmark_
+#define _HG_cAnimationBenchmark_
+
+#include <string>
+#include <vector>
+
+class cSkinnedMesh;
+class cSkeleton;
+struct sClipBinding;
+struct aiAnimation;
+
+//Offline timings for the animation code. Needs a GL context because cSkinnedMesh uploads its meshes on load,
+//and for the uniform timings and the check on cSkinningPass
+class cAnimationBenchmark
+{
+public:
+	//Times key lookup on synthetic clips, then loads the model and clips (if modelFile isn't empty)
+	//and times each animation path. Prints the results and returns 0 on success
+	static int run(const std::string& modelFile, const std::vector<std::string>& clipFiles);
+
+private:
+	//Bones per microsecond through BoneTransformFromScene, the compiled clip and EvaluatePose.
+	//sceneAnimation is the aiAnimation the clip was compiled from, for the reference path
+	static void benchmarkClipBinding(cSkinnedMesh& mesh, const std::string& animationName, const aiAnimation* sceneAnimation);
+	//Milliseconds per frame to pose numInstances characters, on one thread and through cAnimationUpdater
+	static void benchmarkCrowd(const cSkeleton& skeleton, const sClipBinding& binding, unsigned int numInstances);
+	//Milliseconds per frame to pose numInstances characters one at a time and through cPoseBatchSampler
+	static void benchmarkBatchSampling(const cSkeleton& skeleton, const sClipBinding& binding, unsigned int numInstances);
+	//Milliseconds per frame for a crowd spread over the default level of detail tiers, against evaluating all of it,
+	//and how far the blended poses stray from the real ones
+	static void benchmarkLod(const cSkeleton& skeleton, const sClipBinding& binding, unsigned int numInstances);
+	//Milliseconds per frame for a crowd with and without a cPoseCache, its hit rate, and how far the rounded clocks move the poses.
+	//numGroups sets of characters that spawned together, so each set plays in step
+	static void benchmarkPoseCache(const cSkeleton& skeleton, const sClipBinding& binding, unsigned int numInstances, unsigned int numGroups, float quantumSeconds);
+	//Memory and error of the clip through cClipCompressor, and what sampling it costs compressed against as it was
+	static void benchmarkCompression(const cSkeleton& skeleton, const sClipBinding& binding);
+	//Bake time, texture memory and largest palette error of the clip baked at a few frame rates
+	static void benchmarkBaking(const cSkeleton& skeleton, const sClipBinding& binding);
+	//Time and memory for numInstances more characters on an already loaded model
+	static void benchmarkSharedInstances(const std::string& modelFile, unsigned int numInstances);
+	//Milliseconds for cSkinningPass to skin numObjects characters on the model, and how far its output strays from
+	//the same skinning done on the CPU
+	static void benchmarkPreSkinning(const std::string& modelFile, unsigned int numObjects);
+	//Microseconds of CPU per draw to set the uniforms cSkinnedGameObject::Draw sets: asking GL for every location,
+	//by name through cShaderProgram's table, and through sUniform handles looked up once
+	static void benchmarkUniforms(unsigned int numDraws);
+	//Nanoseconds per key lookup for a linear scan, binary search, cursor and uniform resampling, on a clip of numKeys keys
+	static void benchmarkKeySearch(unsigned int numKeys);
+};
+
+#endif
@@ -0,0 +1,307 @@
+#include "cAnimationClip.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include <glm/gtc/constants.hpp>
+
+namespace
+{
+	//Past this many keys in one frame it's a seek, and a binary search is cheaper than carrying on
+	const unsigned int MAX_CURSOR_STEPS = 4;
+
+	//Key at or before time in a sorted array of times, float or 16 bit frame numbers alike.
+	//Steps forward from *cursor when it can and binary searches when it can't
+	template <typename tTime>
+	unsigned int findSortedKey(const tTime* times, unsigned int numKeys, float time, unsigned int* cursor, float& factor)
+	{
+		//Past the last key we hold the last key, rather than jumping back to the start like the aiNodeAnim path did
+		unsigned int key = 0;
+		unsigned int lastPair = numKeys - 2;
+		bool found = false;
+
+		if (cursor && *cursor <= lastPair && times[*cursor] <= time)
+		{
+			//Normal forward playback: the key we want is the last one or just after it
+			key = *cursor;
+			unsigned int steps = 0;
+			while (key < lastPair && time >= times[key + 1] && steps < MAX_CURSOR_STEPS)
+			{
+				key++;
+				steps++;
+			}
+			found = key == lastPair || time < times[key + 1];
+		}
+
+		if (!found)
+		{
+			//First key after time, searched among keys 1 to lastPair so the result is always a valid pair
+			const tTime* next = std::upper_bound(times + 1, times + lastPair + 1, time);
+			key = (unsigned int)(next - times) - 1;
+		}
+		if (cursor)
+			*cursor = key;
+
+		float deltaTime = (float)times[key + 1] - (float)times[key];
+		factor = deltaTime > 0.0f ? (time - (float)times[key]) / deltaTime : 0.0f;
+		if (factor < 0.0f) factor = 0.0f;
+		if (factor > 1.0f) factor = 1.0f;
+		return key;
+	}
+
+	glm::vec3 decodeBounded(const unsigned short* words, const glm::vec3& min, const glm::vec3& step)
+	{
+		return min + glm::vec3(words[0], words[1], words[2]) * step;
+	}
+}
+
+void sClipCursor::reset(const cAnimationClip* newClip)
+{
+	this->clip = newClip;
+	this->keys.assign(newClip ? newClip->channels.size() * 3 : 0, 0);
+}
+
+cAnimationClip::cAnimationClip(const aiAnimation* animation, std::string clipName)
+{
+	this->name = clipName;
+	this->duration = (float)animation->mDuration;
+	this->ticksPerSecond = (float)(animation->mTicksPerSecond != 0 ? animation->mTicksPerSecond : 25.0);
+	this->uniformKeyStep = 0.0f;
+	this->isCompressed = false;
+	this->frameTicks = 0.0f;
+	this->positionMin = this->positionStep = glm::vec3(0.0f);
+	this->scalingMin = this->scalingStep = glm::vec3(0.0f);
+
+	this->channels.resize(animation->mNumChannels);
+	for (unsigned int channelIndex = 0; channelIndex < animation->mNumChannels; channelIndex++)
+	{
+		const aiNodeAnim* nodeAnim = animation->mChannels[channelIndex];
+		sAnimationChannel& channel = this->channels[channelIndex];
+		channel.nodeName = nodeAnim->mNodeName.C_Str();
+
+		channel.positionTimes.resize(nodeAnim->mNumPositionKeys);
+		channel.positionValues.resize(nodeAnim->mNumPositionKeys);
+		for (unsigned int key = 0; key < nodeAnim->mNumPositionKeys; key++)
+		{
+			const aiVectorKey& source = nodeAnim->mPositionKeys[key];
+			channel.positionTimes[key] = (float)source.mTime;
+			channel.positionValues[key] = glm::vec3(source.mValue.x, source.mValue.y, source.mValue.z);
+		}
+
+		channel.rotationTimes.resize(nodeAnim->mNumRotationKeys);
+		channel.rotationValues.resize(nodeAnim->mNumRotationKeys);
+		for (unsigned int key = 0; key < nodeAnim->mNumRotationKeys; key++)
+		{
+			const aiQuatKey& source = nodeAnim->mRotationKeys[key];
+			channel.rotationTimes[key] = (float)source.mTime;
+			channel.rotationValues[key] = glm::quat(source.mValue.w, source.mValue.x, source.mValue.y, source.mValue.z);
+		}
+
+		channel.scalingTimes.resize(nodeAnim->mNumScalingKeys);
+		channel.scalingValues.resize(nodeAnim->mNumScalingKeys);
+		for (unsigned int key = 0; key < nodeAnim->mNumScalingKeys; key++)
+		{
+			const aiVectorKey& source = nodeAnim->mScalingKeys[key];
+			channel.scalingTimes[key] = (float)source.mTime;
+			channel.scalingValues[key] = glm::vec3(source.mValue.x, source.mValue.y, source.mValue.z);
+		}
+
+		//Sampling expects at least one key of each kind, so fill any gaps with the identity
+		if (channel.positionTimes.empty())
+		{
+			channel.positionTimes.push_back(0.0f);
+			channel.positionValues.push_back(glm::vec3(0.0f));
+		}
+		if (channel.rotationTimes.empty())
+		{
+			channel.rotationTimes.push_back(0.0f);
+			channel.rotationValues.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+		}
+		if (channel.scalingTimes.empty())
+		{
+			channel.scalingTimes.push_back(0.0f);
+			channel.scalingValues.push_back(glm::vec3(1.0f));
+		}
+	}
+}
+
+size_t cAnimationClip::getMemoryBytes() const
+{
+	size_t bytes = sizeof(cAnimationClip) + this->name.capacity() + this->channels.capacity() * sizeof(sAnimationChannel);
+	for (unsigned int channelIndex = 0; channelIndex < this->channels.size(); channelIndex++)
+	{
+		const sAnimationChannel& channel = this->channels[channelIndex];
+		bytes += channel.nodeName.capacity();
+		bytes += (channel.positionTimes.capacity() + channel.rotationTimes.capacity() + channel.scalingTimes.capacity()) * sizeof(float);
+		bytes += (channel.positionValues.capacity() + channel.scalingValues.capacity()) * sizeof(glm::vec3);
+		bytes += channel.rotationValues.capacity() * sizeof(glm::quat);
+	}
+	bytes += this->compressedChannels.capacity() * sizeof(sCompressedChannel);
+	bytes += (this->keyFrames.capacity() + this->keyValues.capacity()) * sizeof(unsigned short);
+	return bytes;
+}
+
+float cAnimationClip::getAnimationTime(float timeInSeconds) const
+{
+	return fmodf(timeInSeconds * this->ticksPerSecond, this->duration);
+}
+
+int cAnimationClip::findChannel(const std::string& nodeName) const
+{
+	for (int channelIndex = 0; channelIndex < this->channels.size(); channelIndex++)
+	{
+		if (this->channels[channelIndex].nodeName == nodeName)
+			return channelIndex;
+	}
+	return -1;
+}
+
+void cAnimationClip::resampleUniform(float keyStep)
+{
+	if (keyStep <= 0.0f || this->duration <= 0.0f || this->isCompressed)
+		return;
+
+	unsigned int numKeys = (unsigned int)ceilf(this->duration / keyStep) + 1;
+	std::vector<float> times(numKeys);
+	for (unsigned int key = 0; key < numKeys; key++)
+	{
+		times[key] = key * keyStep;
+	}
+
+	//Sampled while uniformKeyStep is still 0, so the lookups search the original keys
+	for (int channelIndex = 0; channelIndex < this->channels.size(); channelIndex++)
+	{
+		sAnimationChannel& channel = this->channels[channelIndex];
+		//Single keys are constant anyway, and are left alone so they stay one key
+		if (channel.positionValues.size() > 1)
+		{
+			std::vector<glm::vec3> values(numKeys);
+			for (unsigned int key = 0; key < numKeys; key++)
+				values[key] = sampleVectorKeys(channel.positionTimes, channel.positionValues, times[key], NULL);
+			channel.positionTimes = times;
+			channel.positionValues.swap(values);
+		}
+		if (channel.rotationValues.size() > 1)
+		{
+			std::vector<glm::quat> values(numKeys);
+			for (unsigned int key = 0; key < numKeys; key++)
+				values[key] = sampleRotationKeys(channel.rotationTimes, channel.rotationValues, times[key], NULL);
+			channel.rotationTimes = times;
+			channel.rotationValues.swap(values);
+		}
+		if (channel.scalingValues.size() > 1)
+		{
+			std::vector<glm::vec3> values(numKeys);
+			for (unsigned int key = 0; key < numKeys; key++)
+				values[key] = sampleVectorKeys(channel.scalingTimes, channel.scalingValues, times[key], NULL);
+			channel.scalingTimes = times;
+			channel.scalingValues.swap(values);
+		}
+	}
+	this->uniformKeyStep = keyStep;
+}
+
+glm::mat4 cAnimationClip::sampleChannel(int channelIndex, float animationTime, sClipCursor* cursor) const
+{
+	unsigned int* keys = cursor ? &cursor->keys[channelIndex * 3] : NULL;
+	glm::vec3 position, scale;
+	glm::quat rotation;
+	if (this->isCompressed)
+	{
+		const sCompressedChannel& channel = this->compressedChannels[channelIndex];
+		float factor;
+		unsigned int key = findCompressedKey(channel.position, animationTime, keys, factor);
+		position = channel.position.numKeys > 1 ? glm::mix(decodePosition(key), decodePosition(key + 1), factor) : decodePosition(key);
+		key = findCompressedKey(channel.rotation, animationTime, keys ? keys + 1 : NULL, factor);
+		rotation = channel.rotation.numKeys > 1 ? glm::normalize(glm::slerp(decodeRotation(key), decodeRotation(key + 1), factor)) : decodeRotation(key);
+		key = findCompressedKey(channel.scaling, animationTime, keys ? keys + 2 : NULL, factor);
+		scale = channel.scaling.numKeys > 1 ? glm::mix(decodeScaling(key), decodeScaling(key + 1), factor) : decodeScaling(key);
+	}
+	else
+	{
+		const sAnimationChannel& channel = this->channels[channelIndex];
+		position = sampleVectorKeys(channel.positionTimes, channel.positionValues, animationTime, keys);
+		rotation = sampleRotationKeys(channel.rotationTimes, channel.rotationValues, animationTime, keys ? keys + 1 : NULL);
+		scale = sampleVectorKeys(channel.scalingTimes, channel.scalingValues, animationTime, keys ? keys + 2 : NULL);
+	}
+
+	//Translation * Rotation * Scaling, built directly instead of multiplying three matrices
+	glm::mat4 transform = glm::mat4_cast(rotation);
+	transform[0] *= scale.x;
+	transform[1] *= scale.y;
+	transform[2] *= scale.z;
+	transform[3] = glm::vec4(position, 1.0f);
+	return transform;
+}
+
+glm::vec3 cAnimationClip::sampleVectorKeys(const std::vector<float>& times, const std::vector<glm::vec3>& values, float animationTime, unsigned int* cursor) const
+{
+	if (values.size() == 1)
+		return values[0];
+
+	float factor;
+	unsigned int key = findKey(times, animationTime, cursor, factor);
+	return (values[key + 1] - values[key]) * factor + values[key];
+}
+
+glm::quat cAnimationClip::sampleRotationKeys(const std::vector<float>& times, const std::vector<glm::quat>& values, float animationTime, unsigned int* cursor) const
+{
+	if (values.size() == 1)
+		return values[0];
+
+	float factor;
+	unsigned int key = findKey(times, animationTime, cursor, factor);
+	return glm::normalize(glm::slerp(values[key], values[key + 1], factor));
+}
+
+unsigned int cAnimationClip::findKey(const std::vector<float>& times, float animationTime, unsigned int* cursor, float& factor) const
+{
+	if (this->uniformKeyStep > 0.0f && times.size() > 2)
+	{
+		unsigned int lastPair = (unsigned int)times.size() - 2;
+		float position = animationTime / this->uniformKeyStep;
+		unsigned int key = position <= 0.0f ? 0 : (position >= lastPair ? lastPair : (unsigned int)position);
+		if (cursor)
+			*cursor = key;
+		factor = glm::clamp((animationTime - times[key]) / (times[key + 1] - times[key]), 0.0f, 1.0f);
+		return key;
+	}
+	return findSortedKey(times.data(), (unsigned int)times.size(), animationTime, cursor, factor);
+}
+
+unsigned int cAnimationClip::findCompressedKey(const sCompressedTrack& track, float animationTime, unsigned int* cursor, float& factor) const
+{
+	factor = 0.0f;
+	if (track.numKeys == 1)
+		return track.firstKey;
+	return track.firstKey + findSortedKey(&this->keyFrames[track.firstKey], track.numKeys, animationTime / this->frameTicks, cursor, factor);
+}
+
+glm::vec3 cAnimationClip::decodePosition(unsigned int key) const
+{
+	return decodeBounded(&this->keyValues[key * 3], this->positionMin, this->positionStep);
+}
+
+glm::vec3 cAnimationClip::decodeScaling(unsigned int key) const
+{
+	return decodeBounded(&this->keyValues[key * 3], this->scalingMin, this->scalingStep);
+}
+
+glm::quat cAnimationClip::decodeRotation(unsigned int key) const
+{
+	//Three 15 bit components in [-1/sqrt(2), 1/sqrt(2)], with which of x, y, z, w was left out in the top bits
+	//of the first two words. The one left out was the largest, stored positive, so it comes back from the unit length
+	const unsigned short* words = &this->keyValues[key * 3];
+	const float scale = 2.0f / 32767.0f * glm::one_over_root_two<float>();
+	float a = (words[0] & 0x7fff) * scale - glm::one_over_root_two<float>();
+	float b = (words[1] & 0x7fff) * scale - glm::one_over_root_two<float>();
+	float c = (words[2] & 0x7fff) * scale - glm::one_over_root_two<float>();
+	float d = sqrtf(glm::max(0.0f, 1.0f - a * a - b * b - c * c));
+	switch (((words[0] >> 15) << 1) | (words[1] >> 15))
+	{
+	case 0: return glm::quat(c, d, a, b);
+	case 1: return glm::quat(c, a, d, b);
+	case 2: return glm::quat(c, a, b, d);
+	default: return glm::quat(d, a, b, c);
+	}
+}
@@ -0,0 +1,114 @@
+#ifndef _HG_cAnimationClip_
+#define _HG_cAnimationClip_
+
+#include <string>
+#include <vector>
+
+#include <assimp/anim.h>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+//Keyframes for one node, with the times and values in separate arrays so the key search only touches the times
+struct sAnimationChannel
+{
+	std::string nodeName;
+
+	std::vector<float> positionTimes;
+	std::vector<glm::vec3> positionValues;
+	std::vector<float> rotationTimes;
+	std::vector<glm::quat> rotationValues;
+	std::vector<float> scalingTimes;
+	std::vector<glm::vec3> scalingValues;
+};
+
+//One track of a compressed channel: numKeys 16 bit frame numbers starting at keyFrames[firstKey],
+//and three 16 bit words per key starting at keyValues[firstKey * 3]
+struct sCompressedTrack
+{
+	unsigned int firstKey;
+	unsigned int numKeys;
+};
+
+struct sCompressedChannel
+{
+	sCompressedTrack position;
+	sCompressedTrack rotation;
+	sCompressedTrack scaling;
+};
+
+class cAnimationClip;
+
+//Where the last sample of each channel's key arrays landed, so forward playback only steps a key or two
+//instead of searching. One per playing instance; it resets itself when it's used with a different clip
+struct sClipCursor
+{
+	const cAnimationClip* clip;
+	//Three per channel: position, rotation and scaling key
+	std::vector<unsigned int> keys;
+
+	sClipCursor() : clip(NULL) {};
+	void reset(const cAnimationClip* newClip);
+};
+
+//An aiAnimation copied into flat arrays at load time. Nothing in here points back into the aiScene,
+//and sampling does no string work, so binding a clip to a skeleton is the only time names get compared
+class cAnimationClip
+{
+public:
+	std::string name;
+	//Both in ticks, like the aiAnimation they came from
+	float duration;
+	float ticksPerSecond;
+	std::vector<sAnimationChannel> channels;
+	//Ticks between keys once resampleUniform() has run, which makes finding a key a division. 0 until then
+	float uniformKeyStep;
+
+	//Filled in by cClipCompressor, which empties the float key arrays above. Every track's keys sit together
+	//in the two pools, so sampling a compressed channel reads a few neighbouring words instead of whole glm types
+	bool isCompressed;
+	//Ticks between the frame numbers in keyFrames
+	float frameTicks;
+	//Positions and scales are 16 bits per component across the clip's bounds: min + value * step.
+	//Rotations are smallest three, 48 bits a key
+	glm::vec3 positionMin;
+	glm::vec3 positionStep;
+	glm::vec3 scalingMin;
+	glm::vec3 scalingStep;
+	std::vector<sCompressedChannel> compressedChannels;
+	std::vector<unsigned short> keyFrames;
+	std::vector<unsigned short> keyValues;
+
+	cAnimationClip(const aiAnimation* animation, std::string clipName);
+
+	//Rebuilds every animated key array with one key each keyStep ticks. Costs memory on sparse clips and
+	//smooths over anything sharper than the step, in exchange for O(1) key lookup
+	void resampleUniform(float keyStep);
+
+	//Key arrays and names, as allocated
+	size_t getMemoryBytes() const;
+
+	//Seconds to ticks, wrapped to the length of the clip
+	float getAnimationTime(float timeInSeconds) const;
+
+	//-1 if the clip doesn't animate that node
+	int findChannel(const std::string& nodeName) const;
+
+	//Local transform of the channel's node at the given time in ticks. Without a cursor every key is binary searched
+	glm::mat4 sampleChannel(int channelIndex, float animationTime, sClipCursor* cursor = NULL) const;
+
+	glm::vec3 sampleVectorKeys(const std::vector<float>& times, const std::vector<glm::vec3>& values, float animationTime, unsigned int* cursor) const;
+	glm::quat sampleRotationKeys(const std::vector<float>& times, const std::vector<glm::quat>& values, float animationTime, unsigned int* cursor) const;
+	//Index of the key at or before animationTime, and how far along it is to the next one.
+	//Steps forward from *cursor when it can, binary searches when it can't (seeks, loops), and updates *cursor
+	unsigned int findKey(const std::vector<float>& times, float animationTime, unsigned int* cursor, float& factor) const;
+
+	//The same for a compressed track, returning the key's index in the pools
+	unsigned int findCompressedKey(const sCompressedTrack& track, float animationTime, unsigned int* cursor, float& factor) const;
+	glm::vec3 decodePosition(unsigned int key) const;
+	glm::quat decodeRotation(unsigned int key) const;
+	glm::vec3 decodeScaling(unsigned int key) const;
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include "cAnimationClipLibrary.h"
+
+#include <iostream>
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+
+#include "cTextureRegistry.h"
+
+cAnimationClipLibrary& cAnimationClipLibrary::getInstance()
+{
+	static cAnimationClipLibrary library;
+	return library;
+}
+
+cAnimationClipLibrary::cAnimationClipLibrary()
+{
+	numClips = 0;
+	numReferences = 0;
+	residentBytes = 0;
+	releasedSceneBytes = 0;
+	savedBytes = 0;
+	compressedAwayBytes = 0;
+	compressOnLoad = false;
+}
+
+const cAnimationClip* cAnimationClipLibrary::acquire(const std::string& path)
+{
+	std::string pathKey = cTextureRegistry::normalizePath(path);
+	{
+		std::lock_guard<std::mutex> lock(libraryMutex);
+		std::unordered_map<std::string, const cAnimationClip*>::iterator it = mapPathToClip.find(pathKey);
+		if (it != mapPathToClip.end())
+		{
+			sEntry& entry = mapClipToEntry[it->second];
+			entry.refCount++;
+			numReferences++;
+			savedBytes += entry.bytes;
+			return it->second;
+		}
+	}
+
+	//Only the animation is wanted, so skip the mesh post processing the model loader does.
+	//The importer and its scene go away at the end of this block
+	cAnimationClip* clip = NULL;
+	size_t sceneBytes = 0;
+	{
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(path.c_str(), 0);
+		if (!scene || scene->mNumAnimations == 0)
+		{
+			return NULL;
+		}
+		clip = new cAnimationClip(scene->mAnimations[0], path);
+		sceneBytes = estimateSceneBytes(scene);
+	}
+	size_t compressedBytes = 0;
+	if (compressOnLoad)
+	{
+		sClipCompressionReport report = cClipCompressor::compress(*clip, compressionSettings);
+		compressedBytes = report.rawBytes - report.compressedBytes;
+	}
+
+	std::lock_guard<std::mutex> lock(libraryMutex);
+	//Another thread may have loaded the same file while this one was importing
+	std::unordered_map<std::string, const cAnimationClip*>::iterator it = mapPathToClip.find(pathKey);
+	if (it != mapPathToClip.end())
+	{
+		delete clip;
+		sEntry& entry = mapClipToEntry[it->second];
+		entry.refCount++;
+		numReferences++;
+		savedBytes += entry.bytes;
+		return it->second;
+	}
+
+	sEntry entry;
+	entry.clip = clip;
+	entry.refCount = 1;
+	entry.bytes = clip->getMemoryBytes();
+	entry.pathKey = pathKey;
+	mapPathToClip[pathKey] = clip;
+	mapClipToEntry[clip] = entry;
+
+	numClips++;
+	numReferences++;
+	residentBytes += entry.bytes;
+	releasedSceneBytes += sceneBytes;
+	compressedAwayBytes += compressedBytes;
+	return clip;
+}
+
+void cAnimationClipLibrary::release(const cAnimationClip* clip)
+{
+	std::lock_guard<std::mutex> lock(libraryMutex);
+	std::unordered_map<const cAnimationClip*, sEntry>::iterator it = mapClipToEntry.find(clip);
+	if (it == mapClipToEntry.end())
+		return;
+
+	numReferences--;
+	sEntry& entry = it->second;
+	entry.refCount--;
+	if (entry.refCount > 0)
+		return;
+
+	numClips--;
+	residentBytes -= entry.bytes;
+	mapPathToClip.erase(entry.pathKey);
+	delete entry.clip;
+	mapClipToEntry.erase(it);
+}
+
+size_t cAnimationClipLibrary::estimateSceneBytes(const aiScene* scene)
+{
+	size_t bytes = sizeof(aiScene);
+	for (unsigned int animationIndex = 0; animationIndex < scene->mNumAnimations; animationIndex++)
+	{
+		const aiAnimation* animation = scene->mAnimations[animationIndex];
+		bytes += sizeof(aiAnimation);
+		for (unsigned int channelIndex = 0; channelIndex < animation->mNumChannels; channelIndex++)
+		{
+			const aiNodeAnim* nodeAnim = animation->mChannels[channelIndex];
+			bytes += sizeof(aiNodeAnim);
+			bytes += (nodeAnim->mNumPositionKeys + nodeAnim->mNumScalingKeys) * sizeof(aiVectorKey);
+			bytes += nodeAnim->mNumRotationKeys * sizeof(aiQuatKey);
+		}
+	}
+
+	//Animation files exported from a DCC tool usually carry the whole character along with them
+	for (unsigned int meshIndex = 0; meshIndex < scene->mNumMeshes; meshIndex++)
+	{
+		const aiMesh* mesh = scene->mMeshes[meshIndex];
+		unsigned int numStreams = (mesh->HasPositions() ? 1 : 0) + (mesh->HasNormals() ? 1 : 0) + (mesh->HasTangentsAndBitangents() ? 2 : 0);
+		for (unsigned int channel = 0; channel < AI_MAX_NUMBER_OF_TEXTURECOORDS; channel++)
+		{
+			numStreams += mesh->HasTextureCoords(channel) ? 1 : 0;
+		}
+		bytes += sizeof(aiMesh) + mesh->mNumVertices * numStreams * sizeof(aiVector3D);
+		for (unsigned int channel = 0; channel < AI_MAX_NUMBER_OF_COLOR_SETS; channel++)
+		{
+			bytes += mesh->HasVertexColors(channel) ? mesh->mNumVertices * sizeof(aiColor4D) : 0;
+		}
+		for (unsigned int faceIndex = 0; faceIndex < mesh->mNumFaces; faceIndex++)
+		{
+			bytes += sizeof(aiFace) + mesh->mFaces[faceIndex].mNumIndices * sizeof(unsigned int);
+		}
+		for (unsigned int boneIndex = 0; boneIndex < mesh->mNumBones; boneIndex++)
+		{
+			bytes += sizeof(aiBone) + mesh->mBones[boneIndex]->mNumWeights * sizeof(aiVertexWeight);
+		}
+	}
+	return bytes;
+}
+
+void cAnimationClipLibrary::printReport()
+{
+	std::lock_guard<std::mutex> lock(libraryMutex);
+	std::cout << "Animation clip library: " << numClips << " clips for " << numReferences << " users, "
+		<< residentBytes / 1024 << " KB resident, " << releasedSceneBytes / 1024 << " KB of Assimp scenes released, "
+		<< savedBytes / 1024 << " KB of duplicate clips avoided, " << compressedAwayBytes / 1024 << " KB saved by compression" << std::endl;
+}
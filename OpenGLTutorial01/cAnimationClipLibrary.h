@@ -0,0 +1,66 @@
+#ifndef _HG_cAnimationClipLibrary_
+#define _HG_cAnimationClipLibrary_
+
+#include <string>
+#include <unordered_map>
+#include <mutex>
+
+#include <assimp/scene.h>
+
+#include "cAnimationClip.h"
+#include "cClipCompressor.h"
+
+//One cAnimationClip per animation file, shared by every skeleton that plays it. The file is imported once,
+//copied into the clip and the Assimp scene is freed straight away. Clips only know node names,
+//so any skeleton with matching bone names can bind the same clip through cSkeleton::bindClip
+class cAnimationClipLibrary
+{
+public:
+	static cAnimationClipLibrary& getInstance();
+
+	//The first animation in the file, or NULL if the file can't be read or has none.
+	//Every clip returned must be given back with release. Safe from any thread
+	const cAnimationClip* acquire(const std::string& path);
+	void release(const cAnimationClip* clip);
+
+	//Rough size of what Assimp keeps for a scene: animation keys, vertex streams, faces and bone weights
+	static size_t estimateSceneBytes(const aiScene* scene);
+
+	void printReport();
+
+	//Clips loaded from here on go through cClipCompressor with these settings. Set before loading starts,
+	//they are read without the lock
+	bool compressOnLoad;
+	sClipCompressionSettings compressionSettings;
+
+	unsigned int numClips;
+	unsigned int numReferences;
+	//What the clips themselves take
+	size_t residentBytes;
+	//Assimp scenes freed after conversion, which used to stay alive for as long as the mesh did
+	size_t releasedSceneBytes;
+	//Clip memory the shared references would have cost as separate copies
+	size_t savedBytes;
+	//Difference compression made to the clips loaded so far
+	size_t compressedAwayBytes;
+
+private:
+	struct sEntry
+	{
+		cAnimationClip* clip;
+		unsigned int refCount;
+		size_t bytes;
+		std::string pathKey;
+	};
+
+	std::unordered_map<std::string, const cAnimationClip*> mapPathToClip;
+	std::unordered_map<const cAnimationClip*, sEntry> mapClipToEntry;
+	std::mutex libraryMutex;
+
+	cAnimationClipLibrary();
+
+	cAnimationClipLibrary(const cAnimationClipLibrary&);
+	cAnimationClipLibrary& operator=(const cAnimationClipLibrary&);
+};
+
+#endif
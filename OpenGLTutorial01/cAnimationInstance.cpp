@@ -0,0 +1,176 @@
+#include "cAnimationInstance.h"
+
+namespace
+{
+	//Hands out a different starting phase to every instance
+	unsigned int nextLodPhase = 0;
+	//A character only drops to a further tier once it's this much past the boundary, and comes back at the boundary,
+	//so one standing right on it doesn't flip between tiers every frame
+	const float LOD_HYSTERESIS = 1.1f;
+	//Fewest frames the detail bones take to ease in or out
+	const unsigned int DETAIL_BLEND_SPAN = 4;
+
+	unsigned int findLodTier(const std::vector<sAnimationLodTier>& tiers, float effectiveDistance)
+	{
+		for (unsigned int tier = 0; tier + 1 < tiers.size(); tier++)
+		{
+			if (effectiveDistance <= tiers[tier].maxDistance)
+				return tier;
+		}
+		return tiers.empty() ? 0 : (unsigned int)tiers.size() - 1;
+	}
+}
+
+cAnimationInstance::cAnimationInstance(const cSkinnedMesh* mesh)
+{
+	this->mesh = mesh;
+	this->skeleton = &mesh->Skeleton;
+	this->clip = &mesh->DefaultClip;
+	this->clipName = mesh->Filename;
+	this->initLod();
+}
+
+cAnimationInstance::cAnimationInstance(const cSkeleton* skeleton, const sClipBinding* clip)
+{
+	this->mesh = NULL;
+	this->skeleton = skeleton;
+	this->clip = clip;
+	this->initLod();
+}
+
+void cAnimationInstance::initLod()
+{
+	this->skeleton->allocatePose(this->pose);
+	this->skeleton->allocatePose(this->keyPose);
+	this->hasKeys = false;
+	this->hasFreshPose = false;
+	this->keysSkipDetail = false;
+	this->keySpan = 1;
+	this->framesSinceKey = 0;
+	this->lodPhase = nextLodPhase++;
+}
+
+const cSkinnedMesh* cAnimationInstance::getMesh() const
+{
+	return this->mesh;
+}
+
+void cAnimationInstance::setClip(const std::string& animationName)
+{
+	if (!this->mesh || animationName == this->clipName)
+		return;
+
+	this->clipName = animationName;
+	this->clip = &this->mesh->FindClip(animationName);
+	//Blending from the old clip's key would be a crossfade nobody asked for
+	this->hasKeys = false;
+	this->hasFreshPose = false;
+}
+
+const cAnimationClip* cAnimationInstance::getClip() const
+{
+	return this->clip->clip;
+}
+
+void cAnimationInstance::evaluate(float timeInSeconds, bool skipDetailNodes, cPoseCache* poseCache)
+{
+	if (poseCache)
+	{
+		poseCache->evaluate(*this->skeleton, *this->clip, timeInSeconds, skipDetailNodes, this->pose.palette);
+		this->hasKeys = false;
+		this->hasFreshPose = true;
+		return;
+	}
+	float animationTime = this->clip->clip ? this->clip->clip->getAnimationTime(timeInSeconds) : 0.0f;
+	this->skeleton->evaluate(*this->clip, animationTime, this->pose, skipDetailNodes);
+	this->hasKeys = false;
+	this->hasFreshPose = true;
+}
+
+void cAnimationInstance::evaluateLod(float timeInSeconds, float stepSeconds, unsigned int updateInterval, bool skipDetailNodes, cPoseCache* poseCache)
+{
+	//Coming back to full rate finishes the keys it's in the middle of first
+	if ((updateInterval <= 1 && !this->hasKeys) || !this->clip->clip)
+	{
+		this->evaluate(timeInSeconds, skipDetailNodes, poseCache);
+		return;
+	}
+
+	const cAnimationClip* animation = this->clip->clip;
+	//A tier change keeps the keys it's in the middle of. The new interval and detail setting start at the next key,
+	//so the detail bones ease in or out across that span instead of snapping to the bind pose
+	if (!this->hasKeys && this->hasFreshPose)
+	{
+		//Coming down from full rate: last call's pose is the first key, so this only costs the one evaluation.
+		//Spans start at 2 so the key for now never lands on this call
+		this->fromPalette = this->pose.palette;
+		this->keySpan = 2 + this->lodPhase % updateInterval;
+		this->framesSinceKey = 1;
+		this->skeleton->evaluate(*this->clip, animation->getAnimationTime(timeInSeconds + (this->keySpan - 1) * stepSeconds), this->keyPose, skipDetailNodes);
+		this->toPalette = this->keyPose.palette;
+		this->keysSkipDetail = skipDetailNodes;
+		this->hasKeys = true;
+	}
+	else if (!this->hasKeys)
+	{
+		//Start from a pose for right now. The first span is cut short by the phase so instances spread out
+		this->skeleton->evaluate(*this->clip, animation->getAnimationTime(timeInSeconds), this->keyPose, skipDetailNodes);
+		this->fromPalette = this->keyPose.palette;
+		this->keySpan = 1 + this->lodPhase % updateInterval;
+		this->skeleton->evaluate(*this->clip, animation->getAnimationTime(timeInSeconds + this->keySpan * stepSeconds), this->keyPose, skipDetailNodes);
+		this->toPalette = this->keyPose.palette;
+		this->keysSkipDetail = skipDetailNodes;
+		this->framesSinceKey = 0;
+		this->hasKeys = true;
+	}
+	else if (++this->framesSinceKey >= this->keySpan)
+	{
+		//The key evaluated last time was for now, so full rate can take over from it once it has the same bones
+		if (updateInterval <= 1 && this->keysSkipDetail == skipDetailNodes)
+		{
+			this->evaluate(timeInSeconds, skipDetailNodes, poseCache);
+			return;
+		}
+		//The next one is for where the clock will be when it's replaced. Detail bones coming or going get a few
+		//frames at least, or a short span would still snap them
+		this->fromPalette.swap(this->toPalette);
+		this->keySpan = this->keysSkipDetail != skipDetailNodes ? glm::max(updateInterval, DETAIL_BLEND_SPAN) : updateInterval;
+		this->skeleton->evaluate(*this->clip, animation->getAnimationTime(timeInSeconds + this->keySpan * stepSeconds), this->keyPose, skipDetailNodes);
+		this->toPalette = this->keyPose.palette;
+		this->keysSkipDetail = skipDetailNodes;
+		this->framesSinceKey = 0;
+	}
+	this->hasFreshPose = false;
+
+	float factor = (float)this->framesSinceKey / (float)this->keySpan;
+	for (unsigned int bone = 0; bone < this->pose.palette.size(); bone++)
+	{
+		const glm::mat4& from = this->fromPalette[bone];
+		const glm::mat4& to = this->toPalette[bone];
+		for (int column = 0; column < 4; column++)
+		{
+			this->pose.palette[bone][column] = from[column] + (to[column] - from[column]) * factor;
+		}
+	}
+}
+
+std::vector<sAnimationLodTier> cAnimationInstance::getDefaultLodTiers()
+{
+	sAnimationLodTier tiers[] = {
+		{ 15.0f, 1, false },
+		{ 40.0f, 2, false },
+		{ 1e30f, 4, true } };
+	return std::vector<sAnimationLodTier>(tiers, tiers + sizeof(tiers) / sizeof(tiers[0]));
+}
+
+unsigned int cAnimationInstance::selectLodTier(const std::vector<sAnimationLodTier>& tiers, float distance, float scale, unsigned int currentTier)
+{
+	float effectiveDistance = scale > 0.0f ? distance / scale : distance;
+	unsigned int closerTier = findLodTier(tiers, effectiveDistance);
+	unsigned int furtherTier = findLodTier(tiers, effectiveDistance / LOD_HYSTERESIS);
+	if (currentTier < furtherTier)
+		return furtherTier;
+	if (currentTier > closerTier)
+		return closerTier;
+	return currentTier;
+}
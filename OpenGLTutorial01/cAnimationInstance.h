@@ -0,0 +1,77 @@
+#ifndef _HG_cAnimationInstance_
+#define _HG_cAnimationInstance_
+
+#include <string>
+#include <vector>
+
+#include "cSkinnedMesh.h"
+#include "cPoseCache.h"
+
+//One level of animation detail. Tiers are picked by distance from the camera, nearest first
+struct sAnimationLodTier
+{
+	//Up to this far away, divided by the object's largest scale so big characters keep their detail further out
+	float maxDistance;
+	//Frames between fresh poses, 1 for every frame. The frames in between blend the last two
+	unsigned int updateInterval;
+	//Leave cSkeleton::detailNodes (fingers, toes) in their bind pose
+	bool skipDetailNodes;
+};
+
+//Everything that differs between two characters sharing one cSkinnedMesh: which clip they're playing
+//and the pose that came out of it. The mesh itself is only ever read through here
+class cAnimationInstance
+{
+public:
+	cAnimationInstance(const cSkinnedMesh* mesh);
+	//Without a mesh, for tools and benchmarks that build a skeleton themselves. setClip does nothing on these
+	cAnimationInstance(const cSkeleton* skeleton, const sClipBinding* clip);
+
+	const cSkinnedMesh* getMesh() const;
+
+	//Only looks the clip up when the name changes. Unknown names play the mesh's own animation
+	void setClip(const std::string& animationName);
+	//NULL when the mesh has no animation at all
+	const cAnimationClip* getClip() const;
+
+	//With a cache the palette comes from there, shared with anyone else in the same bucket, and only pose.palette is written
+	void evaluate(float timeInSeconds, bool skipDetailNodes = false, cPoseCache* poseCache = NULL);
+	//Evaluates a fresh pose only every updateInterval calls, for where the clock will be by the next one
+	//(stepSeconds a call), and blends the palette from the previous one in between. Only pose.palette is kept
+	//up to date at intervals above 1. Instances start out of step with each other, so a crowd that
+	//drops a tier together doesn't all evaluate on the same frame. Changing the interval or skipDetailNodes
+	//takes effect from the next key, blending into it, and going back to interval 1 waits for the keys to catch up.
+	//The cache is only used at interval 1
+	void evaluateLod(float timeInSeconds, float stepSeconds, unsigned int updateInterval, bool skipDetailNodes, cPoseCache* poseCache = NULL);
+
+	//Tiers most scenes want: full rate close up, then every 2nd frame, then every 4th without fingers
+	static std::vector<sAnimationLodTier> getDefaultLodTiers();
+	//Index of the tier for an object this far away with this largest scale, that was in currentTier last frame.
+	//It moves out a tier 10% past the boundary and back in at the boundary
+	static unsigned int selectLodTier(const std::vector<sAnimationLodTier>& tiers, float distance, float scale, unsigned int currentTier);
+
+	sSkeletonPose pose;
+
+private:
+	const cSkinnedMesh* mesh;
+	const cSkeleton* skeleton;
+	std::string clipName;
+	const sClipBinding* clip;
+
+	//The two poses the reduced tiers blend between, and where between them this call is
+	sSkeletonPose keyPose;
+	std::vector<glm::mat4> fromPalette;
+	std::vector<glm::mat4> toPalette;
+	bool hasKeys;
+	//pose.palette came from evaluate on the last call, so it can be the first key
+	bool hasFreshPose;
+	//toPalette was evaluated without the detail bones
+	bool keysSkipDetail;
+	unsigned int keySpan;
+	unsigned int framesSinceKey;
+	unsigned int lodPhase;
+
+	void initLod();
+};
+
+#endif
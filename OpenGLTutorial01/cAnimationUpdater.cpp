@@ -0,0 +1,68 @@
+#include "cAnimationUpdater.h"
+
+#include <chrono>
+#include <algorithm>
+
+#include "cSkinnedGameObject.h"
+
+namespace
+{
+	//Fewer instances than this per batch and the queue costs more than the poses
+	const unsigned int MIN_BATCH_SIZE = 8;
+	//A few batches per worker so one that lands on a busy core doesn't hold up the frame
+	const unsigned int BATCHES_PER_THREAD = 4;
+}
+
+cAnimationUpdater::cAnimationUpdater(unsigned int numThreads) : pool(numThreads)
+{
+	this->lastUpdateMs = 0.0f;
+	this->sharePoses = false;
+}
+
+void cAnimationUpdater::update(const std::vector<cSkinnedGameObject*>& objects, const glm::vec3& cameraPosition)
+{
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+
+	cPoseCache* poseCache = NULL;
+	if (this->sharePoses)
+	{
+		this->poseCache.beginFrame();
+		poseCache = &this->poseCache;
+	}
+	this->parallelFor((unsigned int)objects.size(), [&objects, &cameraPosition, poseCache](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int index = begin; index < end; index++)
+		{
+			objects[index]->Update(cameraPosition, poseCache);
+		}
+	});
+
+	std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+	this->lastUpdateMs = elapsed.count();
+}
+
+void cAnimationUpdater::parallelFor(unsigned int count, const std::function<void(unsigned int, unsigned int)>& body)
+{
+	unsigned int numBatches = std::min(count / MIN_BATCH_SIZE, this->pool.getNumThreads() * BATCHES_PER_THREAD);
+	if (numBatches <= 1)
+	{
+		body(0, count);
+		return;
+	}
+
+	for (unsigned int batch = 0; batch < numBatches; batch++)
+	{
+		unsigned int begin = count * batch / numBatches;
+		unsigned int end = count * (batch + 1) / numBatches;
+		this->pool.submit([&body, begin, end]()
+		{
+			body(begin, end);
+		});
+	}
+	this->pool.wait();
+}
+
+unsigned int cAnimationUpdater::getNumThreads()
+{
+	return this->pool.getNumThreads();
+}
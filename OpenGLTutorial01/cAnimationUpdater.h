@@ -0,0 +1,44 @@
+#ifndef _HG_cAnimationUpdater_
+#define _HG_cAnimationUpdater_
+
+#include <vector>
+#include <functional>
+
+#include <glm/vec3.hpp>
+
+#include "cThreadPool.h"
+#include "cPoseCache.h"
+
+class cSkinnedGameObject;
+
+//Runs the Update phase of every skinned character on a pool of worker threads. Each object only writes
+//its own clock and pose and only reads the shared meshes and clips, so they need no locking between them.
+//Nothing in here touches GL; the Draw calls that upload the palettes come after, on the context thread
+class cAnimationUpdater
+{
+public:
+	//0 threads means one per hardware core
+	cAnimationUpdater(unsigned int numThreads = 0);
+
+	//Returns once every object's pose for this frame has been written. The camera picks each object's level of detail
+	void update(const std::vector<cSkinnedGameObject*>& objects, const glm::vec3& cameraPosition);
+
+	//Splits [0, count) into batches and calls body(begin, end) for each, on the workers, then waits for them.
+	//Small counts run on the calling thread, where handing out the work would cost more than doing it
+	void parallelFor(unsigned int count, const std::function<void(unsigned int, unsigned int)>& body);
+
+	unsigned int getNumThreads();
+
+	//Wall clock time of the last update
+	float lastUpdateMs;
+
+	//Off by default: sharing rounds every clock to a multiple of poseCache.quantumSeconds
+	bool sharePoses;
+	//Emptied at the start of every update
+	cPoseCache poseCache;
+
+private:
+	cThreadPool pool;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "cAssetLoader.h"
+#include "cTextureRegistry.h"
+
+#include <chrono>
+#include <iostream>
+
+cAssetLoader::cAssetLoader(unsigned int numThreads) : pool(numThreads)
+{
+
+}
+
+cAssetLoader::~cAssetLoader()
+{
+	pool.wait();
+	for (int index = 0; index < jobs.size(); index++)
+	{
+		delete jobs[index];
+	}
+	for (int index = 0; index < images.size(); index++)
+	{
+		delete images[index];
+	}
+}
+
+cModel* cAssetLoader::addModel(std::string path, bool compactVertices)
+{
+	cModel* model = new cModel();
+	model->compactVertices = compactVertices;
+
+	sAssetJob* job = new sAssetJob();
+	job->name = path;
+	job->loadCPU = [model, path]() { return model->loadCPU(path); };
+	job->uploadGL = [model]() { model->uploadGL(); };
+	jobs.push_back(job);
+
+	return model;
+}
+
+cSkybox* cAssetLoader::addSkybox(std::string directory)
+{
+	cSkybox* skybox = new cSkybox();
+
+	sAssetJob* job = new sAssetJob();
+	job->name = directory;
+	job->loadCPU = [skybox, directory]() { return skybox->loadImages(directory); };
+	job->uploadGL = [skybox]() { skybox->uploadGL(); };
+	jobs.push_back(job);
+
+	return skybox;
+}
+
+void cAssetLoader::addTexture(std::string path, unsigned int* textureID)
+{
+	cImage* image = new cImage();
+	images.push_back(image);
+	*textureID = 0;
+
+	sAssetJob* job = new sAssetJob();
+	job->name = path;
+	job->loadCPU = [image, path]()
+	{
+		return cTextureRegistry::getInstance().isResident(path) || image->load(path);
+	};
+	job->uploadGL = [image, path, textureID]()
+	{
+		if (image->isLoaded())
+			*textureID = cTextureRegistry::getInstance().acquire(path, *image, GL_RGB, textureID);
+		else
+			*textureID = cTextureRegistry::getInstance().acquire(path, GL_RGB, textureID);
+		image->free();
+	};
+	jobs.push_back(job);
+}
+
+void cAssetLoader::loadAll()
+{
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+
+	for (int index = 0; index < jobs.size(); index++)
+	{
+		sAssetJob* job = jobs[index];
+		pool.submit([this, job]()
+		{
+			std::chrono::high_resolution_clock::time_point jobStart = std::chrono::high_resolution_clock::now();
+			job->loaded = job->loadCPU();
+			std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - jobStart;
+			job->cpuMs = elapsed.count();
+
+			std::unique_lock<std::mutex> lock(finishedMutex);
+			finishedJobs.push_back(job);
+			jobFinished.notify_one();
+		});
+	}
+
+	//Upload in whatever order the workers finish, so GL work overlaps with the slower imports
+	float totalCpuMs = 0.0f;
+	for (int uploaded = 0; uploaded < jobs.size(); uploaded++)
+	{
+		sAssetJob* job;
+		{
+			std::unique_lock<std::mutex> lock(finishedMutex);
+			while (finishedJobs.empty())
+			{
+				jobFinished.wait(lock);
+			}
+			job = finishedJobs.front();
+			finishedJobs.pop_front();
+		}
+
+		std::chrono::high_resolution_clock::time_point uploadStart = std::chrono::high_resolution_clock::now();
+		if (job->loaded)
+		{
+			job->uploadGL();
+		}
+		else
+		{
+			std::cout << "Asset failed to load: " << job->name << std::endl;
+		}
+		std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - uploadStart;
+		job->uploadMs = elapsed.count();
+		totalCpuMs += job->cpuMs;
+
+		std::cout << "Asset " << job->name << ": " << job->cpuMs << " ms on a worker, " << job->uploadMs << " ms upload" << std::endl;
+	}
+
+	std::chrono::duration<float, std::milli> wallTime = std::chrono::high_resolution_clock::now() - startTime;
+	std::cout << "Loaded " << jobs.size() << " assets on " << pool.getNumThreads() << " threads in " << wallTime.count()
+		<< " ms (" << totalCpuMs << " ms of CPU work)" << std::endl;
+
+	for (int index = 0; index < jobs.size(); index++)
+	{
+		delete jobs[index];
+	}
+	jobs.clear();
+}
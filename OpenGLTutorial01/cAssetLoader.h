@@ -0,0 +1,56 @@
+#ifndef _HG_cAssetLoader_
+#define _HG_cAssetLoader_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "cThreadPool.h"
+#include "cModel.h"
+#include "cSkybox.h"
+#include "cImage.h"
+
+//Loads a batch of scene assets at startup. The CPU side of every asset (import, mesh conversion,
+//image decode) runs on a thread pool; the GL uploads happen on the calling thread as each one finishes
+class cAssetLoader
+{
+public:
+	//0 threads means one per hardware core
+	cAssetLoader(unsigned int numThreads = 0);
+	~cAssetLoader();
+
+	//Each of these only queues the asset. Nothing is usable until loadAll() returns
+	cModel* addModel(std::string path, bool compactVertices = false);
+	cSkybox* addSkybox(std::string directory);
+	void addTexture(std::string path, unsigned int* textureID);
+
+	//Runs every queued asset and prints how long each one took
+	void loadAll();
+
+private:
+	struct sAssetJob
+	{
+		std::string name;
+		std::function<bool()> loadCPU;
+		std::function<void()> uploadGL;
+		bool loaded;
+		float cpuMs;
+		float uploadMs;
+	};
+
+	cThreadPool pool;
+	std::vector<sAssetJob*> jobs;
+	std::vector<cImage*> images;
+
+	std::mutex finishedMutex;
+	std::condition_variable jobFinished;
+	std::deque<sAssetJob*> finishedJobs;
+
+	cAssetLoader(const cAssetLoader&);
+	cAssetLoader& operator=(const cAssetLoader&);
+};
+
+#endif
@@ -0,0 +1,196 @@
+#include "cBakedAnimation.h"
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+#include "cSkinnedMesh.h"
+#include "cShaderProgram.h"
+
+namespace
+{
+	//The three rows of a palette matrix, which is all an affine transform needs
+	void appendAffineRows(const glm::mat4& matrix, std::vector<float>& rows)
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				rows.push_back(matrix[column][row]);
+			}
+		}
+	}
+}
+
+cBakedAnimation::cBakedAnimation(cSkinnedMesh* mesh, float framesPerSecond)
+{
+	this->mesh = mesh;
+	this->numBones = mesh->Skeleton.getNumBones();
+	this->texture = 0;
+	this->textureBytes = 0;
+	this->instanceCapacity = 0;
+	this->uniformsProgramID = -1;
+	glGenBuffers(1, &this->instanceBuffer);
+
+	std::vector<const sClipBinding*> bindings;
+	if (mesh->DefaultClip.clip)
+		bindings.push_back(&mesh->DefaultClip);
+	std::map<std::string, sClipBinding>::const_iterator itClip = mesh->MapAnimationNameToClip.begin();
+	for (itClip; itClip != mesh->MapAnimationNameToClip.end(); itClip++)
+	{
+		bindings.push_back(&itClip->second);
+	}
+
+	std::vector<float> rows;
+	for (int index = 0; index < bindings.size(); index++)
+	{
+		sBakedClip baked;
+		bakeClip(mesh->Skeleton, *bindings[index], framesPerSecond, rows, baked);
+		this->clips.push_back(baked);
+	}
+	if (rows.empty() || this->numBones == 0)
+		return;
+
+	GLint maxTextureSize = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+	GLsizei width = this->numBones * 3;
+	GLsizei height = (GLsizei)(rows.size() / (this->numBones * 12));
+	if (width > maxTextureSize || height > maxTextureSize)
+	{
+		std::cout << "Baked animation for " << mesh->Filename << " is " << width << " x " << height
+			<< " texels, more than the " << maxTextureSize << " this driver allows" << std::endl;
+		this->clips.clear();
+		return;
+	}
+
+	glGenTextures(1, &this->texture);
+	glBindTexture(GL_TEXTURE_2D, this->texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, rows.data());
+	//Only ever read with texelFetch, the shader blends frames itself
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	this->textureBytes = rows.size() * sizeof(float);
+}
+
+cBakedAnimation::~cBakedAnimation()
+{
+	glDeleteTextures(1, &this->texture);
+	glDeleteBuffers(1, &this->instanceBuffer);
+}
+
+void cBakedAnimation::bakeClip(const cSkeleton& skeleton, const sClipBinding& binding, float framesPerSecond,
+	std::vector<float>& rows, sBakedClip& baked)
+{
+	const cAnimationClip* clip = binding.clip;
+	unsigned int numBones = skeleton.getNumBones();
+	float durationSeconds = clip->duration / clip->ticksPerSecond;
+
+	baked.name = clip->name;
+	baked.firstFrame = (unsigned int)(rows.size() / (numBones * 12));
+	baked.numFrames = std::max(1u, (unsigned int)ceilf(durationSeconds * framesPerSecond));
+	//Stretched a little so the frames divide the clip exactly, and the wrap from the last frame to the first lands on its end
+	baked.framesPerSecond = durationSeconds > 0.0f ? baked.numFrames / durationSeconds : framesPerSecond;
+	baked.bytes = baked.numFrames * numBones * 3 * 4 * sizeof(float);
+	baked.maxError = 0.0f;
+
+	sSkeletonPose pose;
+	skeleton.allocatePose(pose);
+	size_t clipStart = rows.size();
+	for (unsigned int frame = 0; frame < baked.numFrames; frame++)
+	{
+		skeleton.evaluate(binding, clip->getAnimationTime(frame / baked.framesPerSecond), pose);
+		for (unsigned int bone = 0; bone < numBones; bone++)
+		{
+			appendAffineRows(pose.palette[bone], rows);
+		}
+	}
+
+	//Halfway between frames is as far as the shader's blend gets from the real pose. The last frame blends
+	//back to the first, the same as the shader does when the clip loops
+	const float* frames = rows.data() + clipStart;
+	for (unsigned int frame = 0; frame < baked.numFrames; frame++)
+	{
+		unsigned int nextFrame = (frame + 1) % baked.numFrames;
+		skeleton.evaluate(binding, clip->getAnimationTime((frame + 0.5f) / baked.framesPerSecond), pose);
+		for (unsigned int bone = 0; bone < numBones; bone++)
+		{
+			const float* from = frames + (frame * numBones + bone) * 12;
+			const float* to = frames + (nextFrame * numBones + bone) * 12;
+			for (int row = 0; row < 3; row++)
+			{
+				for (int column = 0; column < 4; column++)
+				{
+					float blended = (from[row * 4 + column] + to[row * 4 + column]) * 0.5f;
+					baked.maxError = std::max(baked.maxError, fabsf(blended - pose.palette[bone][column][row]));
+				}
+			}
+		}
+	}
+}
+
+int cBakedAnimation::findClip(const std::string& name) const
+{
+	for (int index = 0; index < this->clips.size(); index++)
+	{
+		if (this->clips[index].name == name)
+			return index;
+	}
+	return -1;
+}
+
+sBakedInstance cBakedAnimation::makeInstance(const glm::mat4& model, int clipIndex, float timeInSeconds) const
+{
+	sBakedInstance instance;
+	instance.model = model;
+	//Nothing baked: a single still frame, so the shader never wraps by zero frames
+	if (this->clips.empty())
+	{
+		instance.clip = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f);
+		return instance;
+	}
+	const sBakedClip& clip = this->clips[clipIndex >= 0 && clipIndex < (int)this->clips.size() ? clipIndex : 0];
+	instance.clip = glm::vec4((float)clip.firstFrame, (float)clip.numFrames, clip.framesPerSecond, timeInSeconds);
+	return instance;
+}
+
+void cBakedAnimation::draw(cShaderProgram& shader, const std::vector<sBakedInstance>& instances)
+{
+	if (instances.empty() || this->texture == 0)
+		return;
+
+	size_t bytes = instances.size() * sizeof(sBakedInstance);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->instanceBuffer);
+	if (bytes > this->instanceCapacity)
+		this->instanceCapacity = std::max(bytes, this->instanceCapacity + this->instanceCapacity / 2);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, this->instanceCapacity, NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes, instances.data());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_BINDING, this->instanceBuffer);
+
+	shader.useProgram();
+	if (this->uniformsProgramID != shader.ID)
+	{
+		this->uniformsProgramID = shader.ID;
+		this->bakedBonesUniform = shader.getUniform<int>("bakedBones");
+		this->numBonesUsedUniform = shader.getUniform<int>("numBonesUsed");
+	}
+	glActiveTexture(GL_TEXTURE0 + BAKED_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, this->texture);
+	glActiveTexture(GL_TEXTURE0);
+	this->bakedBonesUniform.set(BAKED_TEXTURE_UNIT);
+	this->numBonesUsedUniform.set((int)this->numBones);
+
+	this->mesh->Draw(shader, (unsigned int)instances.size());
+}
+
+void cBakedAnimation::printReport()
+{
+	std::cout << "Baked animation for " << this->mesh->Filename << ": " << this->clips.size() << " clips, "
+		<< this->numBones << " bones, " << this->textureBytes / 1024 << " KB of texture" << std::endl;
+	for (int index = 0; index < this->clips.size(); index++)
+	{
+		const sBakedClip& clip = this->clips[index];
+		std::cout << "  " << clip.name << ": " << clip.numFrames << " frames at " << clip.framesPerSecond << " fps, "
+			<< clip.bytes / 1024 << " KB, largest palette error " << clip.maxError << std::endl;
+	}
+}
@@ -0,0 +1,84 @@
+#ifndef _HG_cBakedAnimation_
+#define _HG_cBakedAnimation_
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "cSkeleton.h"
+#include "cShaderProgram.h"
+
+class cSkinnedMesh;
+
+//Where one clip sits in the baked texture, and what baking it cost
+struct sBakedClip
+{
+	std::string name;
+	unsigned int firstFrame;
+	unsigned int numFrames;
+	float framesPerSecond;
+	size_t bytes;
+	//Largest difference in any palette element between the baked frames blended like the shader does
+	//and evaluating the clip properly, checked halfway between every pair of frames where it's worst
+	float maxError;
+};
+
+//Per instance data for animBakedVert.glsl, laid out as its std430 buffer expects
+struct sBakedInstance
+{
+	glm::mat4 model;
+	//firstFrame, numFrames, framesPerSecond, time in seconds
+	glm::vec4 clip;
+};
+
+//Every clip of a cSkinnedMesh sampled at a fixed rate into one RGBA32F texture: a row per frame,
+//three texels per bone holding the rows of its 3x4 palette matrix, clips stacked one after another.
+//animBakedVert.glsl blends the two frames either side of each instance's time itself, so background
+//crowds drawn through here cost no skeleton evaluation on the CPU at all, only their clip and time
+class cBakedAnimation
+{
+public:
+	//Bakes the mesh's own animation and every clip loaded onto it, and uploads them. Needs the context thread
+	cBakedAnimation(cSkinnedMesh* mesh, float framesPerSecond = 30.0f);
+	~cBakedAnimation();
+
+	//Appends numFrames rows of the clip to rows, numBones * 12 floats each, and fills in the report.
+	//CPU only, so tools can bake without a context
+	static void bakeClip(const cSkeleton& skeleton, const sClipBinding& binding, float framesPerSecond,
+		std::vector<float>& rows, sBakedClip& baked);
+
+	//-1 if no clip with that name was baked. The mesh's own animation is clip 0 when it has one
+	int findClip(const std::string& name) const;
+	//Indices findClip wouldn't give play clip 0, and with nothing baked the instance holds still
+	sBakedInstance makeInstance(const glm::mat4& model, int clipIndex, float timeInSeconds) const;
+
+	//Every instance in one instanced draw per sub-mesh, with a shader built from animBakedVert.glsl
+	void draw(cShaderProgram& shader, const std::vector<sBakedInstance>& instances);
+
+	void printReport();
+
+	std::vector<sBakedClip> clips;
+	unsigned int numBones;
+	size_t textureBytes;
+
+private:
+	//Above the units cMesh::Draw gives the material textures
+	static const int BAKED_TEXTURE_UNIT = 15;
+	static const GLuint INSTANCE_BINDING = 2;
+
+	cSkinnedMesh* mesh;
+	GLuint texture;
+	GLuint instanceBuffer;
+	size_t instanceCapacity;
+	//Looked up again only when draw is handed a different program
+	int uniformsProgramID;
+	sUniform<int> bakedBonesUniform;
+	sUniform<int> numBonesUsedUniform;
+
+	cBakedAnimation(const cBakedAnimation&);
+	cBakedAnimation& operator=(const cBakedAnimation&);
+};
+
+#endif
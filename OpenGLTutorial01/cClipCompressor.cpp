@@ -0,0 +1,296 @@
+#include "cClipCompressor.h"
+
+#include <chrono>
+#include <iostream>
+#include <cmath>
+#include <cfloat>
+
+#include <glm/gtc/constants.hpp>
+
+namespace
+{
+	const unsigned int MAX_FRAME = 0xffff;
+
+	void quantizeBounded(const glm::vec3& value, const glm::vec3& min, const glm::vec3& step, unsigned short* words)
+	{
+		for (int component = 0; component < 3; component++)
+		{
+			float quantized = step[component] > 0.0f ? (value[component] - min[component]) / step[component] + 0.5f : 0.0f;
+			words[component] = (unsigned short)glm::clamp(quantized, 0.0f, 65535.0f);
+		}
+	}
+
+	//The inverse of cAnimationClip::decodeRotation
+	void quantizeRotation(glm::quat rotation, unsigned short* words)
+	{
+		rotation = glm::normalize(rotation);
+		float components[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+		unsigned int largest = 0;
+		for (unsigned int component = 1; component < 4; component++)
+		{
+			if (fabsf(components[component]) > fabsf(components[largest]))
+				largest = component;
+		}
+		//q and -q are the same rotation, so the left out component is always positive
+		float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+		unsigned int stored = 0;
+		for (unsigned int component = 0; component < 4; component++)
+		{
+			if (component == largest)
+				continue;
+			float value = components[component] * sign * glm::root_two<float>();
+			words[stored] = (unsigned short)glm::clamp((value + 1.0f) * 0.5f * 32767.0f + 0.5f, 0.0f, 32767.0f);
+			stored++;
+		}
+		words[0] |= (unsigned short)((largest >> 1) << 15);
+		words[1] |= (unsigned short)((largest & 1) << 15);
+	}
+
+	float vectorError(const glm::vec3& first, const glm::vec3& second)
+	{
+		return glm::length(first - second);
+	}
+
+	float rotationError(const glm::quat& first, const glm::quat& second)
+	{
+		//Angle between the two from the chord, since acos of their dot product can't resolve anything this small in float.
+		//q and -q are the same rotation, so the shorter chord
+		glm::quat a = glm::normalize(first), b = glm::normalize(second);
+		glm::vec4 difference(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w);
+		glm::vec4 sum(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
+		float chord = glm::min(glm::length(difference), glm::length(sum));
+		return 4.0f * asinf(glm::min(chord * 0.5f, 1.0f));
+	}
+
+	glm::vec3 interpolateVector(const glm::vec3& first, const glm::vec3& second, float factor)
+	{
+		return glm::mix(first, second, factor);
+	}
+
+	glm::quat interpolateRotation(const glm::quat& first, const glm::quat& second, float factor)
+	{
+		return glm::normalize(glm::slerp(first, second, factor));
+	}
+
+	//Frames to keep so that interpolating the decoded values between them lands within tolerance of every original frame.
+	//Greedy: each key reaches as far forward as it can before the next one is needed
+	template <typename tValue>
+	void reduceKeys(const std::vector<tValue>& original, const std::vector<tValue>& decoded, float tolerance,
+		float (*error)(const tValue&, const tValue&), tValue (*interpolate)(const tValue&, const tValue&, float),
+		std::vector<unsigned int>& keptFrames)
+	{
+		keptFrames.clear();
+		keptFrames.push_back(0);
+		unsigned int lastFrame = (unsigned int)original.size() - 1;
+
+		bool constant = true;
+		for (unsigned int frame = 0; frame <= lastFrame && constant; frame++)
+		{
+			constant = error(decoded[0], original[frame]) <= tolerance;
+		}
+		if (constant)
+			return;
+
+		unsigned int start = 0;
+		while (start < lastFrame)
+		{
+			unsigned int end = start + 1;
+			while (end < lastFrame)
+			{
+				unsigned int candidate = end + 1;
+				bool fits = true;
+				for (unsigned int frame = start + 1; frame < candidate && fits; frame++)
+				{
+					float factor = (float)(frame - start) / (candidate - start);
+					fits = error(interpolate(decoded[start], decoded[candidate], factor), original[frame]) <= tolerance;
+				}
+				if (!fits)
+					break;
+				end = candidate;
+			}
+			keptFrames.push_back(end);
+			start = end;
+		}
+	}
+
+	void appendTrack(cAnimationClip& clip, const std::vector<unsigned int>& keptFrames, const std::vector<unsigned short>& words, sCompressedTrack& track)
+	{
+		track.firstKey = (unsigned int)clip.keyFrames.size();
+		track.numKeys = (unsigned int)keptFrames.size();
+		for (unsigned int key = 0; key < keptFrames.size(); key++)
+		{
+			clip.keyFrames.push_back((unsigned short)keptFrames[key]);
+			clip.keyValues.insert(clip.keyValues.end(), words.begin() + keptFrames[key] * 3, words.begin() + keptFrames[key] * 3 + 3);
+		}
+	}
+
+	glm::vec3 sampleCompressedVector(const cAnimationClip& clip, const sCompressedTrack& track, bool isPosition, float animationTime)
+	{
+		float factor;
+		unsigned int key = clip.findCompressedKey(track, animationTime, NULL, factor);
+		glm::vec3 first = isPosition ? clip.decodePosition(key) : clip.decodeScaling(key);
+		if (track.numKeys == 1)
+			return first;
+		return glm::mix(first, isPosition ? clip.decodePosition(key + 1) : clip.decodeScaling(key + 1), factor);
+	}
+}
+
+sClipCompressionSettings::sClipCompressionSettings()
+{
+	this->framesPerSecond = 30.0f;
+	this->positionTolerance = 0.0005f;
+	this->rotationTolerance = 0.0005f;
+	this->scalingTolerance = 0.0005f;
+}
+
+sClipCompressionReport cClipCompressor::compress(cAnimationClip& clip, const sClipCompressionSettings& settings)
+{
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+	sClipCompressionReport report;
+	report.rawBytes = report.compressedBytes = clip.getMemoryBytes();
+	report.rawKeys = report.compressedKeys = 0;
+	report.maxPositionError = report.maxRotationError = report.maxScalingError = 0.0f;
+	report.compressTimeMs = 0.0f;
+	if (clip.isCompressed)
+		return report;
+
+	const cAnimationClip original = clip;
+	float frameTicks = clip.ticksPerSecond / settings.framesPerSecond;
+	unsigned int lastFrame = (unsigned int)ceilf(clip.duration / frameTicks - 0.001f);
+	if (lastFrame > MAX_FRAME)
+	{
+		frameTicks = clip.duration / MAX_FRAME;
+		lastFrame = MAX_FRAME;
+	}
+	lastFrame = glm::max(lastFrame, 1u);
+	const unsigned int numFrames = lastFrame + 1;
+
+	//Every track on the frame grid first, which also gives the bounds to quantize against
+	const unsigned int numChannels = (unsigned int)clip.channels.size();
+	std::vector<std::vector<glm::vec3> > positions(numChannels), scalings(numChannels);
+	std::vector<std::vector<glm::quat> > rotations(numChannels);
+	glm::vec3 positionMin(FLT_MAX), positionMax(-FLT_MAX), scalingMin(FLT_MAX), scalingMax(-FLT_MAX);
+	for (unsigned int channelIndex = 0; channelIndex < numChannels; channelIndex++)
+	{
+		const sAnimationChannel& channel = original.channels[channelIndex];
+		report.rawKeys += (unsigned int)(channel.positionTimes.size() + channel.rotationTimes.size() + channel.scalingTimes.size());
+		positions[channelIndex].resize(numFrames);
+		rotations[channelIndex].resize(numFrames);
+		scalings[channelIndex].resize(numFrames);
+		for (unsigned int frame = 0; frame < numFrames; frame++)
+		{
+			float animationTime = glm::min(frame * frameTicks, clip.duration);
+			positions[channelIndex][frame] = original.sampleVectorKeys(channel.positionTimes, channel.positionValues, animationTime, NULL);
+			rotations[channelIndex][frame] = original.sampleRotationKeys(channel.rotationTimes, channel.rotationValues, animationTime, NULL);
+			scalings[channelIndex][frame] = original.sampleVectorKeys(channel.scalingTimes, channel.scalingValues, animationTime, NULL);
+			positionMin = glm::min(positionMin, positions[channelIndex][frame]);
+			positionMax = glm::max(positionMax, positions[channelIndex][frame]);
+			scalingMin = glm::min(scalingMin, scalings[channelIndex][frame]);
+			scalingMax = glm::max(scalingMax, scalings[channelIndex][frame]);
+		}
+	}
+	if (numChannels == 0)
+		positionMin = positionMax = scalingMin = scalingMax = glm::vec3(0.0f);
+
+	clip.isCompressed = true;
+	clip.uniformKeyStep = 0.0f;
+	clip.frameTicks = frameTicks;
+	clip.positionMin = positionMin;
+	clip.positionStep = (positionMax - positionMin) / 65535.0f;
+	clip.scalingMin = scalingMin;
+	clip.scalingStep = (scalingMax - scalingMin) / 65535.0f;
+	clip.compressedChannels.resize(numChannels);
+	clip.keyFrames.clear();
+	clip.keyValues.clear();
+
+	std::vector<unsigned short> words(numFrames * 3);
+	std::vector<glm::vec3> decodedVectors(numFrames);
+	std::vector<glm::quat> decodedRotations(numFrames);
+	std::vector<unsigned int> keptFrames;
+	for (unsigned int channelIndex = 0; channelIndex < numChannels; channelIndex++)
+	{
+		sAnimationChannel& channel = clip.channels[channelIndex];
+		std::map<std::string, float>::const_iterator itScale = settings.nodeToleranceScales.find(channel.nodeName);
+		float toleranceScale = itScale != settings.nodeToleranceScales.end() ? itScale->second : 1.0f;
+		sCompressedChannel& compressed = clip.compressedChannels[channelIndex];
+
+		//Keys are chosen against the quantized values, so the tolerance covers quantization as well
+		for (unsigned int frame = 0; frame < numFrames; frame++)
+		{
+			quantizeBounded(positions[channelIndex][frame], clip.positionMin, clip.positionStep, &words[frame * 3]);
+			decodedVectors[frame] = clip.positionMin + glm::vec3(words[frame * 3], words[frame * 3 + 1], words[frame * 3 + 2]) * clip.positionStep;
+		}
+		reduceKeys(positions[channelIndex], decodedVectors, settings.positionTolerance * toleranceScale, vectorError, interpolateVector, keptFrames);
+		appendTrack(clip, keptFrames, words, compressed.position);
+
+		for (unsigned int frame = 0; frame < numFrames; frame++)
+		{
+			quantizeRotation(rotations[channelIndex][frame], &words[frame * 3]);
+		}
+		//Decoded through the clip itself, from keys parked past the end of the pool for the moment
+		size_t poolSize = clip.keyValues.size();
+		clip.keyValues.insert(clip.keyValues.end(), words.begin(), words.end());
+		for (unsigned int frame = 0; frame < numFrames; frame++)
+		{
+			decodedRotations[frame] = clip.decodeRotation((unsigned int)(poolSize / 3) + frame);
+		}
+		clip.keyValues.resize(poolSize);
+		reduceKeys(rotations[channelIndex], decodedRotations, settings.rotationTolerance * toleranceScale, rotationError, interpolateRotation, keptFrames);
+		appendTrack(clip, keptFrames, words, compressed.rotation);
+
+		for (unsigned int frame = 0; frame < numFrames; frame++)
+		{
+			quantizeBounded(scalings[channelIndex][frame], clip.scalingMin, clip.scalingStep, &words[frame * 3]);
+			decodedVectors[frame] = clip.scalingMin + glm::vec3(words[frame * 3], words[frame * 3 + 1], words[frame * 3 + 2]) * clip.scalingStep;
+		}
+		reduceKeys(scalings[channelIndex], decodedVectors, settings.scalingTolerance * toleranceScale, vectorError, interpolateVector, keptFrames);
+		appendTrack(clip, keptFrames, words, compressed.scaling);
+
+		//The names stay for binding, the float keys go
+		std::vector<float>().swap(channel.positionTimes);
+		std::vector<glm::vec3>().swap(channel.positionValues);
+		std::vector<float>().swap(channel.rotationTimes);
+		std::vector<glm::quat>().swap(channel.rotationValues);
+		std::vector<float>().swap(channel.scalingTimes);
+		std::vector<glm::vec3>().swap(channel.scalingValues);
+	}
+	clip.keyFrames.shrink_to_fit();
+	clip.keyValues.shrink_to_fit();
+	report.compressedKeys = (unsigned int)clip.keyFrames.size();
+	report.compressedBytes = clip.getMemoryBytes();
+	report.compressTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+	//Checked on every frame and halfway between, where interpolation drifts furthest
+	for (unsigned int channelIndex = 0; channelIndex < numChannels; channelIndex++)
+	{
+		const sAnimationChannel& channel = original.channels[channelIndex];
+		const sCompressedChannel& compressed = clip.compressedChannels[channelIndex];
+		for (unsigned int step = 0; step <= lastFrame * 2; step++)
+		{
+			float animationTime = glm::min(step * 0.5f * frameTicks, clip.duration);
+			glm::vec3 position = sampleCompressedVector(clip, compressed.position, true, animationTime);
+			report.maxPositionError = glm::max(report.maxPositionError,
+				vectorError(position, original.sampleVectorKeys(channel.positionTimes, channel.positionValues, animationTime, NULL)));
+
+			float factor;
+			unsigned int key = clip.findCompressedKey(compressed.rotation, animationTime, NULL, factor);
+			glm::quat rotation = compressed.rotation.numKeys > 1 ? interpolateRotation(clip.decodeRotation(key), clip.decodeRotation(key + 1), factor) : clip.decodeRotation(key);
+			report.maxRotationError = glm::max(report.maxRotationError,
+				rotationError(rotation, original.sampleRotationKeys(channel.rotationTimes, channel.rotationValues, animationTime, NULL)));
+
+			glm::vec3 scaling = sampleCompressedVector(clip, compressed.scaling, false, animationTime);
+			report.maxScalingError = glm::max(report.maxScalingError,
+				vectorError(scaling, original.sampleVectorKeys(channel.scalingTimes, channel.scalingValues, animationTime, NULL)));
+		}
+	}
+	return report;
+}
+
+void cClipCompressor::printReport(const cAnimationClip& clip, const sClipCompressionReport& report)
+{
+	std::cout << "Compressed " << clip.name << ": " << report.rawKeys << " keys in " << report.rawBytes / 1024.0f << " KB to "
+		<< report.compressedKeys << " keys in " << report.compressedBytes / 1024.0f << " KB ("
+		<< (float)report.rawBytes / report.compressedBytes << "x) in " << report.compressTimeMs << " ms, largest error: position "
+		<< report.maxPositionError << ", rotation " << report.maxRotationError << " rad, scale " << report.maxScalingError << std::endl;
+}
@@ -0,0 +1,51 @@
+#ifndef _HG_cClipCompressor_
+#define _HG_cClipCompressor_
+
+#include <string>
+#include <map>
+
+#include "cAnimationClip.h"
+
+struct sClipCompressionSettings
+{
+	//Key times are rounded to frames of this rate. Frame numbers are 16 bit, so very long clips get coarser frames to fit
+	float framesPerSecond;
+	//How far a dropped key may be from the straight line between the keys kept either side of it.
+	//Positions and scales in model units, rotations in radians
+	float positionTolerance;
+	float rotationTolerance;
+	float scalingTolerance;
+	//Multipliers on all three tolerances for particular nodes: below 1 for faces and fingers the camera gets close to,
+	//above 1 for bones nobody will look at
+	std::map<std::string, float> nodeToleranceScales;
+
+	sClipCompressionSettings();
+};
+
+struct sClipCompressionReport
+{
+	size_t rawBytes;
+	size_t compressedBytes;
+	unsigned int rawKeys;
+	unsigned int compressedKeys;
+	//Largest difference from the clip as it was, on every frame and halfway between them
+	float maxPositionError;
+	float maxRotationError;
+	float maxScalingError;
+	float compressTimeMs;
+};
+
+//Rewrites a cAnimationClip's keys in its compressed form. Every track is sampled once per frame, quantized
+//(smallest three quaternions in 48 bits, positions and scales in 16 bits per component across the clip's bounds),
+//then only the keys that straight line interpolation can't rebuild within tolerance are kept.
+//Done once on load; the clip samples the same way afterwards, just from the packed keys
+class cClipCompressor
+{
+public:
+	//Nothing happens to a clip that's already compressed, apart from the report
+	static sClipCompressionReport compress(cAnimationClip& clip, const sClipCompressionSettings& settings = sClipCompressionSettings());
+
+	static void printReport(const cAnimationClip& clip, const sClipCompressionReport& report);
+};
+
+#endif
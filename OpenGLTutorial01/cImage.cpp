@@ -0,0 +1,208 @@
+#include "cImage.h"
+
+#include <SOIL2/SOIL2.h>
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+bool cImage::compressTextures = true;
+
+namespace
+{
+	bool readWholeFile(const std::string& filename, std::vector<unsigned char>& fileData)
+	{
+		std::ifstream file(filename.c_str(), std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+			return false;
+		std::streamsize fileSize = file.tellg();
+		if (fileSize <= 0)
+			return false;
+		fileData.resize((size_t)fileSize);
+		file.seekg(0, std::ios::beg);
+		return (bool)file.read((char*)&fileData[0], fileSize);
+	}
+
+	unsigned long long hashBytes(const unsigned char* data, size_t size)
+	{
+		unsigned long long hash = 14695981039346656037ULL;
+		for (size_t index = 0; index < size; index++)
+		{
+			hash ^= data[index];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+}
+
+bool cImage::isCompressionSupported()
+{
+	GLint numExtensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+	for (GLint index = 0; index < numExtensions; index++)
+	{
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, index);
+		if (extension && std::string(extension) == "GL_EXT_texture_compression_s3tc")
+			return true;
+	}
+	return false;
+}
+
+cImage::cImage()
+{
+	width = 0;
+	height = 0;
+	components = 0;
+	pixels = NULL;
+	contentHash = 0;
+}
+
+cImage::~cImage()
+{
+	free();
+}
+
+bool cImage::load(const std::string& fileToLoad)
+{
+	free();
+	filename = fileToLoad;
+
+	std::string ktxPath = cTextureCompressor::getCachePath(filename);
+	if (compressTextures && cTextureCompressor::isFresh(filename, ktxPath) &&
+		cTextureCompressor::readKTX(ktxPath, compressed))
+	{
+		width = compressed.mips[0].width;
+		height = compressed.mips[0].height;
+		components = compressed.format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT ? 4 : 3;
+		contentHash = hashBytes(compressed.data.data(), compressed.data.size());
+		return true;
+	}
+
+	//Read the file once, hash it, then decode from memory
+	std::vector<unsigned char> fileData;
+	if (!readWholeFile(filename, fileData))
+		return false;
+	contentHash = hashBytes(&fileData[0], fileData.size());
+
+	pixels = SOIL_load_image_from_memory(&fileData[0], (int)fileData.size(), &width, &height, &components, SOIL_LOAD_AUTO);
+	if (pixels == NULL)
+		return false;
+
+	if (compressTextures)
+	{
+		//Transcode on demand, so the next run finds the .ktx and skips the decode entirely
+		if (cTextureCompressor::compress(pixels, width, height, components, compressed))
+		{
+			if (!cTextureCompressor::writeKTX(ktxPath, compressed))
+				std::cout << "Couldn't write " << ktxPath << std::endl;
+			SOIL_free_image_data(pixels);
+			pixels = NULL;
+		}
+	}
+	return true;
+}
+
+void cImage::free()
+{
+	if (pixels)
+	{
+		SOIL_free_image_data(pixels);
+		pixels = NULL;
+	}
+	compressed.mips.clear();
+	compressed.data.clear();
+}
+
+bool cImage::isLoaded()
+{
+	return pixels != NULL || isCompressed();
+}
+
+bool cImage::isCompressed()
+{
+	return !compressed.mips.empty();
+}
+
+const unsigned char* cImage::getData()
+{
+	return isCompressed() ? compressed.data.data() : pixels;
+}
+
+size_t cImage::getDataSize()
+{
+	if (isCompressed())
+		return compressed.data.size();
+	return (size_t)width * height * components;
+}
+
+GLenum cImage::getFormat()
+{
+	if (components == 1)
+		return GL_RED;
+	else if (components == 4)
+		return GL_RGBA;
+	return GL_RGB;
+}
+
+size_t cImage::getGPUSizeBytes(GLenum internalFormat)
+{
+	if (isCompressed())
+		return compressed.data.size();
+
+	size_t bytesPerPixel = 4;
+	if (internalFormat == GL_RED)
+		bytesPerPixel = 1;
+	else if (internalFormat == GL_RGB)
+		bytesPerPixel = 3;
+
+	//A full mip chain adds about a third on top of the base level
+	size_t baseBytes = (size_t)width * height * bytesPerPixel;
+	return baseBytes + baseBytes / 3;
+}
+
+unsigned int cImage::uploadTexture2D(GLenum internalFormat)
+{
+	unsigned int textureID;
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+
+	if (isCompressed())
+	{
+		//The block format is fixed at compression time, so internalFormat has no say here
+		for (int level = 0; level < compressed.mips.size(); level++)
+		{
+			const sCompressedMip& mip = compressed.mips[level];
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, compressed.format, mip.width, mip.height, 0,
+				(GLsizei)mip.size, &compressed.data[mip.offset]);
+		}
+	}
+	else
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, getFormat(), GL_UNSIGNED_BYTE, pixels);
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	return textureID;
+}
+
+void cImage::uploadCubeFace(unsigned int face, GLenum internalFormat)
+{
+	if (isCompressed())
+	{
+		for (int level = 0; level < compressed.mips.size(); level++)
+		{
+			const sCompressedMip& mip = compressed.mips[level];
+			glCompressedTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, compressed.format, mip.width, mip.height, 0,
+				(GLsizei)mip.size, &compressed.data[mip.offset]);
+		}
+		return;
+	}
+	glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+		0, internalFormat, width, height, 0, getFormat(), GL_UNSIGNED_BYTE, pixels
+	);
+}
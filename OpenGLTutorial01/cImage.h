@@ -0,0 +1,55 @@
+#ifndef _HG_cImage_
+#define _HG_cImage_
+
+#include <string>
+
+#include <glad/glad.h>
+
+#include "cTextureCompressor.h"
+
+//Decoded pixels sitting in CPU memory. Decoding touches no GL state,
+//so load() can run on any thread; the upload functions need the context thread.
+//With compressTextures on, load() ends with a block compressed mip chain instead of raw pixels
+class cImage
+{
+public:
+	cImage();
+	~cImage();
+
+	bool load(const std::string& filename);
+	void free();
+
+	//Uses <file>.ktx when it is fresh, otherwise compresses the image and writes one. On by default
+	static bool compressTextures;
+	//BC1/BC3 need GL_EXT_texture_compression_s3tc, which isn't core. Needs a current context
+	static bool isCompressionSupported();
+
+	bool isLoaded();
+	bool isCompressed();
+	//What actually gets sent to the GPU: every compressed mip level, or the raw base level
+	const unsigned char* getData();
+	size_t getDataSize();
+
+	GLenum getFormat();
+	//Size on the GPU once uploaded with a full mip chain
+	size_t getGPUSizeBytes(GLenum internalFormat);
+	//Creates, fills and mipmaps a GL_TEXTURE_2D, returning its ID
+	unsigned int uploadTexture2D(GLenum internalFormat);
+	//Fills one face of the currently bound cube map
+	void uploadCubeFace(unsigned int face, GLenum internalFormat);
+
+	std::string filename;
+	int width;
+	int height;
+	int components;
+	unsigned char* pixels;
+	sCompressedTexture compressed;
+	//FNV-1a of the file as it was on disk (of the .ktx when loaded from one)
+	unsigned long long contentHash;
+
+private:
+	cImage(const cImage&);
+	cImage& operator=(const cImage&);
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include "cLightClusterPass.h"
+
+#include <iostream>
+#include <string>
+
+void cLightClusterPass::defineShaderConstants()
+{
+	cShader::setDefine("CLUSTERS_X", std::to_string(CLUSTERS_X));
+	cShader::setDefine("CLUSTERS_Y", std::to_string(CLUSTERS_Y));
+	cShader::setDefine("CLUSTERS_Z", std::to_string(CLUSTERS_Z));
+	cShader::setDefine("MAX_CLUSTER_LIGHTS", std::to_string(MAX_CLUSTER_LIGHTS));
+}
+
+cLightClusterPass::cLightClusterPass(unsigned int maxViews)
+{
+	defineShaderConstants();
+	this->program.compileComputeProgram("assets/shaders/", "lightClusterComp.glsl");
+	this->lastDispatches = 0;
+
+	this->countBuffers.resize(maxViews);
+	this->indexBuffers.resize(maxViews);
+	this->overflowBuffers.resize(maxViews);
+	this->overflowFences.resize(maxViews, 0);
+	sClusterOverflow noOverflow = { 0, 0, 0 };
+	this->overflows.resize(maxViews, noOverflow);
+	this->reportedLargest.resize(maxViews, 0);
+	glGenBuffers(maxViews, this->countBuffers.data());
+	glGenBuffers(maxViews, this->indexBuffers.data());
+	glGenBuffers(maxViews, this->overflowBuffers.data());
+	for (unsigned int viewIndex = 0; viewIndex < maxViews; viewIndex++)
+	{
+		//Two counts per cluster, and room for a full list in every cluster so no counters are shared between them
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->countBuffers[viewIndex]);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, NUM_CLUSTERS * 2 * sizeof(GLuint), NULL, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->indexBuffers[viewIndex]);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, NUM_CLUSTERS * MAX_CLUSTER_LIGHTS * sizeof(GLuint), NULL, GL_DYNAMIC_COPY);
+		//Laid out like sClusterOverflow, read back once the GPU is done with it
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->overflowBuffers[viewIndex]);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(sClusterOverflow), NULL, GL_DYNAMIC_READ);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+cLightClusterPass::~cLightClusterPass()
+{
+	for (unsigned int viewIndex = 0; viewIndex < this->overflowFences.size(); viewIndex++)
+	{
+		if (this->overflowFences[viewIndex])
+			glDeleteSync(this->overflowFences[viewIndex]);
+	}
+	glDeleteBuffers((GLsizei)this->countBuffers.size(), this->countBuffers.data());
+	glDeleteBuffers((GLsizei)this->indexBuffers.size(), this->indexBuffers.data());
+	glDeleteBuffers((GLsizei)this->overflowBuffers.size(), this->overflowBuffers.data());
+	glDeleteProgram(this->program.ID);
+}
+
+void cLightClusterPass::cull(unsigned int viewIndex)
+{
+	this->lastDispatches = 0;
+	if (viewIndex >= this->countBuffers.size())
+		return;
+
+	this->readOverflow(viewIndex);
+
+	this->bindView(viewIndex);
+	GLuint zero = 0;
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OVERFLOW_BINDING, this->overflowBuffers[viewIndex]);
+	glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+	this->program.useProgram();
+	glDispatchCompute((NUM_CLUSTERS + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+	this->lastDispatches++;
+
+	//The view's fragment shaders read the lists as storage buffers, and readOverflow reads its buffer back
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+	if (this->overflowFences[viewIndex])
+		glDeleteSync(this->overflowFences[viewIndex]);
+	this->overflowFences[viewIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void cLightClusterPass::bindView(unsigned int viewIndex)
+{
+	if (viewIndex >= this->countBuffers.size())
+		return;
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COUNTS_BINDING, this->countBuffers[viewIndex]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INDICES_BINDING, this->indexBuffers[viewIndex]);
+}
+
+const sClusterOverflow& cLightClusterPass::getOverflow(unsigned int viewIndex) const
+{
+	return this->overflows[viewIndex];
+}
+
+void cLightClusterPass::readOverflow(unsigned int viewIndex)
+{
+	//Never waits. A cull still running just gets skipped, and the next one is read instead
+	GLsync fence = this->overflowFences[viewIndex];
+	if (!fence)
+		return;
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		return;
+	glDeleteSync(fence);
+	this->overflowFences[viewIndex] = 0;
+
+	sClusterOverflow& overflow = this->overflows[viewIndex];
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->overflowBuffers[viewIndex]);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(sClusterOverflow), &overflow);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	if (overflow.clusters > 0 && overflow.largestCluster > this->reportedLargest[viewIndex])
+	{
+		std::cout << "View " << viewIndex << ": " << overflow.clusters << " light clusters have more than "
+			<< MAX_CLUSTER_LIGHTS << " lights (" << overflow.largestCluster << " in the largest), "
+			<< overflow.lights << " lights left out" << std::endl;
+		this->reportedLargest[viewIndex] = overflow.largestCluster;
+	}
+}
@@ -0,0 +1,74 @@
+#ifndef _HG_cLightClusterPass_
+#define _HG_cLightClusterPass_
+
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "cShaderProgram.h"
+
+//What the last read back cull of a view couldn't fit
+struct sClusterOverflow
+{
+	//Clusters with more lights reaching them than MAX_CLUSTER_LIGHTS, and how many lights those left out
+	unsigned int clusters;
+	unsigned int lights;
+	//Most lights reaching any one cluster, listed or not
+	unsigned int largestCluster;
+};
+
+//Clustered forward lighting: cuts each view's frustum into a grid of boxes and lists the point and spot lights
+//reaching each one (lightClusterComp.glsl), so fragShader.glsl only lights a fragment with the lights in its box.
+//Every view gets its own lists, so the next view's pass never overwrites lists a draw is still reading.
+//Needs the context thread, and has to go before the context does
+class cLightClusterPass
+{
+public:
+	//The shaders get these through defineShaderConstants, clusters.glsl doesn't repeat them
+	static const unsigned int CLUSTERS_X = 16;
+	static const unsigned int CLUSTERS_Y = 9;
+	static const unsigned int CLUSTERS_Z = 24;
+	//Lights past this many in one cluster are left out of it. Spot lights are listed first, so it's point lights that get dropped
+	static const unsigned int MAX_CLUSTER_LIGHTS = 128;
+	static const GLuint COUNTS_BINDING = 6;
+	static const GLuint INDICES_BINDING = 7;
+	static const GLuint OVERFLOW_BINDING = 8;
+
+	//Before compiling any program that includes clusters.glsl
+	static void defineShaderConstants();
+
+	cLightClusterPass(unsigned int maxViews);
+	~cLightClusterPass();
+
+	//Right after cSharedUniforms::setView, and after cLightManager::update for the frame.
+	//Builds the view's lists and leaves them bound for its draws
+	void cull(unsigned int viewIndex);
+	//Binds lists already built this frame, to go back to a view without culling it again
+	void bindView(unsigned int viewIndex);
+
+	//From the view's last cull the GPU has finished, so a frame or so behind. Going over is also printed
+	//the first time it happens, and again if the largest cluster grows
+	const sClusterOverflow& getOverflow(unsigned int viewIndex) const;
+
+	unsigned int lastDispatches;
+
+private:
+	static const unsigned int GROUP_SIZE = 64;
+	static const unsigned int NUM_CLUSTERS = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+
+	cShaderProgram program;
+	//One of each per view
+	std::vector<GLuint> countBuffers;
+	std::vector<GLuint> indexBuffers;
+	std::vector<GLuint> overflowBuffers;
+	std::vector<GLsync> overflowFences;
+	std::vector<sClusterOverflow> overflows;
+	std::vector<unsigned int> reportedLargest;
+
+	void readOverflow(unsigned int viewIndex);
+
+	cLightClusterPass(const cLightClusterPass&);
+	cLightClusterPass& operator=(const cLightClusterPass&);
+};
+
+#endif
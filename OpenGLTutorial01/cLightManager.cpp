@@ -0,0 +1,283 @@
+#include "cLightManager.h"
+
+#include <algorithm>
+
+namespace
+{
+	//The count, padded out to the array's 16 byte alignment
+	const size_t HEADER_BYTES = 16;
+	//So the first few adds don't each grow the buffer
+	const size_t MIN_CAPACITY = 8;
+	//A light's reach ends where it adds less than this to a channel, so culling it past there can't be seen
+	const float LIGHT_CUTOFF = 1.0f / 256.0f;
+	//For lights that never fade (no linear or quadratic term): big enough that nothing culls them
+	const float UNBOUNDED_RADIUS = 1.0e6f;
+
+	//Solves constant + linear * d + quadratic * d^2 = brightest / LIGHT_CUTOFF for d
+	float getLightRadius(float constant, float linear, float quadratic, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular)
+	{
+		glm::vec3 total = ambient + diffuse + specular;
+		float brightest = glm::max(total.x, glm::max(total.y, total.z));
+		float reach = brightest / LIGHT_CUTOFF - constant;
+		if (reach <= 0.0f)
+			return 0.0f;
+		if (quadratic > 0.0f)
+			return (-linear + glm::sqrt(linear * linear + 4.0f * quadratic * reach)) / (2.0f * quadratic);
+		if (linear > 0.0f)
+			return reach / linear;
+		return UNBOUNDED_RADIUS;
+	}
+
+	//Directional lights reach everywhere and have no radius to fill in
+	void fillRadius(sDirectionalLight&)
+	{
+	}
+
+	void fillRadius(sPointLight& light)
+	{
+		light.radius = getLightRadius(light.constant, light.linear, light.quadratic, light.ambient, light.diffuse, light.specular);
+	}
+
+	void fillRadius(sSpotLight& light)
+	{
+		light.radius = getLightRadius(light.constant, light.linear, light.quadratic, light.ambient, light.diffuse, light.specular);
+	}
+}
+
+sDirectionalLight::sDirectionalLight()
+{
+	this->direction = glm::vec3(0.0f, -1.0f, 0.0f);
+	this->ambient = glm::vec3(0.0f);
+	this->diffuse = glm::vec3(0.0f);
+	this->specular = glm::vec3(0.0f);
+	this->padding0 = this->padding1 = this->padding2 = this->padding3 = 0.0f;
+}
+
+sPointLight::sPointLight()
+{
+	this->position = glm::vec3(0.0f);
+	this->ambient = glm::vec3(0.0f);
+	this->diffuse = glm::vec3(0.0f);
+	this->specular = glm::vec3(0.0f);
+	this->constant = 1.0f;
+	this->linear = 0.0f;
+	this->quadratic = 0.0f;
+	this->radius = 0.0f;
+}
+
+sSpotLight::sSpotLight()
+{
+	this->position = glm::vec3(0.0f);
+	this->direction = glm::vec3(0.0f, -1.0f, 0.0f);
+	this->ambient = glm::vec3(0.0f);
+	this->diffuse = glm::vec3(0.0f);
+	this->specular = glm::vec3(0.0f);
+	this->constant = 1.0f;
+	this->linear = 0.0f;
+	this->quadratic = 0.0f;
+	this->cutOff = 1.0f;
+	this->outerCutOff = 1.0f;
+	this->radius = 0.0f;
+	this->padding0 = this->padding1 = this->padding2 = 0.0f;
+}
+
+template <typename tLight>
+void sLightArray<tLight>::create(GLuint binding)
+{
+	this->binding = binding;
+	this->capacity = 0;
+	this->firstDirty = 0;
+	this->endDirty = 0;
+	this->countDirty = true;
+	glGenBuffers(1, &this->buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, HEADER_BYTES, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+template <typename tLight>
+void sLightArray<tLight>::destroy()
+{
+	glDeleteBuffers(1, &this->buffer);
+	this->buffer = 0;
+}
+
+template <typename tLight>
+unsigned int sLightArray<tLight>::add(const tLight& light)
+{
+	this->lights.push_back(light);
+	this->markDirty(this->lights.size() - 1, this->lights.size());
+	this->countDirty = true;
+	return (unsigned int)this->lights.size() - 1;
+}
+
+template <typename tLight>
+tLight& sLightArray<tLight>::edit(unsigned int index)
+{
+	this->markDirty(index, index + 1);
+	return this->lights[index];
+}
+
+template <typename tLight>
+void sLightArray<tLight>::remove(unsigned int index)
+{
+	this->lights[index] = this->lights.back();
+	this->lights.pop_back();
+	if (index < this->lights.size())
+		this->markDirty(index, index + 1);
+	this->countDirty = true;
+}
+
+template <typename tLight>
+void sLightArray<tLight>::markDirty(size_t first, size_t end)
+{
+	if (this->firstDirty >= this->endDirty)
+	{
+		this->firstDirty = first;
+		this->endDirty = end;
+		return;
+	}
+	this->firstDirty = std::min(this->firstDirty, first);
+	this->endDirty = std::max(this->endDirty, end);
+}
+
+template <typename tLight>
+size_t sLightArray<tLight>::upload()
+{
+	size_t bytes = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->buffer);
+
+	//Growing loses the old contents, so everything goes up again
+	if (this->lights.size() > this->capacity)
+	{
+		this->capacity = std::max(std::max(this->lights.size(), this->capacity + this->capacity / 2), MIN_CAPACITY);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, HEADER_BYTES + this->capacity * sizeof(tLight), NULL, GL_DYNAMIC_DRAW);
+		this->countDirty = true;
+		this->firstDirty = 0;
+		this->endDirty = this->lights.size();
+	}
+
+	if (this->countDirty)
+	{
+		GLuint header[4] = { (GLuint)this->lights.size(), 0, 0, 0 };
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, HEADER_BYTES, header);
+		bytes += HEADER_BYTES;
+		this->countDirty = false;
+	}
+
+	//Removing can leave the range hanging off the end
+	this->endDirty = std::min(this->endDirty, this->lights.size());
+	if (this->firstDirty < this->endDirty)
+	{
+		for (size_t index = this->firstDirty; index < this->endDirty; index++)
+		{
+			fillRadius(this->lights[index]);
+		}
+		size_t rangeBytes = (this->endDirty - this->firstDirty) * sizeof(tLight);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, HEADER_BYTES + this->firstDirty * sizeof(tLight), rangeBytes, &this->lights[this->firstDirty]);
+		bytes += rangeBytes;
+	}
+	this->firstDirty = 0;
+	this->endDirty = 0;
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, this->binding, this->buffer);
+	return bytes;
+}
+
+cLightManager::cLightManager()
+{
+	this->directionalLights.create(DIRECTIONAL_BINDING);
+	this->pointLights.create(POINT_BINDING);
+	this->spotLights.create(SPOT_BINDING);
+	this->lastUploadBytes = 0;
+}
+
+cLightManager::~cLightManager()
+{
+	this->directionalLights.destroy();
+	this->pointLights.destroy();
+	this->spotLights.destroy();
+}
+
+unsigned int cLightManager::add(const sDirectionalLight& light)
+{
+	return this->directionalLights.add(light);
+}
+
+unsigned int cLightManager::add(const sPointLight& light)
+{
+	return this->pointLights.add(light);
+}
+
+unsigned int cLightManager::add(const sSpotLight& light)
+{
+	return this->spotLights.add(light);
+}
+
+const sDirectionalLight& cLightManager::getDirectionalLight(unsigned int index) const
+{
+	return this->directionalLights.lights[index];
+}
+
+const sPointLight& cLightManager::getPointLight(unsigned int index) const
+{
+	return this->pointLights.lights[index];
+}
+
+const sSpotLight& cLightManager::getSpotLight(unsigned int index) const
+{
+	return this->spotLights.lights[index];
+}
+
+sDirectionalLight& cLightManager::editDirectionalLight(unsigned int index)
+{
+	return this->directionalLights.edit(index);
+}
+
+sPointLight& cLightManager::editPointLight(unsigned int index)
+{
+	return this->pointLights.edit(index);
+}
+
+sSpotLight& cLightManager::editSpotLight(unsigned int index)
+{
+	return this->spotLights.edit(index);
+}
+
+void cLightManager::removeDirectionalLight(unsigned int index)
+{
+	this->directionalLights.remove(index);
+}
+
+void cLightManager::removePointLight(unsigned int index)
+{
+	this->pointLights.remove(index);
+}
+
+void cLightManager::removeSpotLight(unsigned int index)
+{
+	this->spotLights.remove(index);
+}
+
+unsigned int cLightManager::getNumDirectionalLights() const
+{
+	return (unsigned int)this->directionalLights.lights.size();
+}
+
+unsigned int cLightManager::getNumPointLights() const
+{
+	return (unsigned int)this->pointLights.lights.size();
+}
+
+unsigned int cLightManager::getNumSpotLights() const
+{
+	return (unsigned int)this->spotLights.lights.size();
+}
+
+void cLightManager::update()
+{
+	this->lastUploadBytes = this->directionalLights.upload();
+	this->lastUploadBytes += this->pointLights.upload();
+	this->lastUploadBytes += this->spotLights.upload();
+}
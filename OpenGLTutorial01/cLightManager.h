@@ -0,0 +1,137 @@
+#ifndef _HG_cLightManager_
+#define _HG_cLightManager_
+
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+//The light structs are std430, the same as in assets/shaders/lights.glsl: each vec3 shares its 16 bytes with the float after it
+struct sDirectionalLight
+{
+	glm::vec3 direction;
+	float padding0;
+	glm::vec3 ambient;
+	float padding1;
+	glm::vec3 diffuse;
+	float padding2;
+	glm::vec3 specular;
+	float padding3;
+
+	sDirectionalLight();
+};
+
+struct sPointLight
+{
+	glm::vec3 position;
+	float constant;
+	glm::vec3 ambient;
+	float linear;
+	glm::vec3 diffuse;
+	float quadratic;
+	glm::vec3 specular;
+	//Filled in by cLightManager from the attenuation and colours: how far out the light is worth drawing
+	float radius;
+
+	sPointLight();
+};
+
+struct sSpotLight
+{
+	glm::vec3 position;
+	float constant;
+	glm::vec3 direction;
+	float linear;
+	glm::vec3 ambient;
+	float quadratic;
+	glm::vec3 diffuse;
+	float cutOff;			//Cosine of the inner angle
+	glm::vec3 specular;
+	float outerCutOff;		//Cosine of the outer angle
+	//Filled in by cLightManager, the same as sPointLight::radius. The cone is culled as the whole sphere
+	float radius;
+	float padding0;
+	float padding1;
+	float padding2;
+
+	sSpotLight();
+};
+
+//One kind of light and the storage buffer it goes up in: a count, padded to 16 bytes, then the lights back to back.
+//Edits mark a range dirty, and upload only sends that range (and the count, if it moved)
+template <typename tLight>
+struct sLightArray
+{
+	std::vector<tLight> lights;
+	GLuint buffer;
+	GLuint binding;
+	//Lights the buffer has room for
+	size_t capacity;
+	//[firstDirty, endDirty) hasn't been uploaded yet
+	size_t firstDirty;
+	size_t endDirty;
+	bool countDirty;
+
+	//An empty buffer holding just the count, bound at binding on every upload
+	void create(GLuint binding);
+	void destroy();
+	unsigned int add(const tLight& light);
+	tLight& edit(unsigned int index);
+	//Moves the last light into index, so the other indices stay put but the last one's becomes index
+	void remove(unsigned int index);
+	//Fills in the radius of each dirty light and sends them. Returns the bytes sent
+	size_t upload();
+	void markDirty(size_t first, size_t end);
+};
+
+//Every light in the scene, kept in storage buffers fragShader.glsl loops over. Adding a light is one more entry in
+//an array: no shader edits and no uniform calls. Lights that haven't changed since the last update aren't sent again.
+//Needs the context thread, and has to go before the context does
+class cLightManager
+{
+public:
+	static const GLuint DIRECTIONAL_BINDING = 3;
+	static const GLuint POINT_BINDING = 4;
+	static const GLuint SPOT_BINDING = 5;
+
+	cLightManager();
+	~cLightManager();
+
+	//Each returns the new light's index
+	unsigned int add(const sDirectionalLight& light);
+	unsigned int add(const sPointLight& light);
+	unsigned int add(const sSpotLight& light);
+
+	const sDirectionalLight& getDirectionalLight(unsigned int index) const;
+	const sPointLight& getPointLight(unsigned int index) const;
+	const sSpotLight& getSpotLight(unsigned int index) const;
+	//For changing a light. Marks it to be uploaded on the next update
+	sDirectionalLight& editDirectionalLight(unsigned int index);
+	sPointLight& editPointLight(unsigned int index);
+	sSpotLight& editSpotLight(unsigned int index);
+
+	//The last light of that kind takes the removed one's index
+	void removeDirectionalLight(unsigned int index);
+	void removePointLight(unsigned int index);
+	void removeSpotLight(unsigned int index);
+
+	unsigned int getNumDirectionalLights() const;
+	unsigned int getNumPointLights() const;
+	unsigned int getNumSpotLights() const;
+
+	//Once a frame, before drawing anything lit. Sends whatever changed and binds the buffers
+	void update();
+
+	//Bytes sent by the last update, 0 once the lights have settled
+	size_t lastUploadBytes;
+
+private:
+	sLightArray<sDirectionalLight> directionalLights;
+	sLightArray<sPointLight> pointLights;
+	sLightArray<sSpotLight> spotLights;
+
+	cLightManager(const cLightManager&);
+	cLightManager& operator=(const cLightManager&);
+};
+
+#endif
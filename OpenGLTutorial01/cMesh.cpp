@@ -6,102 +6,192 @@ cMesh::cMesh(std::vector<sVertex> theVertices, std::vector<unsigned int> theIndi
 	indices = theIndices;
 	textures = theTextures;
 	skinnedMesh = false;
-	setupMesh();
+	compactMesh = false;
+	setupMesh(&vertices[0], vertices.size() * sizeof(sVertex), &indices[0], indices.size());
 }
 
-cMesh::cMesh(std::vector<sSkinnedMeshVertex> theVertices, std::vector<unsigned int> theIndices, std::vector<sTexture> theTextures)
+cMesh::cMesh(std::vector<sPackedSkinnedVertex> theVertices, std::vector<unsigned int> theIndices, std::vector<sTexture> theTextures)
 {
 	skinnedVertices = theVertices;
 	indices = theIndices;
 	textures = theTextures;
 	skinnedMesh = true;
-	setupMesh();
+	compactMesh = false;
+	setupMesh(&skinnedVertices[0], skinnedVertices.size() * sizeof(sPackedSkinnedVertex), &indices[0], indices.size());
 }
 
-void cMesh::Draw(cShaderProgram shader)
+cMesh::cMesh(const sVertex* theVertices, unsigned int numVertices, const unsigned int* theIndices, unsigned int numIndices, std::vector<sTexture> theTextures)
 {
-	unsigned int diffuseNum = 1;
-	unsigned int specularNum = 1;
+	textures = theTextures;
+	skinnedMesh = false;
+	compactMesh = false;
+	setupMesh(theVertices, numVertices * sizeof(sVertex), theIndices, numIndices);
+}
+
+cMesh::cMesh(const sCompactMeshData& data, std::vector<sTexture> theTextures)
+{
+	textures = theTextures;
+	skinnedMesh = false;
+	compactMesh = true;
+	positionMin = data.positionMin;
+	positionExtent = data.positionExtent;
+	texCoordMin = data.texCoordMin;
+	texCoordExtent = data.texCoordExtent;
+	setupMesh(data.vertices.data(), data.vertices.size() * sizeof(sCompactVertex), data.indices.data(), data.indices.size());
+}
+
+void cMesh::Draw(cShaderProgram& shader, unsigned int numInstances)
+{
+	this->bindMaterial(shader);
+
+	//Once all textures are bound, draw
+	glBindVertexArray(VAO);
+	if (numInstances > 1)
+		glDrawElementsInstanced(GL_TRIANGLES, this->numIndices, GL_UNSIGNED_INT, 0, numInstances);
+	else
+		glDrawElements(GL_TRIANGLES, this->numIndices, GL_UNSIGNED_INT, 0);
+	glBindVertexArray(0);
+}
 
+void cMesh::DrawWithVertexArray(cShaderProgram& shader, unsigned int vertexArray)
+{
+	this->bindMaterial(shader);
+
+	glBindVertexArray(vertexArray);
+	glDrawElements(GL_TRIANGLES, this->numIndices, GL_UNSIGNED_INT, 0);
+	glBindVertexArray(0);
+}
+
+unsigned int cMesh::GetVertexBuffer() const
+{
+	return this->VBO;
+}
+
+unsigned int cMesh::GetIndexBuffer() const
+{
+	return this->EBO;
+}
+
+unsigned int cMesh::GetNumVertices() const
+{
+	return this->numVertices;
+}
+
+unsigned int cMesh::GetNumIndices() const
+{
+	return this->numIndices;
+}
+
+void cMesh::bindMaterial(cShaderProgram& shader)
+{
+	const sMaterialUniforms& uniforms = this->findMaterialUniforms(shader);
 	for (int index = 0; index < textures.size(); index++)
 	{
 		glActiveTexture(GL_TEXTURE0 + index);
+		uniforms.textures[index].set(index);
+		glBindTexture(GL_TEXTURE_2D, textures[index].ID);
+	}
+	glActiveTexture(GL_TEXTURE0);
+
+	//Always set, so a full float mesh drawn after a compact one isn't decoded by mistake
+	uniforms.compactVertices.set(compactMesh);
+	if (compactMesh)
+	{
+		uniforms.positionMin.set(positionMin);
+		uniforms.positionExtent.set(positionExtent);
+		uniforms.texCoordMin.set(texCoordMin);
+		uniforms.texCoordExtent.set(texCoordExtent);
+	}
+}
+
+const cMesh::sMaterialUniforms& cMesh::findMaterialUniforms(cShaderProgram& shader)
+{
+	for (int index = 0; index < this->materialUniforms.size(); index++)
+	{
+		if (this->materialUniforms[index].programID == shader.ID)
+			return this->materialUniforms[index];
+	}
 
+	sMaterialUniforms uniforms;
+	uniforms.programID = shader.ID;
+	unsigned int diffuseNum = 1;
+	unsigned int specularNum = 1;
+	for (int index = 0; index < textures.size(); index++)
+	{
 		std::string number;
 		std::string name = textures[index].type;
 		if (name == "texture_diffuse")
 			number = std::to_string(diffuseNum++);
 		else if (name == "texture_specular")
 			number = std::to_string(specularNum++);
-
-		shader.setFloat(("material." + name + number).c_str(), index);
-		glBindTexture(GL_TEXTURE_2D, textures[index].ID);
+		uniforms.textures.push_back(shader.getUniform<int>("material." + name + number));
 	}
-	glActiveTexture(GL_TEXTURE0);
-
-	//Once all textures are bound, draw
-	glBindVertexArray(VAO);
-	glDrawElements(GL_TRIANGLES, this->indices.size(), GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
+	uniforms.compactVertices = shader.getUniform<bool>("compactVertices");
+	uniforms.positionMin = shader.getUniform<glm::vec3>("positionMin");
+	uniforms.positionExtent = shader.getUniform<glm::vec3>("positionExtent");
+	uniforms.texCoordMin = shader.getUniform<glm::vec2>("texCoordMin");
+	uniforms.texCoordExtent = shader.getUniform<glm::vec2>("texCoordExtent");
+	this->materialUniforms.push_back(uniforms);
+	return this->materialUniforms.back();
 }
 
-void cMesh::setupMesh()
+void cMesh::setupMesh(const void* vertexData, unsigned int vertexBytes, const unsigned int* indexData, unsigned int indexCount)
 {
+	numIndices = indexCount;
+	numVertices = vertexBytes / (skinnedMesh ? sizeof(sPackedSkinnedVertex) : (compactMesh ? sizeof(sCompactVertex) : sizeof(sVertex)));
+
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glGenBuffers(1, &EBO);
+	//Bind VAO
+	glBindVertexArray(VAO);
+	//Set vertex data
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertexData, GL_STATIC_DRAW);
+	//Set index data
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indexData, GL_STATIC_DRAW);
 
 	if (skinnedMesh)
 	{
-		glGenVertexArrays(1, &VAO);
-		glGenBuffers(1, &VBO);
-		glGenBuffers(1, &EBO);
-		//Bind VAO
-		glBindVertexArray(VAO);
-		//Set vertex data
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glBufferData(GL_ARRAY_BUFFER, skinnedVertices.size() * sizeof(sSkinnedMeshVertex), &skinnedVertices[0], GL_STATIC_DRAW);
-		//Set index data
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
 		//Set vertex attributes
 		//Position
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(sSkinnedMeshVertex), (void*)0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(sPackedSkinnedVertex), (void*)0);
 		glEnableVertexAttribArray(0);
-		//Normals
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(sSkinnedMeshVertex), (void*)offsetof(sSkinnedMeshVertex, Normal));
+		//Tangent frame quaternion, replaces the separate normal, tangent and bitangent
+		glVertexAttribPointer(1, 4, GL_SHORT, GL_TRUE, sizeof(sPackedSkinnedVertex), (void*)offsetof(sPackedSkinnedVertex, TangentFrame));
 		glEnableVertexAttribArray(1);
 		//Texture coordinates
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(sSkinnedMeshVertex), (void*)offsetof(sSkinnedMeshVertex, TexCoords));
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(sPackedSkinnedVertex), (void*)offsetof(sPackedSkinnedVertex, TexCoords));
 		glEnableVertexAttribArray(2);
-		//Tangent
-		glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(sSkinnedMeshVertex), (void*)offsetof(sSkinnedMeshVertex, Tangent));
-		glEnableVertexAttribArray(3);
-		//BiTangent
-		glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(sSkinnedMeshVertex), (void*)offsetof(sSkinnedMeshVertex, BiTangent));
-		glEnableVertexAttribArray(4);
-		//Bone IDs
-		glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(sSkinnedMeshVertex), (void*)offsetof(sSkinnedMeshVertex, BoneID));
+		//Bone IDs, as integers so the shader doesn't have to convert them back
+		glVertexAttribIPointer(5, 4, GL_UNSIGNED_BYTE, sizeof(sPackedSkinnedVertex), (void*)offsetof(sPackedSkinnedVertex, BoneID));
 		glEnableVertexAttribArray(5);
 		//Bone Weights
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(sSkinnedMeshVertex), (void*)offsetof(sSkinnedMeshVertex, BoneWeights));
+		glVertexAttribPointer(6, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(sPackedSkinnedVertex), (void*)offsetof(sPackedSkinnedVertex, BoneWeights));
 		glEnableVertexAttribArray(6);
 
 		glBindVertexArray(0);
 	}
 
-	else
+	else if (compactMesh)
 	{
-		glGenVertexArrays(1, &VAO);
-		glGenBuffers(1, &VBO);
-		glGenBuffers(1, &EBO);
-		//Bind VAO
-		glBindVertexArray(VAO);
-		//Set vertex data
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(sVertex), &vertices[0], GL_STATIC_DRAW);
-		//Set index data
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+		//Set vertex attributes. All normalized, so the shader still sees floats
+		//Position, unorm16 inside the bounds
+		glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(sCompactVertex), (void*)0);
+		glEnableVertexAttribArray(0);
+		//Normals, octahedral snorm16 (z reads as 0)
+		glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(sCompactVertex), (void*)offsetof(sCompactVertex, Normal));
+		glEnableVertexAttribArray(1);
+		//Texture coordinates, unorm16 inside the bounds
+		glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(sCompactVertex), (void*)offsetof(sCompactVertex, TexCoords));
+		glEnableVertexAttribArray(2);
+
+		glBindVertexArray(0);
+	}
 
+	else
+	{
 		//Set vertex attributes
 		//Position
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(sVertex), (void*)0);
@@ -17,6 +17,15 @@ struct sVertex
 	glm::vec2 TexCoords;
 };
 
+//16 byte version of sVertex (see cVertexQuantizer). The shader turns it back into floats:
+//position and UV are unorm16 inside the mesh's bounds, the normal is octahedral encoded as two snorm16
+struct sCompactVertex
+{
+	unsigned short Position[4];
+	short Normal[2];
+	unsigned short TexCoords[2];
+};
+
 struct sSkinnedMeshVertex
 {
 	glm::vec3 Position;
@@ -29,6 +38,18 @@ struct sSkinnedMeshVertex
 	float BoneWeights[4];
 };
 
+//40 byte GPU version of sSkinnedMeshVertex (see cVertexQuantizer). Normal, tangent and bitangent
+//are one snorm16 quaternion whose w sign holds the bitangent's handedness. Bone IDs are real
+//integers (glVertexAttribIPointer) and the weights are unorm16 that add up to exactly 1
+struct sPackedSkinnedVertex
+{
+	glm::vec3 Position;
+	short TangentFrame[4];
+	glm::vec2 TexCoords;
+	unsigned char BoneID[4];
+	unsigned short BoneWeights[4];
+};
+
 struct sTexture
 {
 	unsigned int ID;
@@ -36,23 +57,86 @@ struct sTexture
 	std::string path;
 };
 
+//A texture as named by the source material, before it has been loaded onto the GPU
+struct sTextureRef
+{
+	std::string type;
+	std::string path;
+};
+
+//CPU side copy of one mesh, ready to be handed to glBufferData
+struct sMeshData
+{
+	std::vector<sVertex> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<sTextureRef> textures;
+};
+
+//A quantized mesh plus the bounds needed to decode it
+struct sCompactMeshData
+{
+	std::vector<sCompactVertex> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<sTextureRef> textures;
+	glm::vec3 positionMin;
+	glm::vec3 positionExtent;
+	glm::vec2 texCoordMin;
+	glm::vec2 texCoordExtent;
+};
+
 class cMesh
 {
 public:
 	std::vector<sVertex> vertices;
-	std::vector<sSkinnedMeshVertex> skinnedVertices;
+	std::vector<sPackedSkinnedVertex> skinnedVertices;
 	std::vector<unsigned int> indices;
 	std::vector<sTexture> textures;
 
 	cMesh(std::vector<sVertex> theVertices, std::vector<unsigned int> theIndices, std::vector<sTexture> theTextures);
-	cMesh(std::vector<sSkinnedMeshVertex> theVertices, std::vector<unsigned int> theIndices, std::vector<sTexture> theTextures);
-	void Draw(cShaderProgram shader);
+	cMesh(std::vector<sPackedSkinnedVertex> theVertices, std::vector<unsigned int> theIndices, std::vector<sTexture> theTextures);
+	//Uploads straight from the given arrays without keeping a CPU copy (used for cached and memory mapped meshes)
+	cMesh(const sVertex* theVertices, unsigned int numVertices, const unsigned int* theIndices, unsigned int numIndices, std::vector<sTexture> theTextures);
+	//Compact vertex layout, decoded in the vertex shader through the compactVertices uniforms
+	cMesh(const sCompactMeshData& data, std::vector<sTexture> theTextures);
+	//More than one instance draws them all in one call, for shaders that read per instance data by gl_InstanceID
+	void Draw(cShaderProgram& shader, unsigned int numInstances = 1);
+	//Draws this mesh's indices and textures from someone else's vertex array, e.g. a cPreSkinnedMesh output
+	//that was built around GetIndexBuffer
+	void DrawWithVertexArray(cShaderProgram& shader, unsigned int vertexArray);
+
+	unsigned int GetVertexBuffer() const;
+	unsigned int GetIndexBuffer() const;
+	unsigned int GetNumVertices() const;
+	unsigned int GetNumIndices() const;
 
 private:
 	unsigned int VAO, VBO, EBO;
+	unsigned int numIndices;
+	unsigned int numVertices;
 	bool skinnedMesh;
+	bool compactMesh;
+	glm::vec3 positionMin;
+	glm::vec3 positionExtent;
+	glm::vec2 texCoordMin;
+	glm::vec2 texCoordExtent;
+
+	//Where a program keeps this mesh's material uniforms, resolved the first time the mesh is drawn with it
+	struct sMaterialUniforms
+	{
+		int programID;
+		std::vector<sUniform<int> > textures;
+		sUniform<bool> compactVertices;
+		sUniform<glm::vec3> positionMin;
+		sUniform<glm::vec3> positionExtent;
+		sUniform<glm::vec2> texCoordMin;
+		sUniform<glm::vec2> texCoordExtent;
+	};
+	//Usually one or two programs draw any given mesh, so a short list beats a map
+	std::vector<sMaterialUniforms> materialUniforms;
 
-	void setupMesh();
+	void setupMesh(const void* vertexData, unsigned int vertexBytes, const unsigned int* indexData, unsigned int indexCount);
+	void bindMaterial(cShaderProgram& shader);
+	const sMaterialUniforms& findMaterialUniforms(cShaderProgram& shader);
 };
 
 #endif
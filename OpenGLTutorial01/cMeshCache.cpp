@@ -0,0 +1,261 @@
+#include "cMeshCache.h"
+
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const char MESH_CACHE_MAGIC[4] = { 'M', 'S', 'H', 'C' };
+
+	struct sMeshCacheHeader
+	{
+		char magic[4];
+		unsigned int version;
+		unsigned int vertexSize;
+		unsigned int numMeshes;
+	};
+
+	struct sMeshCacheEntry
+	{
+		unsigned int numVertices;
+		unsigned int numIndices;
+		unsigned int numTextures;
+		unsigned int reserved;
+	};
+
+	unsigned int paddedLength(unsigned int length)
+	{
+		return (length + 3) & ~3u;
+	}
+
+	void writeString(std::ofstream& file, const std::string& value)
+	{
+		static const char zeros[4] = { 0, 0, 0, 0 };
+		unsigned int length = (unsigned int)value.size();
+		file.write((const char*)&length, sizeof(length));
+		file.write(value.data(), length);
+		file.write(zeros, paddedLength(length) - length);
+	}
+
+	bool readString(const unsigned char* data, size_t size, size_t& offset, std::string& out)
+	{
+		unsigned int length;
+		if (offset + sizeof(length) > size)
+			return false;
+		memcpy(&length, data + offset, sizeof(length));
+		offset += sizeof(length);
+
+		if (offset + paddedLength(length) > size)
+			return false;
+		out.assign((const char*)data + offset, length);
+		offset += paddedLength(length);
+		return true;
+	}
+}
+
+cMeshCache::cMeshCache()
+{
+	data = NULL;
+	fileSize = 0;
+}
+
+cMeshCache::~cMeshCache()
+{
+	close();
+}
+
+std::string cMeshCache::getCachePath(const std::string& sourcePath)
+{
+	return sourcePath + ".meshcache";
+}
+
+bool cMeshCache::isFresh(const std::string& sourcePath, const std::string& cachePath)
+{
+	struct stat cacheStat;
+	if (stat(cachePath.c_str(), &cacheStat) != 0)
+		return false;
+
+	//If the source is gone the cache is all we have, so use it
+	struct stat sourceStat;
+	if (stat(sourcePath.c_str(), &sourceStat) != 0)
+		return true;
+
+	return cacheStat.st_mtime >= sourceStat.st_mtime;
+}
+
+bool cMeshCache::write(const std::string& cachePath, const std::vector<sMeshData>& meshes)
+{
+	std::ofstream file(cachePath.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	sMeshCacheHeader header;
+	memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+	header.version = MESH_CACHE_VERSION;
+	header.vertexSize = sizeof(sVertex);
+	header.numMeshes = (unsigned int)meshes.size();
+	file.write((const char*)&header, sizeof(header));
+
+	for (int index = 0; index < meshes.size(); index++)
+	{
+		const sMeshData& mesh = meshes[index];
+
+		sMeshCacheEntry entry;
+		entry.numVertices = (unsigned int)mesh.vertices.size();
+		entry.numIndices = (unsigned int)mesh.indices.size();
+		entry.numTextures = (unsigned int)mesh.textures.size();
+		entry.reserved = 0;
+		file.write((const char*)&entry, sizeof(entry));
+
+		for (int texIndex = 0; texIndex < mesh.textures.size(); texIndex++)
+		{
+			writeString(file, mesh.textures[texIndex].type);
+			writeString(file, mesh.textures[texIndex].path);
+		}
+
+		if (!mesh.vertices.empty())
+			file.write((const char*)&mesh.vertices[0], mesh.vertices.size() * sizeof(sVertex));
+		if (!mesh.indices.empty())
+			file.write((const char*)&mesh.indices[0], mesh.indices.size() * sizeof(unsigned int));
+	}
+
+	return file.good();
+}
+
+bool cMeshCache::open(const std::string& cachePath)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(cachePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	//The view keeps the file alive on its own, so both handles can go straight away
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL)
+		return false;
+
+	data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (data == NULL)
+		return false;
+	fileSize = (size_t)size.QuadPart;
+#else
+	int file = ::open(cachePath.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat fileStat;
+	if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		::close(file);
+		return false;
+	}
+
+	void* mapped = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+	if (mapped == MAP_FAILED)
+		return false;
+
+	data = (const unsigned char*)mapped;
+	fileSize = (size_t)fileStat.st_size;
+#endif
+
+	if (!parse())
+	{
+		std::cout << "Mesh cache " << cachePath << " is out of date or damaged, ignoring it" << std::endl;
+		close();
+		return false;
+	}
+	return true;
+}
+
+void cMeshCache::close()
+{
+	if (data)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+#else
+		munmap((void*)data, fileSize);
+#endif
+	}
+	data = NULL;
+	fileSize = 0;
+	meshes.clear();
+}
+
+bool cMeshCache::parse()
+{
+	sMeshCacheHeader header;
+	if (fileSize < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+
+	if (memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+		header.version != MESH_CACHE_VERSION ||
+		header.vertexSize != sizeof(sVertex))
+	{
+		return false;
+	}
+
+	size_t offset = sizeof(header);
+	for (unsigned int index = 0; index < header.numMeshes; index++)
+	{
+		sMeshCacheEntry entry;
+		if (offset + sizeof(entry) > fileSize)
+			return false;
+		memcpy(&entry, data + offset, sizeof(entry));
+		offset += sizeof(entry);
+
+		sMeshView view;
+		for (unsigned int texIndex = 0; texIndex < entry.numTextures; texIndex++)
+		{
+			sTextureRef texture;
+			if (!readString(data, fileSize, offset, texture.type) ||
+				!readString(data, fileSize, offset, texture.path))
+			{
+				return false;
+			}
+			view.textures.push_back(texture);
+		}
+
+		size_t vertexBytes = (size_t)entry.numVertices * sizeof(sVertex);
+		size_t indexBytes = (size_t)entry.numIndices * sizeof(unsigned int);
+		if (offset + vertexBytes + indexBytes > fileSize)
+			return false;
+
+		//Everything before this point is a multiple of 4 bytes, so these are correctly aligned
+		view.vertices = (const sVertex*)(data + offset);
+		view.numVertices = entry.numVertices;
+		offset += vertexBytes;
+		view.indices = (const unsigned int*)(data + offset);
+		view.numIndices = entry.numIndices;
+		offset += indexBytes;
+
+		meshes.push_back(view);
+	}
+
+	return true;
+}
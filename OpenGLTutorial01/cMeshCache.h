@@ -0,0 +1,53 @@
+#ifndef _HG_cMeshCache_
+#define _HG_cMeshCache_
+
+#include <string>
+#include <vector>
+
+#include "cMesh.h"
+
+//Bump this whenever sVertex, the import flags or the file layout change,
+//so that old cache files get rebuilt instead of being misread
+const unsigned int MESH_CACHE_VERSION = 2;
+
+//One mesh inside an open cache file. The vertex and index pointers point straight into the mapped file
+struct sMeshView
+{
+	const sVertex* vertices;
+	unsigned int numVertices;
+	const unsigned int* indices;
+	unsigned int numIndices;
+	std::vector<sTextureRef> textures;
+};
+
+//Baked binary copy of a model's final vertex and index arrays, stored next to the source file.
+//Layout: header, then per mesh a count block, its texture strings (padded to 4 bytes), vertices, indices
+class cMeshCache
+{
+public:
+	cMeshCache();
+	~cMeshCache();
+
+	static std::string getCachePath(const std::string& sourcePath);
+	//True if the cache file exists and is at least as new as the source file
+	static bool isFresh(const std::string& sourcePath, const std::string& cachePath);
+	static bool write(const std::string& cachePath, const std::vector<sMeshData>& meshes);
+
+	//Memory maps the file and fills in meshes. Returns false if it is missing, stale or damaged
+	bool open(const std::string& cachePath);
+	void close();
+
+	std::vector<sMeshView> meshes;
+	size_t fileSize;
+
+private:
+	const unsigned char* data;
+
+	bool parse();
+
+	//Owns a mapping, so no copies
+	cMeshCache(const cMeshCache&);
+	cMeshCache& operator=(const cMeshCache&);
+};
+
+#endif
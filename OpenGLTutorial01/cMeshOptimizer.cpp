@@ -0,0 +1,314 @@
+#include "cMeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	//Tuning values from Forsyth's "Linear-Speed Vertex Cache Optimisation"
+	const int FORSYTH_CACHE_SIZE = 32;
+	const float CACHE_DECAY_POWER = 1.5f;
+	const float LAST_TRI_SCORE = 0.75f;
+	const float VALENCE_BOOST_SCALE = 2.0f;
+	const float VALENCE_BOOST_POWER = 0.5f;
+
+	float vertexScore(int cachePosition, unsigned int remainingTriangles)
+	{
+		//Nothing left to draw with this vertex, so it's worth nothing
+		if (remainingTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			//The last triangle's vertices get a fixed score so the next triangle doesn't just reuse the same edge
+			if (cachePosition < 3)
+				score = LAST_TRI_SCORE;
+			else
+				score = powf(1.0f - (cachePosition - 3) / (float)(FORSYTH_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+		}
+
+		//Vertices with few triangles left get a boost so they're finished off instead of left stranded
+		score += VALENCE_BOOST_SCALE * powf((float)remainingTriangles, -VALENCE_BOOST_POWER);
+		return score;
+	}
+
+	struct sCluster
+	{
+		unsigned int firstTriangle;
+		unsigned int numTriangles;
+		float sortKey;
+	};
+
+	bool sortClustersOutsideFirst(const sCluster& a, const sCluster& b)
+	{
+		return a.sortKey > b.sortKey;
+	}
+}
+
+sVertexCacheStats cMeshOptimizer::analyzeVertexCache(const std::vector<unsigned int>& indices, unsigned int numVertices, unsigned int cacheSize)
+{
+	sVertexCacheStats stats;
+	stats.ACMR = 0.0f;
+	stats.ATVR = 0.0f;
+	if (indices.empty() || numVertices == 0)
+		return stats;
+
+	//Each vertex remembers when it went into the cache, which makes a FIFO lookup a single compare
+	std::vector<unsigned int> timestamps(numVertices, 0);
+	unsigned int time = cacheSize + 1;
+	unsigned int misses = 0;
+	for (int index = 0; index < indices.size(); index++)
+	{
+		unsigned int vertex = indices[index];
+		if (time - timestamps[vertex] > cacheSize)
+		{
+			timestamps[vertex] = time++;
+			misses++;
+		}
+	}
+
+	stats.ACMR = misses / (float)(indices.size() / 3);
+	stats.ATVR = misses / (float)numVertices;
+	return stats;
+}
+
+void cMeshOptimizer::optimizeVertexCache(std::vector<unsigned int>& indices, unsigned int numVertices)
+{
+	unsigned int numTriangles = (unsigned int)indices.size() / 3;
+	if (numTriangles == 0 || numVertices == 0)
+		return;
+
+	//Flat per-vertex triangle lists. The first remaining[v] entries of each list are the triangles still to draw
+	std::vector<unsigned int> remaining(numVertices, 0);
+	for (int index = 0; index < numTriangles * 3; index++)
+		remaining[indices[index]]++;
+
+	std::vector<unsigned int> listStart(numVertices, 0);
+	for (unsigned int vertex = 1; vertex < numVertices; vertex++)
+		listStart[vertex] = listStart[vertex - 1] + remaining[vertex - 1];
+
+	std::vector<unsigned int> triangleLists(numTriangles * 3);
+	std::vector<unsigned int> fill(numVertices, 0);
+	for (unsigned int triangle = 0; triangle < numTriangles; triangle++)
+	{
+		for (int corner = 0; corner < 3; corner++)
+		{
+			unsigned int vertex = indices[triangle * 3 + corner];
+			triangleLists[listStart[vertex] + fill[vertex]++] = triangle;
+		}
+	}
+
+	std::vector<int> cachePosition(numVertices, -1);
+	std::vector<float> scores(numVertices);
+	for (unsigned int vertex = 0; vertex < numVertices; vertex++)
+		scores[vertex] = vertexScore(-1, remaining[vertex]);
+
+	std::vector<bool> emitted(numTriangles, false);
+	std::vector<unsigned int> output;
+	output.reserve(numTriangles * 3);
+
+	std::vector<unsigned int> cache;
+	std::vector<unsigned int> newCache;
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+	int bestTriangle = -1;
+	unsigned int cursor = 0;
+	for (unsigned int numEmitted = 0; numEmitted < numTriangles; numEmitted++)
+	{
+		//Nothing in the cache has work left, so start again from the next undrawn triangle
+		if (bestTriangle < 0)
+		{
+			while (emitted[cursor])
+				cursor++;
+			bestTriangle = cursor;
+		}
+
+		unsigned int triangle = (unsigned int)bestTriangle;
+		emitted[triangle] = true;
+		newCache.clear();
+		for (int corner = 0; corner < 3; corner++)
+		{
+			unsigned int vertex = indices[triangle * 3 + corner];
+			output.push_back(vertex);
+
+			//Take this triangle out of the vertex's list of ones still to draw
+			unsigned int* list = &triangleLists[listStart[vertex]];
+			for (unsigned int slot = 0; slot < remaining[vertex]; slot++)
+			{
+				if (list[slot] == triangle)
+				{
+					list[slot] = list[remaining[vertex] - 1];
+					remaining[vertex]--;
+					break;
+				}
+			}
+
+			if (std::find(newCache.begin(), newCache.end(), vertex) == newCache.end())
+				newCache.push_back(vertex);
+		}
+
+		//Simulated LRU: this triangle's vertices go to the front, everything else shuffles back
+		size_t numTriangleVertices = newCache.size();
+		for (int index = 0; index < cache.size(); index++)
+		{
+			if (std::find(newCache.begin(), newCache.begin() + numTriangleVertices, cache[index]) == newCache.begin() + numTriangleVertices)
+				newCache.push_back(cache[index]);
+		}
+
+		for (int index = 0; index < newCache.size(); index++)
+		{
+			unsigned int vertex = newCache[index];
+			cachePosition[vertex] = index < FORSYTH_CACHE_SIZE ? index : -1;
+			scores[vertex] = vertexScore(cachePosition[vertex], remaining[vertex]);
+		}
+
+		//Only triangles touching a vertex whose score just changed can have a new score
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (int index = 0; index < newCache.size(); index++)
+		{
+			unsigned int vertex = newCache[index];
+			const unsigned int* list = &triangleLists[listStart[vertex]];
+			for (unsigned int slot = 0; slot < remaining[vertex]; slot++)
+			{
+				unsigned int other = list[slot];
+				float score = scores[indices[other * 3]] + scores[indices[other * 3 + 1]] + scores[indices[other * 3 + 2]];
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = other;
+				}
+			}
+		}
+
+		if (newCache.size() > FORSYTH_CACHE_SIZE)
+			newCache.resize(FORSYTH_CACHE_SIZE);
+		cache.swap(newCache);
+	}
+
+	indices.swap(output);
+}
+
+void cMeshOptimizer::optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<sVertex>& vertices, float threshold)
+{
+	unsigned int numTriangles = (unsigned int)indices.size() / 3;
+	if (numTriangles < 2)
+		return;
+
+	//Cut a new cluster wherever the cache-ordered stream restarts from scratch (all three vertices miss).
+	//Reordering whole clusters then costs almost nothing in cache hits
+	const unsigned int cacheSize = 16;
+	std::vector<unsigned int> timestamps(vertices.size(), 0);
+	unsigned int time = cacheSize + 1;
+
+	std::vector<sCluster> clusters;
+	for (unsigned int triangle = 0; triangle < numTriangles; triangle++)
+	{
+		int misses = 0;
+		for (int corner = 0; corner < 3; corner++)
+		{
+			unsigned int vertex = indices[triangle * 3 + corner];
+			if (time - timestamps[vertex] > cacheSize)
+			{
+				timestamps[vertex] = time++;
+				misses++;
+			}
+		}
+
+		if (clusters.empty() || misses == 3)
+		{
+			sCluster cluster;
+			cluster.firstTriangle = triangle;
+			cluster.numTriangles = 0;
+			cluster.sortKey = 0.0f;
+			clusters.push_back(cluster);
+		}
+		clusters.back().numTriangles++;
+	}
+	if (clusters.size() < 2)
+		return;
+
+	glm::vec3 meshCentre(0.0f);
+	for (int index = 0; index < vertices.size(); index++)
+		meshCentre += vertices[index].Position;
+	meshCentre /= (float)vertices.size();
+
+	//Clusters that face away from the middle of the mesh are the ones most likely to hide the rest, so draw them first
+	for (int index = 0; index < clusters.size(); index++)
+	{
+		sCluster& cluster = clusters[index];
+		glm::vec3 centre(0.0f);
+		glm::vec3 normal(0.0f);
+		float totalArea = 0.0f;
+		for (unsigned int triangle = cluster.firstTriangle; triangle < cluster.firstTriangle + cluster.numTriangles; triangle++)
+		{
+			const glm::vec3& p0 = vertices[indices[triangle * 3]].Position;
+			const glm::vec3& p1 = vertices[indices[triangle * 3 + 1]].Position;
+			const glm::vec3& p2 = vertices[indices[triangle * 3 + 2]].Position;
+
+			//The cross product's length is twice the area, so summing it gives an area weighted normal for free
+			glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+			float area = glm::length(cross);
+			centre += (p0 + p1 + p2) * (area / 3.0f);
+			normal += cross;
+			totalArea += area;
+		}
+
+		float normalLength = glm::length(normal);
+		if (totalArea > 0.0f && normalLength > 0.0f)
+		{
+			cluster.sortKey = glm::dot(centre / totalArea - meshCentre, normal / normalLength);
+		}
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), sortClustersOutsideFirst);
+
+	std::vector<unsigned int> output;
+	output.reserve(indices.size());
+	for (int index = 0; index < clusters.size(); index++)
+	{
+		output.insert(output.end(),
+			indices.begin() + clusters[index].firstTriangle * 3,
+			indices.begin() + (clusters[index].firstTriangle + clusters[index].numTriangles) * 3);
+	}
+
+	sVertexCacheStats before = analyzeVertexCache(indices, (unsigned int)vertices.size(), cacheSize);
+	sVertexCacheStats after = analyzeVertexCache(output, (unsigned int)vertices.size(), cacheSize);
+	if (after.ACMR <= before.ACMR * threshold)
+	{
+		indices.swap(output);
+	}
+}
+
+void cMeshOptimizer::optimizeVertexFetch(std::vector<sVertex>& vertices, std::vector<unsigned int>& indices)
+{
+	const unsigned int UNUSED = 0xFFFFFFFFu;
+	std::vector<unsigned int> remap(vertices.size(), UNUSED);
+	std::vector<sVertex> output;
+	output.reserve(vertices.size());
+
+	for (int index = 0; index < indices.size(); index++)
+	{
+		unsigned int& newIndex = remap[indices[index]];
+		if (newIndex == UNUSED)
+		{
+			newIndex = (unsigned int)output.size();
+			output.push_back(vertices[indices[index]]);
+		}
+		indices[index] = newIndex;
+	}
+
+	vertices.swap(output);
+}
+
+void cMeshOptimizer::optimize(sMeshData& mesh)
+{
+	if (mesh.vertices.empty() || mesh.indices.size() < 3)
+		return;
+
+	optimizeVertexCache(mesh.indices, (unsigned int)mesh.vertices.size());
+	optimizeOverdraw(mesh.indices, mesh.vertices);
+	optimizeVertexFetch(mesh.vertices, mesh.indices);
+}
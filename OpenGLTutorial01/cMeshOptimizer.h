@@ -0,0 +1,38 @@
+#ifndef _HG_cMeshOptimizer_
+#define _HG_cMeshOptimizer_
+
+#include <vector>
+
+#include "cMesh.h"
+
+//How well an index buffer uses the post-transform vertex cache.
+//ACMR = vertex shader runs per triangle (0.5 is ideal for big grids, 3.0 is worst)
+//ATVR = vertex shader runs per unique vertex (1.0 is ideal)
+struct sVertexCacheStats
+{
+	float ACMR;
+	float ATVR;
+};
+
+//Bake time reordering of a mesh's triangles and vertices. Pure CPU code, safe on any thread.
+//Run the stages in the order optimize() does: cache first, then overdraw (which keeps the cache
+//order inside each cluster), then fetch (which only renames vertices, so the other two are untouched)
+class cMeshOptimizer
+{
+public:
+	//Simulates a FIFO cache of cacheSize entries, which is close to how real hardware behaves
+	static sVertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, unsigned int numVertices, unsigned int cacheSize = 16);
+
+	//Tom Forsyth's linear-speed vertex cache optimization
+	static void optimizeVertexCache(std::vector<unsigned int>& indices, unsigned int numVertices);
+	//Splits the cache-ordered triangles into clusters and draws the outward facing ones first,
+	//so that more of the mesh gets depth rejected. Gives up if ACMR would get worse than threshold times the input
+	static void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<sVertex>& vertices, float threshold = 1.05f);
+	//Renumbers vertices in the order the index buffer first uses them and drops unused ones
+	static void optimizeVertexFetch(std::vector<sVertex>& vertices, std::vector<unsigned int>& indices);
+
+	//All three stages, in order
+	static void optimize(sMeshData& mesh);
+};
+
+#endif
@@ -1,13 +1,43 @@
-#define STB_IMAGE_IMPLEMENTATION
 #include "cModel.h"
-#include "src\stb_image.h"
+
+#include <chrono>
 
 cModel::cModel(std::string path)
 {
-	loadModel(path);
+	loadTimeMs = 0.0f;
+	loadedFromCache = false;
+	compactVertices = false;
+	pendingCache = NULL;
+
+	if (loadCPU(path))
+	{
+		uploadGL();
+	}
+}
+
+cModel::cModel()
+{
+	loadTimeMs = 0.0f;
+	loadedFromCache = false;
+	compactVertices = false;
+	pendingCache = NULL;
 }
 
-void cModel::Draw(cShaderProgram shader)
+cModel::~cModel()
+{
+	for (int index = 0; index < textures_loaded.size(); index++)
+	{
+		cTextureRegistry::getInstance().release(textures_loaded[index].ID);
+	}
+
+	delete pendingCache;
+	for (std::map<std::string, cImage*>::iterator it = pendingImages.begin(); it != pendingImages.end(); it++)
+	{
+		delete it->second;
+	}
+}
+
+void cModel::Draw(cShaderProgram& shader)
 {
 	for (int index = 0; index < meshes.size(); index++)
 	{
@@ -15,41 +45,207 @@ void cModel::Draw(cShaderProgram shader)
 	}
 }
 
-void cModel::loadModel(std::string path)
+bool cModel::loadCPU(std::string path)
 {
-	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+
+	directory = path.substr(0, path.find_last_of('/'));
+	loadedFromCache = false;
 
-	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+	//Warm start: use the baked copy if it's newer than the source file
+	std::string cachePath = cMeshCache::getCachePath(path);
+	if (cMeshCache::isFresh(path, cachePath))
 	{
-		std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
-		return;
+		pendingCache = new cMeshCache();
+		loadedFromCache = pendingCache->open(cachePath);
+		if (!loadedFromCache)
+		{
+			delete pendingCache;
+			pendingCache = NULL;
+		}
 	}
-	directory = path.substr(0, path.find_last_of('/'));
 
-	processNode(scene->mRootNode, scene);
+	if (!loadedFromCache)
+	{
+		Assimp::Importer importer;
+		//Without JoinIdenticalVertices every triangle gets its own three vertices and there's nothing for the cache to reuse
+		const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices);
+
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+		{
+			std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+			return false;
+		}
+
+		processNode(scene->mRootNode, scene, pendingMeshes);
+		optimizeMeshes(path);
+
+		if (!cMeshCache::write(cachePath, pendingMeshes))
+		{
+			std::cout << "Could not write mesh cache " << cachePath << std::endl;
+		}
+	}
+
+	//Decode the images now too, so only the GL upload is left for later
+	if (pendingCache)
+	{
+		for (int index = 0; index < pendingCache->meshes.size(); index++)
+			decodeTextures(pendingCache->meshes[index].textures);
+	}
+	for (int index = 0; index < pendingMeshes.size(); index++)
+	{
+		decodeTextures(pendingMeshes[index].textures);
+	}
+
+	if (compactVertices)
+	{
+		quantizeMeshes(path);
+	}
+
+	std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+	loadTimeMs = elapsed.count();
+	std::cout << "Loaded " << path << (loadedFromCache ? " from mesh cache" : " through Assimp") << " in " << loadTimeMs << " ms" << std::endl;
+	return true;
 }
 
-void cModel::processNode(aiNode* node, const aiScene* scene)
+void cModel::uploadGL()
+{
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+
+	if (pendingCache)
+	{
+		//glBufferData copies out of the mapping, so the cache can be closed as soon as this is done
+		for (int index = 0; index < pendingCache->meshes.size(); index++)
+		{
+			const sMeshView& view = pendingCache->meshes[index];
+			meshes.push_back(cMesh(view.vertices, view.numVertices, view.indices, view.numIndices, loadMaterialTextures(view.textures)));
+		}
+		delete pendingCache;
+		pendingCache = NULL;
+	}
+
+	for (int index = 0; index < pendingMeshes.size(); index++)
+	{
+		const sMeshData& data = pendingMeshes[index];
+		meshes.push_back(cMesh(data.vertices.data(), data.vertices.size(), data.indices.data(), data.indices.size(), loadMaterialTextures(data.textures)));
+	}
+	pendingMeshes.clear();
+
+	for (int index = 0; index < pendingCompactMeshes.size(); index++)
+	{
+		const sCompactMeshData& data = pendingCompactMeshes[index];
+		meshes.push_back(cMesh(data, loadMaterialTextures(data.textures)));
+	}
+	pendingCompactMeshes.clear();
+
+	for (std::map<std::string, cImage*>::iterator it = pendingImages.begin(); it != pendingImages.end(); it++)
+	{
+		delete it->second;
+	}
+	pendingImages.clear();
+
+	std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+	loadTimeMs += elapsed.count();
+}
+
+void cModel::optimizeMeshes(const std::string& path)
+{
+	//Runs once per bake, the cache stores the optimized order
+	for (int index = 0; index < pendingMeshes.size(); index++)
+	{
+		sMeshData& mesh = pendingMeshes[index];
+		sVertexCacheStats before = cMeshOptimizer::analyzeVertexCache(mesh.indices, (unsigned int)mesh.vertices.size());
+		cMeshOptimizer::optimize(mesh);
+		sVertexCacheStats after = cMeshOptimizer::analyzeVertexCache(mesh.indices, (unsigned int)mesh.vertices.size());
+
+		std::cout << "Optimized " << path << " mesh " << index << " (" << mesh.indices.size() / 3 << " triangles): ACMR "
+			<< before.ACMR << " -> " << after.ACMR << ", ATVR " << before.ATVR << " -> " << after.ATVR << std::endl;
+	}
+}
+
+void cModel::quantizeMeshes(const std::string& path)
+{
+	//The cache stays full float, so this runs on every load. It's a single pass over the vertices
+	std::vector<sMeshView> sources;
+	if (pendingCache)
+	{
+		sources = pendingCache->meshes;
+	}
+	for (int index = 0; index < pendingMeshes.size(); index++)
+	{
+		sMeshView view;
+		view.vertices = pendingMeshes[index].vertices.data();
+		view.numVertices = (unsigned int)pendingMeshes[index].vertices.size();
+		view.indices = pendingMeshes[index].indices.data();
+		view.numIndices = (unsigned int)pendingMeshes[index].indices.size();
+		view.textures = pendingMeshes[index].textures;
+		sources.push_back(view);
+	}
+
+	for (int index = 0; index < sources.size(); index++)
+	{
+		const sMeshView& view = sources[index];
+		sCompactMeshData compact;
+		cVertexQuantizer::quantize(view.vertices, view.numVertices, compact);
+		compact.indices.assign(view.indices, view.indices + view.numIndices);
+		compact.textures = view.textures;
+
+		sQuantizationError error = cVertexQuantizer::measureError(view.vertices, compact);
+		std::cout << "Quantized " << path << " mesh " << index << ": " << view.numVertices * sizeof(sVertex) / 1024 << " KB -> "
+			<< view.numVertices * sizeof(sCompactVertex) / 1024 << " KB, max error position " << error.maxPositionError
+			<< " (tolerance " << error.positionTolerance << "), normal " << error.maxNormalErrorDegrees
+			<< " deg (tolerance " << error.normalToleranceDegrees << "), uv " << error.maxTexCoordError
+			<< " (tolerance " << error.texCoordTolerance << ")" << (error.withinTolerance() ? "" : " OUT OF TOLERANCE") << std::endl;
+
+		pendingCompactMeshes.push_back(compact);
+	}
+
+	//Everything has been copied out, the full float versions aren't needed any more
+	pendingMeshes.clear();
+	delete pendingCache;
+	pendingCache = NULL;
+}
+
+void cModel::decodeTextures(const std::vector<sTextureRef>& textureRefs)
+{
+	for (int index = 0; index < textureRefs.size(); index++)
+	{
+		const std::string& path = textureRefs[index].path;
+		if (pendingImages.find(path) != pendingImages.end())
+			continue;
+		//Someone else already has it on the GPU, so there's nothing to decode
+		if (cTextureRegistry::getInstance().isResident(directory + '/' + path))
+			continue;
+
+		cImage* image = new cImage();
+		if (!image->load(directory + '/' + path))
+		{
+			std::cout << "Texture failed to load at path: " << path << std::endl;
+		}
+		pendingImages[path] = image;
+	}
+}
+
+void cModel::processNode(aiNode* node, const aiScene* scene, std::vector<sMeshData>& meshData)
 {
 	//Process all the node's meshes (if any)
 	for (int index = 0; index < node->mNumMeshes; index++)
 	{
 		aiMesh* mesh = scene->mMeshes[node->mMeshes[index]];
-		meshes.push_back(processMesh(mesh, scene));
+		meshData.push_back(processMesh(mesh, scene));
 	}
 	//Then recursively call each of the node's children
 	for (int index = 0; index < node->mNumChildren; index++)
 	{
-		processNode(node->mChildren[index], scene);
+		processNode(node->mChildren[index], scene, meshData);
 	}
 }
 
-cMesh cModel::processMesh(aiMesh* mesh, const aiScene* scene)
+sMeshData cModel::processMesh(aiMesh* mesh, const aiScene* scene)
 {
-	std::vector<sVertex> theVertices;
-	std::vector<unsigned int> theIndices;
-	std::vector<sTexture> theTextures;
+	sMeshData data;
+	data.vertices.reserve(mesh->mNumVertices);
+	data.indices.reserve(mesh->mNumFaces * 3);
 
 	for (int index = 0; index < mesh->mNumVertices; index++)
 	{
@@ -73,7 +269,7 @@ cMesh cModel::processMesh(aiMesh* mesh, const aiScene* scene)
 		else
 			vertex.TexCoords = glm::vec2(0.0f, 0.0f);
 
-		theVertices.push_back(vertex);
+		data.vertices.push_back(vertex);
 	}
 
 	for (int index = 0; index < mesh->mNumFaces; index++)
@@ -81,48 +277,50 @@ cMesh cModel::processMesh(aiMesh* mesh, const aiScene* scene)
 		aiFace face = mesh->mFaces[index];
 		for (int faceIndex = 0; faceIndex < face.mNumIndices; faceIndex++)
 		{
-			theIndices.push_back(face.mIndices[faceIndex]);
+			data.indices.push_back(face.mIndices[faceIndex]);
 		}
 	}
 
 	if (mesh->mMaterialIndex >= 0)
 	{
 		aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-		std::vector<sTexture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-		theTextures.insert(theTextures.end(), diffuseMaps.begin(), diffuseMaps.end());
-		std::vector<sTexture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-		theTextures.insert(theTextures.end(), specularMaps.begin(), specularMaps.end());
+		getMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", data.textures);
+		getMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", data.textures);
 	}
 
-	return cMesh(theVertices, theIndices, theTextures);
+	return data;
 }
 
-std::vector<sTexture> cModel::loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName)
+void cModel::getMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName, std::vector<sTextureRef>& textureRefs)
 {
-	std::vector<sTexture> textures;
 	for (int index = 0; index < mat->GetTextureCount(type); index++)
 	{
 		aiString str;
 		mat->GetTexture(type, index, &str);
-		bool skip = false;
-		for (int i = 0; i < textures_loaded.size(); i++)
-		{
-			if (std::strcmp(textures_loaded[i].path.data(), str.C_Str()) == 0)
-			{
-				textures.push_back(textures_loaded[i]);
-				skip = true;
-				break;
-			}
-		}
-		if (!skip)
-		{	//If the textures has not been loaded yet, load it now
-			sTexture texture;
-			texture.ID = TextureFromFile(str.C_Str(), directory);
-			texture.type = typeName;
-			texture.path = str.C_Str();
-			textures.push_back(texture);
-			textures_loaded.push_back(texture);
-		}
+
+		sTextureRef textureRef;
+		textureRef.type = typeName;
+		textureRef.path = str.C_Str();
+		textureRefs.push_back(textureRef);
+	}
+}
+
+std::vector<sTexture> cModel::loadMaterialTextures(const std::vector<sTextureRef>& textureRefs)
+{
+	std::vector<sTexture> textures;
+	for (int index = 0; index < textureRefs.size(); index++)
+	{
+		//The registry hands back the shared copy if any model has loaded this file already
+		sTexture texture;
+		std::map<std::string, cImage*>::iterator itImage = pendingImages.find(textureRefs[index].path);
+		if (itImage != pendingImages.end() && itImage->second->isLoaded())
+			texture.ID = cTextureRegistry::getInstance().acquire(directory + '/' + textureRefs[index].path, *itImage->second, GL_RGB, this);
+		else
+			texture.ID = TextureFromFile(textureRefs[index].path.c_str(), directory);
+		texture.type = textureRefs[index].type;
+		texture.path = textureRefs[index].path;
+		textures.push_back(texture);
+		textures_loaded.push_back(texture);
 	}
 	return textures;
 }
@@ -132,36 +330,5 @@ unsigned int cModel::TextureFromFile(const char* path, const std::string &direct
 	std::string filename = std::string(path);
 	filename = directory + '/' + filename;
 
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
-
-	int width, height, nrComponents;
-	unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-	if (data)
-	{
-		GLenum format;
-		if (nrComponents == 1)
-			format = GL_RED;
-		else if (nrComponents == 3)
-			format = GL_RGB;
-		else if (nrComponents == 4)
-			format = GL_RGBA;
-
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	}
-
-	else
-	{
-		std::cout << "Texture failed to load at path: " << path << std::endl;
-	}
-
-	stbi_image_free(data);
-	return textureID;
-}
\ No newline at end of file
+	return cTextureRegistry::getInstance().acquire(filename, GL_RGB, this);
+}
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <string>
+#include <map>
 #include <iostream>
 
 #include <assimp/Importer.hpp>
@@ -11,23 +12,60 @@
 
 #include "cShaderProgram.h"
 #include "cMesh.h"
+#include "cMeshCache.h"
+#include "cMeshOptimizer.h"
+#include "cVertexQuantizer.h"
+#include "cImage.h"
+#include "cTextureRegistry.h"
 
 class cModel
 {
 public:
 	cModel(std::string path);
-	void Draw(cShaderProgram shader);
+	//Empty model, to be filled in by loadCPU() and uploadGL() (see cAssetLoader)
+	cModel();
+	~cModel();
+
+	//CPU half of loading (cache or Assimp import, mesh conversion, image decode). Touches no GL state
+	bool loadCPU(std::string path);
+	//GL half of loading. Must run on the thread that owns the context
+	void uploadGL();
+
+	void Draw(cShaderProgram& shader);
+
+	//Opt in before loading: upload 16 byte sCompactVertex instead of 32 byte sVertex.
+	//The shader has to understand the compactVertices uniforms (see vertShader.glsl)
+	bool compactVertices;
+
+	//How long the last load took, and whether it came from the baked mesh cache or from Assimp
+	float loadTimeMs;
+	bool loadedFromCache;
 
 private:
+	//Every texture this model holds a registry reference to
 	std::vector<sTexture> textures_loaded;
 	std::vector<cMesh> meshes;
 	std::string directory;
 
-	void loadModel(std::string path);
-	void processNode(aiNode* node, const aiScene* scene);
-	cMesh processMesh(aiMesh* mesh, const aiScene* scene);
-	std::vector<sTexture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName);
+	//Results of loadCPU() waiting for uploadGL()
+	cMeshCache* pendingCache;
+	std::vector<sMeshData> pendingMeshes;
+	std::vector<sCompactMeshData> pendingCompactMeshes;
+	std::map<std::string, cImage*> pendingImages;
+
+	//Reorders pendingMeshes for the vertex cache, overdraw and fetch, and prints ACMR/ATVR before and after
+	void optimizeMeshes(const std::string& path);
+	//Replaces the pending meshes with quantized copies and prints the size saving and worst case error
+	void quantizeMeshes(const std::string& path);
+	void decodeTextures(const std::vector<sTextureRef>& textureRefs);
+	void processNode(aiNode* node, const aiScene* scene, std::vector<sMeshData>& meshData);
+	sMeshData processMesh(aiMesh* mesh, const aiScene* scene);
+	void getMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName, std::vector<sTextureRef>& textureRefs);
+	std::vector<sTexture> loadMaterialTextures(const std::vector<sTextureRef>& textureRefs);
 	unsigned int TextureFromFile(const char* path, const std::string &directory, bool gamma = false);
+
+	cModel(const cModel&);
+	cModel& operator=(const cModel&);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,517 @@
+#include "cPoseBatchSampler.h"
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#if defined(POSE_SAMPLER_AVX2)
+#include <immintrin.h>
+#elif defined(POSE_SAMPLER_SSE)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	//Streams are padded to this many lanes, so the widest path never reads past the end
+	const unsigned int MAX_LANES = 8;
+	//Instances per pass over the skeleton. Big enough to fill the lanes many times over, small enough that
+	//every node's globals for the batch stay in cache until their children read them
+	const unsigned int BATCH_SIZE = 32;
+
+	//One lane at a time. The sign flip works on the bits, like the SIMD versions, so -0 flips the same way in all of them
+	struct sLanes1
+	{
+		static const unsigned int WIDTH = 1;
+		float v;
+
+		static sLanes1 load(const float* source) { sLanes1 lanes; lanes.v = *source; return lanes; }
+		static sLanes1 set(float value) { sLanes1 lanes; lanes.v = value; return lanes; }
+		void store(float* destination) const { *destination = v; }
+	};
+	inline sLanes1 operator+(sLanes1 a, sLanes1 b) { return sLanes1::set(a.v + b.v); }
+	inline sLanes1 operator-(sLanes1 a, sLanes1 b) { return sLanes1::set(a.v - b.v); }
+	inline sLanes1 operator*(sLanes1 a, sLanes1 b) { return sLanes1::set(a.v * b.v); }
+	inline sLanes1 operator/(sLanes1 a, sLanes1 b) { return sLanes1::set(a.v / b.v); }
+	inline sLanes1 lanesAbs(sLanes1 a) { return sLanes1::set(fabsf(a.v)); }
+	inline sLanes1 lanesSqrt(sLanes1 a) { return sLanes1::set(sqrtf(a.v)); }
+	inline sLanes1 lanesFlipSign(sLanes1 value, sLanes1 sign)
+	{
+		unsigned int valueBits, signBits;
+		memcpy(&valueBits, &value.v, sizeof(float));
+		memcpy(&signBits, &sign.v, sizeof(float));
+		valueBits ^= signBits & 0x80000000u;
+		memcpy(&value.v, &valueBits, sizeof(float));
+		return value;
+	}
+
+#if defined(POSE_SAMPLER_AVX2)
+	struct sLanes8
+	{
+		static const unsigned int WIDTH = 8;
+		__m256 v;
+
+		static sLanes8 load(const float* source) { sLanes8 lanes; lanes.v = _mm256_loadu_ps(source); return lanes; }
+		static sLanes8 set(float value) { sLanes8 lanes; lanes.v = _mm256_set1_ps(value); return lanes; }
+		static sLanes8 wrap(__m256 value) { sLanes8 lanes; lanes.v = value; return lanes; }
+		void store(float* destination) const { _mm256_storeu_ps(destination, v); }
+	};
+	inline sLanes8 operator+(sLanes8 a, sLanes8 b) { return sLanes8::wrap(_mm256_add_ps(a.v, b.v)); }
+	inline sLanes8 operator-(sLanes8 a, sLanes8 b) { return sLanes8::wrap(_mm256_sub_ps(a.v, b.v)); }
+	inline sLanes8 operator*(sLanes8 a, sLanes8 b) { return sLanes8::wrap(_mm256_mul_ps(a.v, b.v)); }
+	inline sLanes8 operator/(sLanes8 a, sLanes8 b) { return sLanes8::wrap(_mm256_div_ps(a.v, b.v)); }
+	inline sLanes8 lanesAbs(sLanes8 a) { return sLanes8::wrap(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)); }
+	inline sLanes8 lanesSqrt(sLanes8 a) { return sLanes8::wrap(_mm256_sqrt_ps(a.v)); }
+	inline sLanes8 lanesFlipSign(sLanes8 value, sLanes8 sign) { return sLanes8::wrap(_mm256_xor_ps(value.v, _mm256_and_ps(sign.v, _mm256_set1_ps(-0.0f)))); }
+	typedef sLanes8 sSimdLanes;
+#elif defined(POSE_SAMPLER_SSE)
+	struct sLanes4
+	{
+		static const unsigned int WIDTH = 4;
+		__m128 v;
+
+		static sLanes4 load(const float* source) { sLanes4 lanes; lanes.v = _mm_loadu_ps(source); return lanes; }
+		static sLanes4 set(float value) { sLanes4 lanes; lanes.v = _mm_set1_ps(value); return lanes; }
+		static sLanes4 wrap(__m128 value) { sLanes4 lanes; lanes.v = value; return lanes; }
+		void store(float* destination) const { _mm_storeu_ps(destination, v); }
+	};
+	inline sLanes4 operator+(sLanes4 a, sLanes4 b) { return sLanes4::wrap(_mm_add_ps(a.v, b.v)); }
+	inline sLanes4 operator-(sLanes4 a, sLanes4 b) { return sLanes4::wrap(_mm_sub_ps(a.v, b.v)); }
+	inline sLanes4 operator*(sLanes4 a, sLanes4 b) { return sLanes4::wrap(_mm_mul_ps(a.v, b.v)); }
+	inline sLanes4 operator/(sLanes4 a, sLanes4 b) { return sLanes4::wrap(_mm_div_ps(a.v, b.v)); }
+	inline sLanes4 lanesAbs(sLanes4 a) { return sLanes4::wrap(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)); }
+	inline sLanes4 lanesSqrt(sLanes4 a) { return sLanes4::wrap(_mm_sqrt_ps(a.v)); }
+	inline sLanes4 lanesFlipSign(sLanes4 value, sLanes4 sign) { return sLanes4::wrap(_mm_xor_ps(value.v, _mm_and_ps(sign.v, _mm_set1_ps(-0.0f)))); }
+	typedef sLanes4 sSimdLanes;
+#else
+	typedef sLanes1 sSimdLanes;
+#endif
+
+	//The same math for every lane width, so the SIMD and scalar paths can only differ by rounding
+	template <typename tLanes>
+	void sampleLanesWith(float* streams, unsigned int stride, unsigned int count)
+	{
+		typedef cPoseBatchSampler S;
+		for (unsigned int lane = 0; lane < count; lane += tLanes::WIDTH)
+		{
+			float* base = streams + lane;
+			#define IN(stream) tLanes::load(base + (stream) * stride)
+
+			tLanes positionFactor = IN(S::POSITION_FACTOR);
+			tLanes px = IN(S::POSITION_A_X) + (IN(S::POSITION_B_X) - IN(S::POSITION_A_X)) * positionFactor;
+			tLanes py = IN(S::POSITION_A_Y) + (IN(S::POSITION_B_Y) - IN(S::POSITION_A_Y)) * positionFactor;
+			tLanes pz = IN(S::POSITION_A_Z) + (IN(S::POSITION_B_Z) - IN(S::POSITION_A_Z)) * positionFactor;
+
+			tLanes scalingFactor = IN(S::SCALING_FACTOR);
+			tLanes sx = IN(S::SCALING_A_X) + (IN(S::SCALING_B_X) - IN(S::SCALING_A_X)) * scalingFactor;
+			tLanes sy = IN(S::SCALING_A_Y) + (IN(S::SCALING_B_Y) - IN(S::SCALING_A_Y)) * scalingFactor;
+			tLanes sz = IN(S::SCALING_A_Z) + (IN(S::SCALING_B_Z) - IN(S::SCALING_A_Z)) * scalingFactor;
+
+			tLanes ax = IN(S::ROTATION_A_X), ay = IN(S::ROTATION_A_Y), az = IN(S::ROTATION_A_Z), aw = IN(S::ROTATION_A_W);
+			tLanes bx = IN(S::ROTATION_B_X), by = IN(S::ROTATION_B_Y), bz = IN(S::ROTATION_B_Z), bw = IN(S::ROTATION_B_W);
+			tLanes t = IN(S::ROTATION_FACTOR);
+			#undef IN
+
+			//Take the short way round, like glm::slerp does
+			tLanes cosAngle = ax * bx + ay * by + az * bz + aw * bw;
+			bx = lanesFlipSign(bx, cosAngle);
+			by = lanesFlipSign(by, cosAngle);
+			bz = lanesFlipSign(bz, cosAngle);
+			bw = lanesFlipSign(bw, cosAngle);
+
+			//nlerp runs ahead of slerp near the ends and behind it in the middle. Bending t by a cubic fitted
+			//over the angle between the keys pulls it back to within about 1e-3 of slerp for any pair of keys,
+			//and far less for keys a frame apart
+			tLanes d = lanesAbs(cosAngle);
+			tLanes A = tLanes::set(1.0904f) + d * (tLanes::set(-3.2452f) + d * (tLanes::set(3.55645f) - d * tLanes::set(1.43519f)));
+			tLanes B = tLanes::set(0.848013f) + d * (tLanes::set(-1.06021f) + d * tLanes::set(0.215638f));
+			tLanes half = t - tLanes::set(0.5f);
+			tLanes k = A * half * half + B;
+			tLanes factor = t + t * half * (t - tLanes::set(1.0f)) * k;
+
+			tLanes qx = ax + (bx - ax) * factor;
+			tLanes qy = ay + (by - ay) * factor;
+			tLanes qz = az + (bz - az) * factor;
+			tLanes qw = aw + (bw - aw) * factor;
+			tLanes inverseLength = tLanes::set(1.0f) / lanesSqrt(qx * qx + qy * qy + qz * qz + qw * qw);
+			qx = qx * inverseLength;
+			qy = qy * inverseLength;
+			qz = qz * inverseLength;
+			qw = qw * inverseLength;
+
+			//Rotation matrix with each column scaled, and the position beside it: T * R * S in one go
+			tLanes x2 = qx + qx, y2 = qy + qy, z2 = qz + qz;
+			tLanes xx = qx * x2, yy = qy * y2, zz = qz * z2;
+			tLanes xy = qx * y2, xz = qx * z2, yz = qy * z2;
+			tLanes wx = qw * x2, wy = qw * y2, wz = qw * z2;
+			tLanes one = tLanes::set(1.0f);
+
+			float* local = base + S::LOCAL_FIRST * stride;
+			((one - (yy + zz)) * sx).store(local + 0 * stride);
+			((xy - wz) * sy).store(local + 1 * stride);
+			((xz + wy) * sz).store(local + 2 * stride);
+			px.store(local + 3 * stride);
+			((xy + wz) * sx).store(local + 4 * stride);
+			((one - (xx + zz)) * sy).store(local + 5 * stride);
+			((yz - wx) * sz).store(local + 6 * stride);
+			py.store(local + 7 * stride);
+			((xz - wy) * sx).store(local + 8 * stride);
+			((yz + wx) * sy).store(local + 9 * stride);
+			((one - (xx + yy)) * sz).store(local + 10 * stride);
+			pz.store(local + 11 * stride);
+		}
+	}
+
+	//3x4 affine helpers, row major with the translation in the last column
+	void toAffine(const glm::mat4& matrix, float out[12])
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				out[row * 4 + column] = matrix[column][row];
+			}
+		}
+	}
+
+	glm::mat4 toMat4(const float affine[12])
+	{
+		return glm::mat4(affine[0], affine[4], affine[8], 0.0f,
+			affine[1], affine[5], affine[9], 0.0f,
+			affine[2], affine[6], affine[10], 0.0f,
+			affine[3], affine[7], affine[11], 1.0f);
+	}
+
+	void multiplyAffine(const float a[12], const float b[12], float out[12])
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			const float* aRow = a + row * 4;
+			for (int column = 0; column < 4; column++)
+			{
+				out[row * 4 + column] = aRow[0] * b[column] + aRow[1] * b[4 + column] + aRow[2] * b[8 + column] + (column == 3 ? aRow[3] : 0.0f);
+			}
+		}
+	}
+
+	void gatherVectorKeys(const cAnimationClip* clip, const std::vector<float>& times, const std::vector<glm::vec3>& values,
+		float animationTime, unsigned int* cursor, float* first, unsigned int stride)
+	{
+		unsigned int key = 0;
+		unsigned int nextKey = 0;
+		float factor = 0.0f;
+		if (values.size() > 1)
+		{
+			key = clip->findKey(times, animationTime, cursor, factor);
+			nextKey = key + 1;
+		}
+		first[0] = values[key].x;
+		first[stride] = values[key].y;
+		first[2 * stride] = values[key].z;
+		first[3 * stride] = values[nextKey].x;
+		first[4 * stride] = values[nextKey].y;
+		first[5 * stride] = values[nextKey].z;
+		first[6 * stride] = factor;
+	}
+
+	void gatherRotationKeys(const cAnimationClip* clip, const std::vector<float>& times, const std::vector<glm::quat>& values,
+		float animationTime, unsigned int* cursor, float* first, unsigned int stride)
+	{
+		unsigned int key = 0;
+		unsigned int nextKey = 0;
+		float factor = 0.0f;
+		if (values.size() > 1)
+		{
+			key = clip->findKey(times, animationTime, cursor, factor);
+			nextKey = key + 1;
+		}
+		first[0] = values[key].x;
+		first[stride] = values[key].y;
+		first[2 * stride] = values[key].z;
+		first[3 * stride] = values[key].w;
+		first[4 * stride] = values[nextKey].x;
+		first[5 * stride] = values[nextKey].y;
+		first[6 * stride] = values[nextKey].z;
+		first[7 * stride] = values[nextKey].w;
+		first[8 * stride] = factor;
+	}
+
+	//Both keys either side of animationTime, decoded from a compressed clip's pools
+	void gatherCompressedVectorKeys(const cAnimationClip* clip, const sCompressedTrack& track, bool isPosition,
+		float animationTime, unsigned int* cursor, float* first, unsigned int stride)
+	{
+		float factor;
+		unsigned int key = clip->findCompressedKey(track, animationTime, cursor, factor);
+		unsigned int nextKey = track.numKeys > 1 ? key + 1 : key;
+		glm::vec3 from = isPosition ? clip->decodePosition(key) : clip->decodeScaling(key);
+		glm::vec3 to = isPosition ? clip->decodePosition(nextKey) : clip->decodeScaling(nextKey);
+		first[0] = from.x;
+		first[stride] = from.y;
+		first[2 * stride] = from.z;
+		first[3 * stride] = to.x;
+		first[4 * stride] = to.y;
+		first[5 * stride] = to.z;
+		first[6 * stride] = factor;
+	}
+
+	void gatherCompressedRotationKeys(const cAnimationClip* clip, const sCompressedTrack& track,
+		float animationTime, unsigned int* cursor, float* first, unsigned int stride)
+	{
+		float factor;
+		unsigned int key = clip->findCompressedKey(track, animationTime, cursor, factor);
+		glm::quat from = clip->decodeRotation(key);
+		glm::quat to = track.numKeys > 1 ? clip->decodeRotation(key + 1) : from;
+		first[0] = from.x;
+		first[stride] = from.y;
+		first[2 * stride] = from.z;
+		first[3 * stride] = from.w;
+		first[4 * stride] = to.x;
+		first[5 * stride] = to.y;
+		first[6 * stride] = to.z;
+		first[7 * stride] = to.w;
+		first[8 * stride] = factor;
+	}
+
+	float nextRandom(unsigned int& seed)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		return (seed >> 8) / 16777216.0f;
+	}
+}
+
+bool sPoseSamplerError::withinTolerance()
+{
+	return maxReferenceError <= referenceTolerance && maxScalarDifference <= scalarTolerance;
+}
+
+cPoseBatchSampler::cPoseBatchSampler()
+{
+	this->useSimd = true;
+	this->stride = 0;
+}
+
+const char* cPoseBatchSampler::getInstructionSet()
+{
+#if defined(POSE_SAMPLER_AVX2)
+	return "AVX2";
+#elif defined(POSE_SAMPLER_SSE)
+	return "SSE";
+#else
+	return "scalar";
+#endif
+}
+
+void cPoseBatchSampler::sampleLanes(float* streams, unsigned int stride, unsigned int count) const
+{
+	if (this->useSimd)
+		sampleLanesWith<sSimdLanes>(streams, stride, count);
+	else
+		sampleLanesWith<sLanes1>(streams, stride, count);
+}
+
+void cPoseBatchSampler::gatherChannel(const cAnimationClip* clip, int channelIndex, const float* animationTimes, sSkeletonPose* const* poses, unsigned int numInstances)
+{
+	float* streams = this->streams.data();
+	if (clip->isCompressed)
+	{
+		const sCompressedChannel& channel = clip->compressedChannels[channelIndex];
+		for (unsigned int instance = 0; instance < numInstances; instance++)
+		{
+			unsigned int* keys = &poses[instance]->cursor.keys[channelIndex * 3];
+			float animationTime = animationTimes[instance];
+			gatherCompressedVectorKeys(clip, channel.position, true, animationTime, keys,
+				streams + POSITION_A_X * this->stride + instance, this->stride);
+			gatherCompressedRotationKeys(clip, channel.rotation, animationTime, keys + 1,
+				streams + ROTATION_A_X * this->stride + instance, this->stride);
+			gatherCompressedVectorKeys(clip, channel.scaling, false, animationTime, keys + 2,
+				streams + SCALING_A_X * this->stride + instance, this->stride);
+		}
+		return;
+	}
+
+	const sAnimationChannel& channel = clip->channels[channelIndex];
+	for (unsigned int instance = 0; instance < numInstances; instance++)
+	{
+		unsigned int* keys = &poses[instance]->cursor.keys[channelIndex * 3];
+		float animationTime = animationTimes[instance];
+		gatherVectorKeys(clip, channel.positionTimes, channel.positionValues, animationTime, keys,
+			streams + POSITION_A_X * this->stride + instance, this->stride);
+		gatherRotationKeys(clip, channel.rotationTimes, channel.rotationValues, animationTime, keys + 1,
+			streams + ROTATION_A_X * this->stride + instance, this->stride);
+		gatherVectorKeys(clip, channel.scalingTimes, channel.scalingValues, animationTime, keys + 2,
+			streams + SCALING_A_X * this->stride + instance, this->stride);
+	}
+}
+
+void cPoseBatchSampler::evaluate(const cSkeleton& skeleton, const sClipBinding& binding, const float* animationTimes, sSkeletonPose* const* poses, unsigned int numInstances)
+{
+	this->stride = (glm::min(numInstances, BATCH_SIZE) + MAX_LANES - 1) / MAX_LANES * MAX_LANES;
+	this->streams.resize(NUM_STREAMS * this->stride);
+	this->globals.resize(skeleton.getNumNodes() * 12 * this->stride);
+
+	for (unsigned int first = 0; first < numInstances; first += BATCH_SIZE)
+	{
+		this->evaluateBatch(skeleton, binding, animationTimes + first, poses + first, glm::min(BATCH_SIZE, numInstances - first));
+	}
+}
+
+void cPoseBatchSampler::evaluateBatch(const cSkeleton& skeleton, const sClipBinding& binding, const float* animationTimes, sSkeletonPose* const* poses, unsigned int numInstances)
+{
+	const unsigned int numNodes = skeleton.getNumNodes();
+	for (unsigned int instance = 0; instance < numInstances; instance++)
+	{
+		if (poses[instance]->cursor.clip != binding.clip)
+			poses[instance]->cursor.reset(binding.clip);
+	}
+
+	float globalInverse[12];
+	toAffine(skeleton.globalInverseTransform, globalInverse);
+	const unsigned int stride = this->stride;
+	float* local = this->streams.data() + LOCAL_FIRST * stride;
+
+	for (unsigned int nodeIndex = 0; nodeIndex < numNodes; nodeIndex++)
+	{
+		int channelIndex = binding.clip ? binding.nodeChannels[nodeIndex] : -1;
+		if (channelIndex >= 0)
+		{
+			this->gatherChannel(binding.clip, channelIndex, animationTimes, poses, numInstances);
+			this->sampleLanes(this->streams.data(), stride, numInstances);
+		}
+		else
+		{
+			float bind[12];
+			toAffine(skeleton.bindTransforms[nodeIndex], bind);
+			for (int component = 0; component < 12; component++)
+			{
+				std::fill(local + component * stride, local + component * stride + numInstances, bind[component]);
+			}
+		}
+
+		//Parent * local for every instance, one output component at a time so the inner loop runs straight down the lanes
+		float* global = this->globals.data() + nodeIndex * 12 * stride;
+		int parentIndex = skeleton.parentIndices[nodeIndex];
+		if (parentIndex >= 0)
+		{
+			const float* parent = this->globals.data() + parentIndex * 12 * stride;
+			for (int row = 0; row < 3; row++)
+			{
+				const float* p0 = parent + (row * 4 + 0) * stride;
+				const float* p1 = parent + (row * 4 + 1) * stride;
+				const float* p2 = parent + (row * 4 + 2) * stride;
+				const float* p3 = parent + (row * 4 + 3) * stride;
+				for (int column = 0; column < 4; column++)
+				{
+					const float* l0 = local + (0 * 4 + column) * stride;
+					const float* l1 = local + (1 * 4 + column) * stride;
+					const float* l2 = local + (2 * 4 + column) * stride;
+					float* out = global + (row * 4 + column) * stride;
+					if (column == 3)
+					{
+						for (unsigned int lane = 0; lane < numInstances; lane++)
+							out[lane] = p0[lane] * l0[lane] + p1[lane] * l1[lane] + p2[lane] * l2[lane] + p3[lane];
+					}
+					else
+					{
+						for (unsigned int lane = 0; lane < numInstances; lane++)
+							out[lane] = p0[lane] * l0[lane] + p1[lane] * l1[lane] + p2[lane] * l2[lane];
+					}
+				}
+			}
+		}
+		else
+		{
+			std::copy(local, local + 12 * stride, global);
+		}
+	}
+
+	//Written out one pose at a time, so the stores run straight through each pose's arrays
+	//instead of hopping between every instance in the batch at every node
+	for (unsigned int instance = 0; instance < numInstances; instance++)
+	{
+		sSkeletonPose& pose = *poses[instance];
+		for (unsigned int nodeIndex = 0; nodeIndex < numNodes; nodeIndex++)
+		{
+			const float* global = this->globals.data() + nodeIndex * 12 * stride + instance;
+			float nodeGlobal[12];
+			for (int component = 0; component < 12; component++)
+			{
+				nodeGlobal[component] = global[component * stride];
+			}
+			pose.nodeGlobals[nodeIndex] = toMat4(nodeGlobal);
+
+			int boneIndex = skeleton.boneIndices[nodeIndex];
+			if (boneIndex >= 0)
+			{
+				float boneOffset[12], withOffset[12], skinning[12];
+				toAffine(skeleton.boneOffsets[boneIndex], boneOffset);
+				multiplyAffine(nodeGlobal, boneOffset, withOffset);
+				multiplyAffine(globalInverse, withOffset, skinning);
+				pose.boneGlobals[boneIndex] = pose.nodeGlobals[nodeIndex];
+				pose.palette[boneIndex] = toMat4(skinning);
+			}
+		}
+	}
+}
+
+sPoseSamplerError cPoseBatchSampler::measureError(unsigned int numSamples)
+{
+	sPoseSamplerError error;
+	error.maxReferenceError = 0.0f;
+	error.maxScalarDifference = 0.0f;
+	//Random key pairs can be anything up to 180 degrees apart, far more than a frame of real animation
+	error.referenceTolerance = 2e-3f;
+	error.scalarTolerance = 1e-5f;
+
+	unsigned int stride = (numSamples + MAX_LANES - 1) / MAX_LANES * MAX_LANES;
+	std::vector<float> simdStreams(NUM_STREAMS * stride, 0.0f);
+	std::vector<glm::mat4> reference(numSamples);
+
+	unsigned int seed = 4242;
+	for (unsigned int sample = 0; sample < numSamples; sample++)
+	{
+		glm::vec3 positionA(nextRandom(seed), nextRandom(seed), nextRandom(seed));
+		glm::vec3 positionB(nextRandom(seed), nextRandom(seed), nextRandom(seed));
+		glm::vec3 scalingA = glm::vec3(nextRandom(seed), nextRandom(seed), nextRandom(seed)) + 0.5f;
+		glm::vec3 scalingB = glm::vec3(nextRandom(seed), nextRandom(seed), nextRandom(seed)) + 0.5f;
+		glm::quat rotationA = glm::normalize(glm::quat(nextRandom(seed) - 0.5f, nextRandom(seed) - 0.5f, nextRandom(seed) - 0.5f, nextRandom(seed) - 0.5f));
+		glm::quat rotationB = glm::normalize(glm::quat(nextRandom(seed) - 0.5f, nextRandom(seed) - 0.5f, nextRandom(seed) - 0.5f, nextRandom(seed) - 0.5f));
+		float factor = nextRandom(seed);
+
+		const float values[] = {
+			positionA.x, positionA.y, positionA.z, positionB.x, positionB.y, positionB.z, factor,
+			rotationA.x, rotationA.y, rotationA.z, rotationA.w, rotationB.x, rotationB.y, rotationB.z, rotationB.w, factor,
+			scalingA.x, scalingA.y, scalingA.z, scalingB.x, scalingB.y, scalingB.z, factor };
+		for (int stream = 0; stream < LOCAL_FIRST; stream++)
+		{
+			simdStreams[stream * stride + sample] = values[stream];
+		}
+
+		//What cAnimationClip::sampleChannel builds
+		glm::mat4 transform = glm::mat4_cast(glm::normalize(glm::slerp(rotationA, rotationB, factor)));
+		glm::vec3 scaling = (scalingB - scalingA) * factor + scalingA;
+		transform[0] *= scaling.x;
+		transform[1] *= scaling.y;
+		transform[2] *= scaling.z;
+		transform[3] = glm::vec4((positionB - positionA) * factor + positionA, 1.0f);
+		reference[sample] = transform;
+	}
+	std::vector<float> scalarStreams = simdStreams;
+
+	cPoseBatchSampler sampler;
+	sampler.sampleLanes(simdStreams.data(), stride, numSamples);
+	sampler.useSimd = false;
+	sampler.sampleLanes(scalarStreams.data(), stride, numSamples);
+
+	for (unsigned int sample = 0; sample < numSamples; sample++)
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				unsigned int index = (LOCAL_FIRST + row * 4 + column) * stride + sample;
+				error.maxReferenceError = glm::max(error.maxReferenceError, fabsf(simdStreams[index] - reference[sample][column][row]));
+				error.maxScalarDifference = glm::max(error.maxScalarDifference, fabsf(simdStreams[index] - scalarStreams[index]));
+			}
+		}
+	}
+	return error;
+}
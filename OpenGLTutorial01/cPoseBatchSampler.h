@@ -0,0 +1,76 @@
+#ifndef _HG_cPoseBatchSampler_
+#define _HG_cPoseBatchSampler_
+
+#include <vector>
+
+#include "cSkeleton.h"
+
+//8 lanes when the build targets AVX2 (/arch:AVX2), 4 on any other x86 build, one at a time elsewhere
+#if defined(__AVX2__)
+#define POSE_SAMPLER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define POSE_SAMPLER_SSE
+#endif
+
+//Worst case difference between the batched sampler and glm over random key pairs,
+//and between its SIMD and scalar paths, which run the same math and should agree to rounding
+struct sPoseSamplerError
+{
+	//Largest difference in any element of the TRS matrix
+	float maxReferenceError;
+	float referenceTolerance;
+	float maxScalarDifference;
+	float scalarTolerance;
+
+	bool withinTolerance();
+};
+
+//Evaluates one clip on one skeleton for many instances at once. Keys are found per instance with its cursor,
+//then gathered into structure-of-arrays lanes so every bone's interpolation runs 4 or 8 instances per instruction.
+//Rotations use nlerp with a correction on the blend factor instead of slerp, and each bone's TRS is written
+//straight into a 3x4 affine matrix, so there are no 4x4 products until the palette goes out.
+//Holds scratch memory, so use one per thread
+class cPoseBatchSampler
+{
+public:
+	cPoseBatchSampler();
+
+	//Writes every instance's nodeGlobals, palette and boneGlobals, like cSkeleton::evaluate does for one.
+	//The poses must have been sized by skeleton.allocatePose. animationTimes are in ticks
+	void evaluate(const cSkeleton& skeleton, const sClipBinding& binding, const float* animationTimes, sSkeletonPose* const* poses, unsigned int numInstances);
+
+	//Off forces the scalar path, for comparing against
+	bool useSimd;
+
+	//"AVX2", "SSE" or "scalar", whichever this build uses when useSimd is on
+	static const char* getInstructionSet();
+
+	//Samples random key pairs through both paths and glm::slerp / glm::mat4_cast
+	static sPoseSamplerError measureError(unsigned int numSamples);
+
+	//Component streams for one batch. Inputs are the two keys and the blend factor of each track,
+	//outputs the 3x4 local transform, row major, translation in the last column
+	enum eStream
+	{
+		POSITION_A_X, POSITION_A_Y, POSITION_A_Z, POSITION_B_X, POSITION_B_Y, POSITION_B_Z, POSITION_FACTOR,
+		ROTATION_A_X, ROTATION_A_Y, ROTATION_A_Z, ROTATION_A_W, ROTATION_B_X, ROTATION_B_Y, ROTATION_B_Z, ROTATION_B_W, ROTATION_FACTOR,
+		SCALING_A_X, SCALING_A_Y, SCALING_A_Z, SCALING_B_X, SCALING_B_Y, SCALING_B_Z, SCALING_FACTOR,
+		LOCAL_FIRST,
+		NUM_STREAMS = LOCAL_FIRST + 12
+	};
+
+	//Runs the interpolation and TRS composition over lanes [0, count) of streams laid out stream after stream, stride floats apart
+	void sampleLanes(float* streams, unsigned int stride, unsigned int count) const;
+
+private:
+	std::vector<float> streams;
+	//Object space 3x4 of every node for every instance, node after node, each 12 * stride floats
+	std::vector<float> globals;
+	unsigned int stride;
+
+	//Up to BATCH_SIZE instances, with the scratch already sized
+	void evaluateBatch(const cSkeleton& skeleton, const sClipBinding& binding, const float* animationTimes, sSkeletonPose* const* poses, unsigned int numInstances);
+	void gatherChannel(const cAnimationClip* clip, int channelIndex, const float* animationTimes, sSkeletonPose* const* poses, unsigned int numInstances);
+};
+
+#endif
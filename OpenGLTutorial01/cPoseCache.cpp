@@ -0,0 +1,137 @@
+#include "cPoseCache.h"
+
+#include <iostream>
+#include <cstring>
+#include <cmath>
+
+cPoseCache::cPoseCache(float quantumSeconds)
+{
+	this->quantumSeconds = quantumSeconds;
+	this->frameLookups = 0;
+	this->frameHits = 0;
+	this->totalLookups = 0;
+	this->totalHits = 0;
+}
+
+cPoseCache::~cPoseCache()
+{
+	this->beginFrame();
+	for (int index = 0; index < this->freeEntries.size(); index++)
+	{
+		delete this->freeEntries[index];
+	}
+}
+
+bool cPoseCache::sKey::operator==(const sKey& other) const
+{
+	return skeleton == other.skeleton && clip == other.clip && bucket == other.bucket && skipDetailNodes == other.skipDetailNodes;
+}
+
+size_t cPoseCache::sKeyHash::operator()(const sKey& key) const
+{
+	size_t hash = std::hash<const void*>()(key.skeleton);
+	hash = hash * 31 + std::hash<const void*>()(key.clip);
+	hash = hash * 31 + std::hash<long long>()(key.bucket);
+	return hash * 2 + (key.skipDetailNodes ? 1 : 0);
+}
+
+void cPoseCache::beginFrame()
+{
+	std::lock_guard<std::mutex> lock(this->cacheMutex);
+	std::unordered_map<sKey, sEntry*, sKeyHash>::iterator itEntry = this->entries.begin();
+	for (itEntry; itEntry != this->entries.end(); itEntry++)
+	{
+		this->freeEntries.push_back(itEntry->second);
+	}
+	this->entries.clear();
+	this->frameLookups = 0;
+	this->frameHits = 0;
+}
+
+bool cPoseCache::evaluate(const cSkeleton& skeleton, const sClipBinding& binding, float timeInSeconds, bool skipDetailNodes,
+	std::vector<glm::mat4>& palette)
+{
+	//The bucket is counted in ticks after the clip has wrapped, so every loop of the clip shares the same buckets
+	const cAnimationClip* clip = binding.clip;
+	float animationTime = clip ? clip->getAnimationTime(timeInSeconds) : 0.0f;
+	sKey key;
+	key.skeleton = &skeleton;
+	key.clip = clip;
+	key.skipDetailNodes = skipDetailNodes;
+	float quantumTicks = clip ? this->quantumSeconds * clip->ticksPerSecond : 0.0f;
+	if (quantumTicks > 0.0f)
+	{
+		//Rounded to the nearest bucket, so no pose is more than half a quantum from its own clock
+		key.bucket = (long long)floorf(animationTime / quantumTicks + 0.5f);
+		animationTime = key.bucket * quantumTicks;
+	}
+	else
+	{
+		unsigned int timeBits;
+		memcpy(&timeBits, &animationTime, sizeof(timeBits));
+		key.bucket = timeBits;
+	}
+
+	sEntry* entry = NULL;
+	bool hit = false;
+	{
+		std::lock_guard<std::mutex> lock(this->cacheMutex);
+		std::unordered_map<sKey, sEntry*, sKeyHash>::iterator itEntry = this->entries.find(key);
+		hit = itEntry != this->entries.end();
+		if (hit)
+		{
+			entry = itEntry->second;
+		}
+		else
+		{
+			if (this->freeEntries.empty())
+			{
+				entry = new sEntry();
+			}
+			else
+			{
+				entry = this->freeEntries.back();
+				this->freeEntries.pop_back();
+			}
+			entry->ready = false;
+			this->entries[key] = entry;
+		}
+		this->frameLookups++;
+		this->totalLookups++;
+		this->frameHits += hit ? 1 : 0;
+		this->totalHits += hit ? 1 : 0;
+	}
+
+	//A hit on an entry another thread is still evaluating waits here for it
+	std::lock_guard<std::mutex> entryLock(entry->mutex);
+	if (!entry->ready)
+	{
+		skeleton.allocatePose(entry->pose);
+		skeleton.evaluate(binding, animationTime, entry->pose, skipDetailNodes);
+		entry->ready = true;
+	}
+	palette = entry->pose.palette;
+	return hit;
+}
+
+float cPoseCache::getFrameHitRate()
+{
+	std::lock_guard<std::mutex> lock(this->cacheMutex);
+	return this->frameLookups > 0 ? (float)this->frameHits / this->frameLookups : 0.0f;
+}
+
+float cPoseCache::getTotalHitRate()
+{
+	std::lock_guard<std::mutex> lock(this->cacheMutex);
+	return this->totalLookups > 0 ? (float)((double)this->totalHits / this->totalLookups) : 0.0f;
+}
+
+void cPoseCache::printReport()
+{
+	float frameHitRate = this->getFrameHitRate();
+	float totalHitRate = this->getTotalHitRate();
+	std::lock_guard<std::mutex> lock(this->cacheMutex);
+	std::cout << "Pose cache (" << this->quantumSeconds * 1000.0f << " ms buckets): last frame " << this->frameHits << " of "
+		<< this->frameLookups << " poses shared (" << frameHitRate * 100.0f << "%), " << this->entries.size() << " evaluated; overall "
+		<< this->totalHits << " of " << this->totalLookups << " (" << totalHitRate * 100.0f << "%)" << std::endl;
+}
@@ -0,0 +1,72 @@
+#ifndef _HG_cPoseCache_
+#define _HG_cPoseCache_
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+#include "cSkeleton.h"
+
+//Palettes evaluated this frame, keyed by skeleton, clip and time rounded to a multiple of quantumSeconds.
+//Characters sharing a skeleton and playing the same clip in step land in the same bucket, and only the first
+//one evaluates; the rest copy its palette out, which costs a fraction of evaluating it. Every bucket is
+//evaluated at its own time, so who got there first makes no difference to the pose
+class cPoseCache
+{
+public:
+	cPoseCache(float quantumSeconds = 1.0f / 60.0f);
+	~cPoseCache();
+
+	//Forgets the last frame's poses. Call between frames, never while evaluate is running
+	void beginFrame();
+
+	//Writes the palette for the clip at this time into palette, which must already be sized for the skeleton.
+	//Returns true when someone else had already evaluated it. Safe from any thread
+	bool evaluate(const cSkeleton& skeleton, const sClipBinding& binding, float timeInSeconds, bool skipDetailNodes,
+		std::vector<glm::mat4>& palette);
+
+	//Width of a bucket. Bigger shares more and steps the animation more coarsely. 0 only shares exact times
+	float quantumSeconds;
+
+	//Since beginFrame, and since the cache was made
+	unsigned int frameLookups;
+	unsigned int frameHits;
+	unsigned long long totalLookups;
+	unsigned long long totalHits;
+
+	float getFrameHitRate();
+	float getTotalHitRate();
+	void printReport();
+
+private:
+	struct sKey
+	{
+		const cSkeleton* skeleton;
+		const cAnimationClip* clip;
+		long long bucket;
+		bool skipDetailNodes;
+
+		bool operator==(const sKey& other) const;
+	};
+	struct sKeyHash
+	{
+		size_t operator()(const sKey& key) const;
+	};
+	//Filled in once under its own mutex, so the cache lock isn't held while a pose is evaluated
+	struct sEntry
+	{
+		std::mutex mutex;
+		bool ready;
+		sSkeletonPose pose;
+	};
+
+	std::unordered_map<sKey, sEntry*, sKeyHash> entries;
+	//Entries from earlier frames, kept with their poses allocated
+	std::vector<sEntry*> freeEntries;
+	std::mutex cacheMutex;
+
+	cPoseCache(const cPoseCache&);
+	cPoseCache& operator=(const cPoseCache&);
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "cPreSkinnedMesh.h"
+
+#include "cSkinnedMesh.h"
+
+cPreSkinnedMesh::cPreSkinnedMesh(cSkinnedMesh* mesh)
+{
+	this->mesh = mesh;
+	this->uniformsProgramID = -1;
+	unsigned int numMeshes = mesh->GetNumMeshes();
+	this->vertexBuffers.resize(numMeshes);
+	this->vertexArrays.resize(numMeshes);
+	glGenBuffers(numMeshes, this->vertexBuffers.data());
+	glGenVertexArrays(numMeshes, this->vertexArrays.data());
+
+	for (unsigned int index = 0; index < numMeshes; index++)
+	{
+		cMesh& subMesh = mesh->GetSubMesh(index);
+		glBindVertexArray(this->vertexArrays[index]);
+		//Rewritten by the compute pass every frame and only ever read by the GPU
+		glBindBuffer(GL_ARRAY_BUFFER, this->vertexBuffers[index]);
+		glBufferData(GL_ARRAY_BUFFER, subMesh.GetNumVertices() * sizeof(sPreSkinnedVertex), NULL, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, subMesh.GetIndexBuffer());
+
+		//Position
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(sPreSkinnedVertex), (void*)0);
+		glEnableVertexAttribArray(0);
+		//Normals
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(sPreSkinnedVertex), (void*)offsetof(sPreSkinnedVertex, Normal));
+		glEnableVertexAttribArray(1);
+		//Texture coordinates
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(sPreSkinnedVertex), (void*)offsetof(sPreSkinnedVertex, TexCoords));
+		glEnableVertexAttribArray(2);
+		//Tangent and handedness, for shaders that normal map
+		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(sPreSkinnedVertex), (void*)offsetof(sPreSkinnedVertex, Tangent));
+		glEnableVertexAttribArray(3);
+
+		glBindVertexArray(0);
+	}
+}
+
+cPreSkinnedMesh::~cPreSkinnedMesh()
+{
+	glDeleteVertexArrays((GLsizei)this->vertexArrays.size(), this->vertexArrays.data());
+	glDeleteBuffers((GLsizei)this->vertexBuffers.size(), this->vertexBuffers.data());
+}
+
+void cPreSkinnedMesh::Draw(cShaderProgram& shader)
+{
+	shader.useProgram();
+	if (this->uniformsProgramID != shader.ID)
+	{
+		this->uniformsProgramID = shader.ID;
+		this->modelUniform = shader.getUniform<glm::mat4>("model");
+	}
+	this->modelUniform.set(glm::mat4(1.0f));
+	for (unsigned int index = 0; index < this->vertexArrays.size(); index++)
+	{
+		this->mesh->GetSubMesh(index).DrawWithVertexArray(shader, this->vertexArrays[index]);
+	}
+}
+
+cSkinnedMesh* cPreSkinnedMesh::GetMesh() const
+{
+	return this->mesh;
+}
+
+GLuint cPreSkinnedMesh::GetVertexBuffer(unsigned int subMesh) const
+{
+	return this->vertexBuffers[subMesh];
+}
@@ -0,0 +1,50 @@
+#ifndef _HG_cPreSkinnedMesh_
+#define _HG_cPreSkinnedMesh_
+
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "cShaderProgram.h"
+
+class cSkinnedMesh;
+
+//What cSkinningPass writes for every vertex: already skinned and in world space. The first three
+//attributes line up with sVertex, so the static vertex shaders draw it as it is with an identity model
+struct sPreSkinnedVertex
+{
+	glm::vec3 Position;
+	glm::vec3 Normal;
+	glm::vec2 TexCoords;
+	//w is the bitangent's handedness
+	glm::vec4 Tangent;
+};
+
+//One object's skinned vertices for this frame, a buffer per sub-mesh of its cSkinnedMesh.
+//Each has its own vertex array around that buffer and the sub-mesh's own index buffer
+class cPreSkinnedMesh
+{
+public:
+	cPreSkinnedMesh(cSkinnedMesh* mesh);
+	~cPreSkinnedMesh();
+
+	//With any shader built on a static vertex shader (vertShader.glsl, modelVert.glsl). Sets model to identity
+	void Draw(cShaderProgram& shader);
+
+	cSkinnedMesh* GetMesh() const;
+	GLuint GetVertexBuffer(unsigned int subMesh) const;
+
+private:
+	cSkinnedMesh* mesh;
+	std::vector<GLuint> vertexBuffers;
+	std::vector<GLuint> vertexArrays;
+	//Looked up again only when Draw is handed a different program
+	int uniformsProgramID;
+	sUniform<glm::mat4> modelUniform;
+
+	cPreSkinnedMesh(const cPreSkinnedMesh&);
+	cPreSkinnedMesh& operator=(const cPreSkinnedMesh&);
+};
+
+#endif
@@ -2,6 +2,7 @@
 
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 cShader::cShader()
 {
@@ -20,6 +21,55 @@ void cShader::setPath(std::string setPath)
 }
 
 bool cShader::readFile(std::string name)
+{
+	this->shaderSource.clear();
+	std::vector<std::string> includedFiles;
+	if (!appendFile(name, includedFiles))
+	{
+		return false;
+	}
+
+	//GLSL wants #version before anything else, so the defines go straight after it
+	std::vector<std::string>& defines = getDefines();
+	for (int index = 0; index < shaderSource.size(); index++)
+	{
+		if (shaderSource[index].compare(0, 8, "#version") == 0)
+		{
+			shaderSource.insert(shaderSource.begin() + index + 1, defines.begin(), defines.end());
+			break;
+		}
+	}
+
+	numberOfLines = shaderSource.size();
+
+	setArray();
+
+	return true;
+}
+
+void cShader::setDefine(const std::string& name, const std::string& value)
+{
+	std::vector<std::string>& defines = getDefines();
+	std::string start = "#define " + name + " ";
+	for (int index = 0; index < defines.size(); index++)
+	{
+		if (defines[index].compare(0, start.size(), start) == 0)
+		{
+			defines[index] = start + value;
+			return;
+		}
+	}
+	defines.push_back(start + value);
+}
+
+std::vector<std::string>& cShader::getDefines()
+{
+	//Local so it exists before any static cShaderProgram gets compiled
+	static std::vector<std::string> defines;
+	return defines;
+}
+
+bool cShader::appendFile(std::string name, std::vector<std::string>& includedFiles)
 {
 	std::string fileName = path + name;
 	std::ifstream file(fileName.c_str());
@@ -27,19 +77,38 @@ bool cShader::readFile(std::string name)
 	{
 		return false;
 	}
-
-	this->shaderSource.clear();
+	includedFiles.push_back(name);
 
 	char pLineTemp[65536] = { 0 };
 	while (file.getline(pLineTemp, 65536))
 	{
 		std::string thisLine(pLineTemp);
-		shaderSource.push_back(thisLine);
-	}
 
-	numberOfLines = shaderSource.size();
+		//#include "file.glsl" pastes that file in, relative to the same path. Each file only goes in once
+		size_t start = thisLine.find_first_not_of(" \t");
+		if (start != std::string::npos && thisLine.compare(start, 8, "#include") == 0)
+		{
+			size_t nameStart = thisLine.find('"', start);
+			size_t nameEnd = nameStart == std::string::npos ? nameStart : thisLine.find('"', nameStart + 1);
+			if (nameEnd == std::string::npos)
+			{
+				std::cout << "Bad #include in " << fileName << ": " << thisLine << std::endl;
+				continue;
+			}
+			std::string includeName = thisLine.substr(nameStart + 1, nameEnd - nameStart - 1);
+			if (std::find(includedFiles.begin(), includedFiles.end(), includeName) != includedFiles.end())
+			{
+				continue;
+			}
+			if (!appendFile(includeName, includedFiles))
+			{
+				std::cout << "Couldn't open " << path << includeName << ", included from " << fileName << std::endl;
+			}
+			continue;
+		}
 
-	setArray();
+		shaderSource.push_back(thisLine);
+	}
 
 	return true;
 }
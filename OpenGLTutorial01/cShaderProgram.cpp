@@ -1,5 +1,7 @@
 #include "cShaderProgram.h"
 
+#include "cSharedUniforms.h"
+
 cShaderProgram::cShaderProgram()
 {
 
@@ -51,6 +53,88 @@ void cShaderProgram::compileProgram(std::string path, std::string vertFile, std:
 
 	glDeleteShader(vertexShader.ID);
 	glDeleteShader(fragmentShader.ID);
+
+	this->reflectUniforms();
+	cSharedUniforms::bindBlocks(this->ID);
+}
+
+void cShaderProgram::compileComputeProgram(std::string path, std::string computeFile)
+{
+	computeShader.setPath(path);
+	computeShader.readFile(computeFile);
+
+	computeShader.ID = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(computeShader.ID, computeShader.numberOfLines, computeShader.arraySource, NULL);
+	glCompileShader(computeShader.ID);
+
+	int success;
+	glGetShaderiv(computeShader.ID, GL_COMPILE_STATUS, &success);
+
+	char infoLog[512];
+	if (!success)
+	{
+		glGetShaderInfoLog(computeShader.ID, 512, NULL, infoLog);
+		std::cout << "Compute Shader compilation failed:\n" << infoLog << std::endl;
+	}
+
+	this->ID = glCreateProgram();
+
+	glAttachShader(this->ID, computeShader.ID);
+	glLinkProgram(this->ID);
+
+	glGetProgramiv(this->ID, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		glGetProgramInfoLog(this->ID, 512, NULL, infoLog);
+		std::cout << "Compute Program linking failed:\n" << infoLog << std::endl;
+	}
+
+	glDeleteShader(computeShader.ID);
+
+	this->reflectUniforms();
+	cSharedUniforms::bindBlocks(this->ID);
+}
+
+void cShaderProgram::reflectUniforms()
+{
+	this->uniformLocations.clear();
+	GLint numUniforms = 0;
+	GLint maxNameLength = 0;
+	glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &numUniforms);
+	glGetProgramiv(this->ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+	std::vector<char> nameBuffer(maxNameLength + 1);
+
+	for (GLint index = 0; index < numUniforms; index++)
+	{
+		GLsizei nameLength = 0;
+		GLint arraySize = 0;
+		GLenum type;
+		glGetActiveUniform(this->ID, index, (GLsizei)nameBuffer.size(), &nameLength, &arraySize, &type, nameBuffer.data());
+		std::string name(nameBuffer.data(), nameLength);
+		GLint location = glGetUniformLocation(this->ID, name.c_str());
+		//Members of uniform blocks have no location of their own
+		if (location < 0)
+			continue;
+		this->uniformLocations[name] = location;
+
+		//Arrays are reported once, as name[0]
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+		{
+			std::string baseName = name.substr(0, name.size() - 3);
+			this->uniformLocations[baseName] = location;
+			for (GLint element = 1; element < arraySize; element++)
+			{
+				std::string elementName = baseName + "[" + std::to_string(element) + "]";
+				this->uniformLocations[elementName] = glGetUniformLocation(this->ID, elementName.c_str());
+			}
+		}
+	}
+}
+
+GLint cShaderProgram::getUniformLocation(const std::string& name) const
+{
+	std::unordered_map<std::string, GLint>::const_iterator it = this->uniformLocations.find(name);
+	return it != this->uniformLocations.end() ? it->second : -1;
 }
 
 void cShaderProgram::useProgram()
@@ -58,37 +142,82 @@ void cShaderProgram::useProgram()
 	glUseProgram(this->ID);
 }
 
-void cShaderProgram::setBool(std::string name, bool value)
+void cShaderProgram::setBool(const std::string& name, bool value)
+{
+	glUniform1i(getUniformLocation(name), value);
+}
+
+void cShaderProgram::setInt(const std::string& name, int value)
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+	glUniform1i(getUniformLocation(name), value);
 }
 
-void cShaderProgram::setInt(std::string name, int value)
+void cShaderProgram::setFloat(const std::string& name, float value)
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+	glUniform1f(getUniformLocation(name), value);
 }
 
-void cShaderProgram::setFloat(std::string name, float value)
+void cShaderProgram::setVec2(const std::string& name, glm::vec2 value)
 {
-	glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+	glUniform2f(getUniformLocation(name), value.x, value.y);
 }
 
-void cShaderProgram::setVec3(std::string name, glm::vec3 value)
+void cShaderProgram::setVec3(const std::string& name, glm::vec3 value)
 {
-	glUniform3f(glGetUniformLocation(ID, name.c_str()), value.x, value.y, value.z);
+	glUniform3f(getUniformLocation(name), value.x, value.y, value.z);
 }
 
-void cShaderProgram::setVec3(std::string name, float x, float y, float z)
+void cShaderProgram::setVec3(const std::string& name, float x, float y, float z)
 {
-	glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+	glUniform3f(getUniformLocation(name), x, y, z);
 }
 
-void cShaderProgram::setMat4(std::string name, glm::mat4 value)
+void cShaderProgram::setMat4(const std::string& name, glm::mat4 value)
 {
-	glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+	glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
 }
 
-void cShaderProgram::setMat4(std::string name, int count, glm::mat4 value)
+void cShaderProgram::setMat4(const std::string& name, int count, const glm::mat4& value)
 {
-	glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), count, GL_FALSE, glm::value_ptr(value));
-}
\ No newline at end of file
+	glUniformMatrix4fv(getUniformLocation(name), count, GL_FALSE, glm::value_ptr(value));
+}
+
+template <> void sUniform<bool>::set(const bool& value) const
+{
+	glUniform1i(this->location, value);
+}
+
+template <> void sUniform<int>::set(const int& value) const
+{
+	glUniform1i(this->location, value);
+}
+
+template <> void sUniform<float>::set(const float& value) const
+{
+	glUniform1f(this->location, value);
+}
+
+template <> void sUniform<glm::vec2>::set(const glm::vec2& value) const
+{
+	glUniform2f(this->location, value.x, value.y);
+}
+
+template <> void sUniform<glm::vec3>::set(const glm::vec3& value) const
+{
+	glUniform3f(this->location, value.x, value.y, value.z);
+}
+
+template <> void sUniform<glm::vec4>::set(const glm::vec4& value) const
+{
+	glUniform4f(this->location, value.x, value.y, value.z, value.w);
+}
+
+template <> void sUniform<glm::mat4>::set(const glm::mat4& value) const
+{
+	glUniformMatrix4fv(this->location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+template <> void sUniform<glm::mat4>::setArray(const glm::mat4* values, int count) const
+{
+	glUniformMatrix4fv(this->location, count, GL_FALSE, glm::value_ptr(*values));
+}
@@ -9,6 +9,7 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <unordered_map>
 
 class cShader
 {
@@ -18,6 +19,9 @@ public:
 
 	void setPath(std::string);
 	bool readFile(std::string);
+	//Goes in as #define name value right after the #version line of every shader read from then on,
+	//so a size both C++ and GLSL depend on is only written down in C++
+	static void setDefine(const std::string& name, const std::string& value);
 
 	int ID;
 	std::string path;
@@ -27,8 +31,34 @@ public:
 
 private:
 	void setArray();
+	//Reads name onto the end of shaderSource, expanding #include "file" lines. includedFiles stops a file going in twice
+	bool appendFile(std::string name, std::vector<std::string>& includedFiles);
+	static std::vector<std::string>& getDefines();
 };
 
+//A uniform's location, looked up once by name so per frame code sets it without hashing strings or asking GL.
+//The type picks the glUniform call. A uniform the program doesn't have stays at -1, which GL ignores
+template <typename tValue>
+struct sUniform
+{
+	GLint location;
+
+	sUniform() : location(-1) {};
+	//The program has to be in use, like with the set functions
+	void set(const tValue& value) const;
+	//count elements of an array uniform, starting from this one
+	void setArray(const tValue* values, int count) const;
+};
+
+template <> void sUniform<bool>::set(const bool& value) const;
+template <> void sUniform<int>::set(const int& value) const;
+template <> void sUniform<float>::set(const float& value) const;
+template <> void sUniform<glm::vec2>::set(const glm::vec2& value) const;
+template <> void sUniform<glm::vec3>::set(const glm::vec3& value) const;
+template <> void sUniform<glm::vec4>::set(const glm::vec4& value) const;
+template <> void sUniform<glm::mat4>::set(const glm::mat4& value) const;
+template <> void sUniform<glm::mat4>::setArray(const glm::mat4* values, int count) const;
+
 class cShaderProgram
 {
 public:
@@ -36,18 +66,41 @@ public:
 	~cShaderProgram();
 
 	void compileProgram(std::string path, std::string vertFile, std::string fragFile);
+	//A program with nothing but a compute shader, run with glDispatchCompute
+	void compileComputeProgram(std::string path, std::string computeFile);
 	void useProgram();
-	void setBool(std::string name, bool value);
-	void setInt(std::string name, int value);
-	void setFloat(std::string name, float value);
-	void setVec3(std::string name, glm::vec3 value);
-	void setVec3(std::string name, float x, float y, float z);
-	void setMat4(std::string name, glm::mat4 value);
-	void setMat4(std::string name, int count, glm::mat4 value);
+	//By name, through the table filled in at link time. Fine for setup; per frame code should hold an sUniform
+	void setBool(const std::string& name, bool value);
+	void setInt(const std::string& name, int value);
+	void setFloat(const std::string& name, float value);
+	void setVec2(const std::string& name, glm::vec2 value);
+	void setVec3(const std::string& name, glm::vec3 value);
+	void setVec3(const std::string& name, float x, float y, float z);
+	void setMat4(const std::string& name, glm::mat4 value);
+	//value is the first of count matrices laid out one after another
+	void setMat4(const std::string& name, int count, const glm::mat4& value);
+
+	//-1 if the program has no active uniform by that name
+	GLint getUniformLocation(const std::string& name) const;
+	template <typename tValue>
+	sUniform<tValue> getUniform(const std::string& name) const
+	{
+		sUniform<tValue> uniform;
+		uniform.location = this->getUniformLocation(name);
+		return uniform;
+	}
 
 	int ID;
 	cShader vertexShader;
 	cShader fragmentShader;
+	cShader computeShader;
+
+private:
+	//Every active uniform after linking (GL_ACTIVE_UNIFORMS). Arrays are under name, name[0], name[1] and so on,
+	//the same names glGetUniformLocation would take
+	std::unordered_map<std::string, GLint> uniformLocations;
+
+	void reflectUniforms();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "cSharedUniforms.h"
+
+const char* const cSharedUniforms::FRAME_BLOCK_NAME = "FrameData";
+const char* const cSharedUniforms::VIEW_BLOCK_NAME = "ViewData";
+
+cSharedUniforms::cSharedUniforms(unsigned int maxViews)
+{
+	this->maxViews = maxViews;
+
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment < 1)
+		alignment = 1;
+	this->viewStride = ((GLsizeiptr)sizeof(sViewUniforms) + alignment - 1) / alignment * alignment;
+
+	glGenBuffers(1, &this->frameBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, this->frameBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(sFrameUniforms), NULL, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BINDING, this->frameBuffer);
+
+	glGenBuffers(1, &this->viewBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, this->viewBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, this->viewStride * maxViews, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+cSharedUniforms::~cSharedUniforms()
+{
+	glDeleteBuffers(1, &this->frameBuffer);
+	glDeleteBuffers(1, &this->viewBuffer);
+}
+
+void cSharedUniforms::setFrame(float time, float deltaTime, unsigned int width, unsigned int height)
+{
+	sFrameUniforms frame;
+	frame.timing = glm::vec4(time, deltaTime, 0.0f, 0.0f);
+	frame.resolution = glm::vec4((float)width, (float)height, width ? 1.0f / width : 0.0f, height ? 1.0f / height : 0.0f);
+
+	glBindBuffer(GL_UNIFORM_BUFFER, this->frameBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(sFrameUniforms), &frame);
+
+	//Orphan the view slots; the driver keeps the old storage alive for draws still in flight
+	glBindBuffer(GL_UNIFORM_BUFFER, this->viewBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, this->viewStride * this->maxViews, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void cSharedUniforms::setView(unsigned int viewIndex, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPosition)
+{
+	if (viewIndex >= this->maxViews)
+		return;
+
+	sViewUniforms viewData;
+	viewData.view = view;
+	viewData.projection = projection;
+	viewData.viewProjection = projection * view;
+	viewData.cameraPosition = glm::vec4(cameraPosition, 1.0f);
+
+	glBindBuffer(GL_UNIFORM_BUFFER, this->viewBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, this->viewStride * viewIndex, sizeof(sViewUniforms), &viewData);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	this->bindView(viewIndex);
+}
+
+void cSharedUniforms::bindView(unsigned int viewIndex)
+{
+	if (viewIndex >= this->maxViews)
+		return;
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, VIEW_BINDING, this->viewBuffer, this->viewStride * viewIndex, sizeof(sViewUniforms));
+}
+
+void cSharedUniforms::bindBlocks(GLuint programID)
+{
+	GLuint blockIndex = glGetUniformBlockIndex(programID, FRAME_BLOCK_NAME);
+	if (blockIndex != GL_INVALID_INDEX)
+		glUniformBlockBinding(programID, blockIndex, FRAME_BINDING);
+
+	blockIndex = glGetUniformBlockIndex(programID, VIEW_BLOCK_NAME);
+	if (blockIndex != GL_INVALID_INDEX)
+		glUniformBlockBinding(programID, blockIndex, VIEW_BINDING);
+}
@@ -0,0 +1,60 @@
+#ifndef _HG_cSharedUniforms_
+#define _HG_cSharedUniforms_
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+//std140, the same as FrameData in assets/shaders/sharedUniforms.glsl
+struct sFrameUniforms
+{
+	glm::vec4 timing;		//Seconds since start, seconds since last frame, unused, unused
+	glm::vec4 resolution;	//Width, height, 1 / width, 1 / height
+};
+
+//std140, the same as ViewData in assets/shaders/sharedUniforms.glsl
+struct sViewUniforms
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+	glm::vec4 cameraPosition;	//w unused
+};
+
+//The per frame and per view uniform blocks every program reads, so a camera is uploaded once
+//instead of once to each program that draws with it. cShaderProgram ties the blocks to
+//FRAME_BINDING and VIEW_BINDING when it links, so there's nothing to set per program
+class cSharedUniforms
+{
+public:
+	static const GLuint FRAME_BINDING = 0;
+	static const GLuint VIEW_BINDING = 1;
+	static const char* const FRAME_BLOCK_NAME;
+	static const char* const VIEW_BLOCK_NAME;
+
+	//maxViews is how many views are drawn in a frame; each gets its own slot in the buffer
+	cSharedUniforms(unsigned int maxViews);
+	~cSharedUniforms();
+
+	//Once a frame, before the first setView. Also hands the view slots a fresh buffer,
+	//so writing this frame's views never waits on last frame's draws
+	void setFrame(float time, float deltaTime, unsigned int width, unsigned int height);
+	//One write into the view's slot, which is then bound for everything drawn after it
+	void setView(unsigned int viewIndex, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPosition);
+	//Binds a slot already written this frame, to go back to a view without uploading it again
+	void bindView(unsigned int viewIndex);
+
+	//Points the program's shared blocks at their binding points. Blocks the program doesn't use are skipped
+	static void bindBlocks(GLuint programID);
+
+private:
+	GLuint frameBuffer;
+	GLuint viewBuffer;
+	//sizeof(sViewUniforms) rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	GLsizeiptr viewStride;
+	unsigned int maxViews;
+
+	cSharedUniforms(const cSharedUniforms&);
+	cSharedUniforms& operator=(const cSharedUniforms&);
+};
+
+#endif
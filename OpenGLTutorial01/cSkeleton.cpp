@@ -0,0 +1,139 @@
+#include "cSkeleton.h"
+
+//Lives in cSkinnedMesh.cpp
+glm::mat4 AIMatrixToGLMMatrix(const aiMatrix4x4& mat);
+
+namespace
+{
+	//A hand has five fingers, a chest three children and hips three, which is what tells them apart
+	const unsigned int MIN_DETAIL_SIBLINGS = 4;
+	//Finger bones, counting the tip
+	const unsigned int MAX_DETAIL_CHAIN = 4;
+}
+
+cSkeleton::cSkeleton()
+{
+	this->globalInverseTransform = glm::mat4(1.0f);
+}
+
+void cSkeleton::build(const aiNode* root, const std::map<std::string, unsigned int>& boneNameToIndex, const std::vector<glm::mat4>& offsets)
+{
+	this->nodeNames.clear();
+	this->parentIndices.clear();
+	this->boneIndices.clear();
+	this->bindTransforms.clear();
+	this->boneOffsets = offsets;
+	this->globalInverseTransform = glm::inverse(AIMatrixToGLMMatrix(root->mTransformation));
+
+	//Depth first with our own stack. Children are pushed in reverse so they come out in file order
+	std::vector<std::pair<const aiNode*, int> > pending;
+	pending.push_back(std::make_pair(root, -1));
+	while (!pending.empty())
+	{
+		const aiNode* node = pending.back().first;
+		int parentIndex = pending.back().second;
+		pending.pop_back();
+
+		int nodeIndex = (int)this->nodeNames.size();
+		this->nodeNames.push_back(node->mName.C_Str());
+		this->parentIndices.push_back(parentIndex);
+		this->bindTransforms.push_back(AIMatrixToGLMMatrix(node->mTransformation));
+
+		std::map<std::string, unsigned int>::const_iterator it = boneNameToIndex.find(this->nodeNames.back());
+		this->boneIndices.push_back(it != boneNameToIndex.end() ? (int)it->second : -1);
+
+		for (unsigned int childIndex = node->mNumChildren; childIndex > 0; childIndex--)
+		{
+			pending.push_back(std::make_pair(node->mChildren[childIndex - 1], nodeIndex));
+		}
+	}
+
+	//Children after parents, so walking backwards sees every chain from its tip up
+	const int numNodes = (int)this->nodeNames.size();
+	std::vector<unsigned int> numChildren(numNodes, 0);
+	std::vector<unsigned int> chainLengths(numNodes, 1);
+	for (int nodeIndex = numNodes - 1; nodeIndex > 0; nodeIndex--)
+	{
+		int parentIndex = this->parentIndices[nodeIndex];
+		numChildren[parentIndex]++;
+		chainLengths[parentIndex] = glm::max(chainLengths[parentIndex], chainLengths[nodeIndex] + 1);
+	}
+	//A subtree is unbranched if no node in it has more than one child. Needs every numChildren, so it's a second pass
+	std::vector<bool> unbranched(numNodes, true);
+	for (int nodeIndex = numNodes - 1; nodeIndex > 0; nodeIndex--)
+	{
+		int parentIndex = this->parentIndices[nodeIndex];
+		unbranched[parentIndex] = unbranched[parentIndex] && unbranched[nodeIndex] && numChildren[nodeIndex] <= 1;
+	}
+	this->detailNodes.assign(numNodes, 0);
+	for (int nodeIndex = 1; nodeIndex < numNodes; nodeIndex++)
+	{
+		int parentIndex = this->parentIndices[nodeIndex];
+		bool chainStart = numChildren[parentIndex] >= MIN_DETAIL_SIBLINGS && chainLengths[nodeIndex] <= MAX_DETAIL_CHAIN;
+		this->detailNodes[nodeIndex] = this->detailNodes[parentIndex] || (chainStart && unbranched[nodeIndex] && numChildren[nodeIndex] <= 1);
+	}
+}
+
+unsigned int cSkeleton::getNumNodes() const
+{
+	return (unsigned int)this->nodeNames.size();
+}
+
+unsigned int cSkeleton::getNumBones() const
+{
+	return (unsigned int)this->boneOffsets.size();
+}
+
+int cSkeleton::findNode(const std::string& name) const
+{
+	for (int nodeIndex = 0; nodeIndex < this->nodeNames.size(); nodeIndex++)
+	{
+		if (this->nodeNames[nodeIndex] == name)
+			return nodeIndex;
+	}
+	return -1;
+}
+
+void cSkeleton::bindClip(const cAnimationClip* clip, sClipBinding& binding) const
+{
+	binding.clip = clip;
+	binding.nodeChannels.resize(this->nodeNames.size());
+	for (int nodeIndex = 0; nodeIndex < this->nodeNames.size(); nodeIndex++)
+	{
+		binding.nodeChannels[nodeIndex] = clip->findChannel(this->nodeNames[nodeIndex]);
+	}
+}
+
+void cSkeleton::allocatePose(sSkeletonPose& pose) const
+{
+	pose.nodeGlobals.resize(this->nodeNames.size());
+	pose.palette.resize(this->boneOffsets.size());
+	pose.boneGlobals.resize(this->boneOffsets.size());
+}
+
+void cSkeleton::evaluate(const sClipBinding& binding, float animationTime, sSkeletonPose& pose, bool skipDetailNodes) const
+{
+	const int numNodes = (int)this->nodeNames.size();
+	const int* parents = this->parentIndices.data();
+	const int* bones = this->boneIndices.data();
+	const unsigned char* detail = this->detailNodes.data();
+	//Without a clip every node just sits in its bind transform
+	const int* channels = binding.clip ? binding.nodeChannels.data() : NULL;
+	glm::mat4* nodeGlobals = pose.nodeGlobals.data();
+	if (pose.cursor.clip != binding.clip)
+		pose.cursor.reset(binding.clip);
+
+	for (int nodeIndex = 0; nodeIndex < numNodes; nodeIndex++)
+	{
+		int channelIndex = channels && !(skipDetailNodes && detail[nodeIndex]) ? channels[nodeIndex] : -1;
+		glm::mat4 local = channelIndex >= 0 ? binding.clip->sampleChannel(channelIndex, animationTime, &pose.cursor) : this->bindTransforms[nodeIndex];
+		nodeGlobals[nodeIndex] = parents[nodeIndex] >= 0 ? nodeGlobals[parents[nodeIndex]] * local : local;
+
+		int boneIndex = bones[nodeIndex];
+		if (boneIndex >= 0)
+		{
+			pose.boneGlobals[boneIndex] = nodeGlobals[nodeIndex];
+			pose.palette[boneIndex] = this->globalInverseTransform * nodeGlobals[nodeIndex] * this->boneOffsets[boneIndex];
+		}
+	}
+}
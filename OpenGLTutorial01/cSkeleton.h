@@ -0,0 +1,68 @@
+#ifndef _HG_cSkeleton_
+#define _HG_cSkeleton_
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <assimp/scene.h>
+
+#include "cAnimationClip.h"
+
+//A clip resolved against one skeleton: the channel that animates each node, -1 where none does
+struct sClipBinding
+{
+	const cAnimationClip* clip;
+	std::vector<int> nodeChannels;
+};
+
+//Everything one evaluation writes. Sized once by cSkeleton::allocatePose, after which evaluating into it never allocates,
+//apart from the cursor growing the first time a clip with more channels than any before it plays
+struct sSkeletonPose
+{
+	//Carries key positions from one evaluation to the next
+	sClipCursor cursor;
+	//Object space transform of every node
+	std::vector<glm::mat4> nodeGlobals;
+	//What the vertex shader's bones[] wants: globalInverse * boneGlobal * boneOffset
+	std::vector<glm::mat4> palette;
+	//Object space transform of every bone, without the offset
+	std::vector<glm::mat4> boneGlobals;
+};
+
+//The aiNode tree flattened into arrays, parents always before their children,
+//so a pose is one pass from front to back with no recursion and no strings
+class cSkeleton
+{
+public:
+	std::vector<std::string> nodeNames;
+	std::vector<int> parentIndices;
+	//-1 for nodes that only position other nodes
+	std::vector<int> boneIndices;
+	//The node's own transform from the file, already converted to glm
+	std::vector<glm::mat4> bindTransforms;
+	//Mesh space to bone space, one per bone
+	std::vector<glm::mat4> boneOffsets;
+	//1 for nodes in short unbranched chains off a node with many children: fingers and toes, the first things
+	//to stop animating at a distance. Worked out from the shape of the tree, since names differ between rigs
+	std::vector<unsigned char> detailNodes;
+	glm::mat4 globalInverseTransform;
+
+	cSkeleton();
+
+	void build(const aiNode* root, const std::map<std::string, unsigned int>& boneNameToIndex, const std::vector<glm::mat4>& offsets);
+
+	unsigned int getNumNodes() const;
+	unsigned int getNumBones() const;
+	//-1 if there's no node with that name
+	int findNode(const std::string& name) const;
+
+	void bindClip(const cAnimationClip* clip, sClipBinding& binding) const;
+	void allocatePose(sSkeletonPose& pose) const;
+
+	//animationTime is in ticks, see cAnimationClip::getAnimationTime. With skipDetailNodes the detail nodes
+	//hold their bind transform instead of being sampled
+	void evaluate(const sClipBinding& binding, float animationTime, sSkeletonPose& pose, bool skipDetailNodes = false) const;
+};
+
+#endif
@@ -1,18 +1,25 @@
 #include "cSkinnedGameObject.h"
 #include "cShaderProgram.h"
+#include "cSkinnedMeshRegistry.h"
 
 #include <stack>
 #include <glm\gtc\matrix_transform.hpp>
 
 cSkinnedGameObject::cSkinnedGameObject(std::string modelName, std::string modelDir)
 {
-	this->Model = new cSkinnedMesh(modelDir.c_str());
+	this->Model = cSkinnedMeshRegistry::getInstance().acquire(modelDir);
 
 	this->Position = glm::vec3(0.0f);
 	this->Scale = glm::vec3(1.0f);
 	this->OrientationQuat = glm::quat(0.0f, 0.0f, 0.0f, 1.0f);
 	this->OrientationEuler = glm::vec3(0.0f);
 
+	this->Animation = new cAnimationInstance(this->Model);
+	this->PreSkinnedVertices = NULL;
+	this->UniformsProgramID = -1;
+	this->LodTiers = cAnimationInstance::getDefaultLodTiers();
+	this->CurrentLodTier = 0;
+
 	this->defaultAnimState = new cAnimationState();
 	this->defaultAnimState->defaultAnimation.name = modelDir;
 	this->defaultAnimState->defaultAnimation.frameStepTime = 0.005f;
@@ -20,13 +27,19 @@ cSkinnedGameObject::cSkinnedGameObject(std::string modelName, std::string modelD
 }
 cSkinnedGameObject::cSkinnedGameObject(std::string modelName, std::string modelDir, glm::vec3 position, glm::vec3 scale, glm::vec3 orientationEuler)
 {
-	this->Model = new cSkinnedMesh(modelDir.c_str());
+	this->Model = cSkinnedMeshRegistry::getInstance().acquire(modelDir);
 
 	this->Position = position;
 	this->Scale = scale;
 	this->OrientationQuat = glm::quat(orientationEuler);
 	this->OrientationEuler = orientationEuler;
 
+	this->Animation = new cAnimationInstance(this->Model);
+	this->PreSkinnedVertices = NULL;
+	this->UniformsProgramID = -1;
+	this->LodTiers = cAnimationInstance::getDefaultLodTiers();
+	this->CurrentLodTier = 0;
+
 	this->defaultAnimState = new cAnimationState();
 	this->defaultAnimState->defaultAnimation.name = modelDir;
 	this->defaultAnimState->defaultAnimation.frameStepTime = 0.005f;
@@ -34,13 +47,19 @@ cSkinnedGameObject::cSkinnedGameObject(std::string modelName, std::string modelD
 }
 cSkinnedGameObject::cSkinnedGameObject(std::string modelName, std::string modelDir, glm::vec3 position, glm::vec3 scale, glm::vec3 orientationEuler, std::vector<std::string> charAnimations)
 {
-	this->Model = new cSkinnedMesh(modelDir.c_str());
+	this->Model = cSkinnedMeshRegistry::getInstance().acquire(modelDir);
 
 	this->Position = position;
 	this->Scale = scale;
 	this->OrientationQuat = glm::quat(orientationEuler);
 	this->OrientationEuler = orientationEuler;
 
+	this->Animation = new cAnimationInstance(this->Model);
+	this->PreSkinnedVertices = NULL;
+	this->UniformsProgramID = -1;
+	this->LodTiers = cAnimationInstance::getDefaultLodTiers();
+	this->CurrentLodTier = 0;
+
 	this->defaultAnimState = new cAnimationState();
 	this->defaultAnimState->defaultAnimation.name = modelDir;
 	this->defaultAnimState->defaultAnimation.frameStepTime = 0.005f;
@@ -60,13 +79,19 @@ cSkinnedGameObject::cSkinnedGameObject(std::string modelName, std::string modelD
 }
 cSkinnedGameObject::cSkinnedGameObject(std::string modelName, std::string modelDir, glm::vec3 position, glm::vec3 scale, glm::vec3 orientationEuler, std::map<int, std::string> mapAnimations)
 {
-	this->Model = new cSkinnedMesh(modelDir.c_str());
+	this->Model = cSkinnedMeshRegistry::getInstance().acquire(modelDir);
 
 	this->Position = position;
 	this->Scale = scale;
 	this->OrientationQuat = glm::quat(orientationEuler);
 	this->OrientationEuler = orientationEuler;
 
+	this->Animation = new cAnimationInstance(this->Model);
+	this->PreSkinnedVertices = NULL;
+	this->UniformsProgramID = -1;
+	this->LodTiers = cAnimationInstance::getDefaultLodTiers();
+	this->CurrentLodTier = 0;
+
 	this->defaultAnimState = new cAnimationState();
 	this->defaultAnimState->defaultAnimation.name = modelDir;
 	this->defaultAnimState->defaultAnimation.frameStepTime = 0.05f;
@@ -91,13 +116,19 @@ cSkinnedGameObject::cSkinnedGameObject(std::string modelName, std::string modelD
 }
 cSkinnedGameObject::cSkinnedGameObject(std::string modelName, std::string modelDir, glm::vec3 position, glm::vec3 scale, glm::vec3 orientationEuler, float speed, std::map<int, std::string> mapAnimations)
 {
-	this->Model = new cSkinnedMesh(modelDir.c_str());
+	this->Model = cSkinnedMeshRegistry::getInstance().acquire(modelDir);
 
 	this->Position = position;
 	this->Scale = scale;
 	this->OrientationQuat = glm::quat(orientationEuler);
 	this->OrientationEuler = orientationEuler;
 
+	this->Animation = new cAnimationInstance(this->Model);
+	this->PreSkinnedVertices = NULL;
+	this->UniformsProgramID = -1;
+	this->LodTiers = cAnimationInstance::getDefaultLodTiers();
+	this->CurrentLodTier = 0;
+
 	this->defaultAnimState = new cAnimationState();
 	this->defaultAnimState->defaultAnimation.name = modelDir;
 	this->defaultAnimState->defaultAnimation.frameStepTime = 0.05f;
@@ -121,6 +152,13 @@ cSkinnedGameObject::cSkinnedGameObject(std::string modelName, std::string modelD
 	this->TurnSpeed = 50.0f;
 	this->Speed = speed;
 }
+cSkinnedGameObject::~cSkinnedGameObject()
+{
+	delete this->Animation;
+	delete this->PreSkinnedVertices;
+	cSkinnedMeshRegistry::getInstance().release(this->Model);
+}
+
 void cSkinnedGameObject::Move(float deltaTime)
 {
 	this->OrientationEuler.y += deltaTime * CurrentTurnSpeed;
@@ -130,50 +168,91 @@ void cSkinnedGameObject::Move(float deltaTime)
 	this->Position += glm::vec3(dx, 0.0f, dz);
 }
 
-void cSkinnedGameObject::Draw(cShaderProgram Shader)
+void cSkinnedGameObject::Update(const glm::vec3& cameraPosition, cPoseCache* poseCache)
 {
 	//std::string animToPlay = "";
 	float curFrameTime = 0.0f;
+	float frameStepTime = 0.0f;
 
 
 	if (this->defaultAnimState->defaultAnimation.name == this->animToPlay)
 	{
 		this->defaultAnimState->defaultAnimation.IncrementTime();
 		curFrameTime = this->defaultAnimState->defaultAnimation.currentTime;
+		frameStepTime = this->defaultAnimState->defaultAnimation.frameStepTime;
 	}
 	else
 	{
 		/*if (this->curAnimState->defaultAnimation.name != this->animToPlay)
 			this->curAnimState->defaultAnimation.curTime = 0.0f;*/
 
-		this->curAnimState->defaultAnimation.totalTime = this->Model->MapAnimationNameToScene[this->animToPlay]->mAnimations[0]->mDuration / 
-		this->Model->MapAnimationNameToScene[this->animToPlay]->mAnimations[0]->mTicksPerSecond;
+		this->Animation->setClip(this->animToPlay);
+		const cAnimationClip* clip = this->Animation->getClip();
+		if (clip)
+			this->curAnimState->defaultAnimation.totalTime = clip->duration / clip->ticksPerSecond;
 		this->curAnimState->defaultAnimation.name = this->animToPlay;
 		this->curAnimState->defaultAnimation.IncrementTime();
 		curFrameTime = this->curAnimState->defaultAnimation.currentTime;
+		frameStepTime = this->curAnimState->defaultAnimation.frameStepTime;
 	}
 
-	std::vector<glm::mat4> vecFinalTransformation;
-	std::vector<glm::mat4> vecOffsets;
+	this->Animation->setClip(this->animToPlay);
 
-	this->Model->BoneTransform(curFrameTime, animToPlay, vecFinalTransformation, this->vecBoneTransformation, vecOffsets);
-	
-	GLuint numBonesUsed = static_cast<GLuint>(vecFinalTransformation.size());
+	if (this->LodTiers.empty())
+	{
+		this->Animation->evaluate(curFrameTime, false, poseCache);
+		return;
+	}
+	float largestScale = glm::max(this->Scale.x, glm::max(this->Scale.y, this->Scale.z));
+	this->CurrentLodTier = cAnimationInstance::selectLodTier(this->LodTiers, glm::distance(this->Position, cameraPosition), largestScale, this->CurrentLodTier);
+	const sAnimationLodTier& tier = this->LodTiers[this->CurrentLodTier];
+	this->Animation->evaluateLod(curFrameTime, frameStepTime, tier.updateInterval, tier.skipDetailNodes, poseCache);
+}
+
+void cSkinnedGameObject::Draw(cShaderProgram& Shader)
+{
+	GLuint numBonesUsed = static_cast<GLuint>(this->Animation->pose.palette.size());
 	glUseProgram(Shader.ID);
-	Shader.setInt("numBonesUsed", numBonesUsed);
-	glm::mat4* boneMatrixArray = &(vecFinalTransformation[0]);
+	if (this->UniformsProgramID != Shader.ID)
+	{
+		this->UniformsProgramID = Shader.ID;
+		this->NumBonesUsedUniform = Shader.getUniform<int>("numBonesUsed");
+		this->BonesUniform = Shader.getUniform<glm::mat4>("bones");
+		this->ModelUniform = Shader.getUniform<glm::mat4>("model");
+	}
+	this->NumBonesUsedUniform.set((int)numBonesUsed);
+	glm::mat4* boneMatrixArray = &(this->Animation->pose.palette[0]);
 	//glUniformMatrix4fv(glGetUniformLocation(Shader.ID, "Bones"), numBonesUsed, GL_FALSE, (const GLfloat*) glm::value_ptr(*boneMatrixArray));
-	Shader.setMat4("bones", numBonesUsed, *boneMatrixArray);
+	this->BonesUniform.setArray(boneMatrixArray, numBonesUsed);
 	//Shader.setMat4("bones", numBonesUsed, vecFinalTransformation[0]);
 
+	this->ModelUniform.set(this->GetModelMatrix());
+
+	this->Model->Draw(Shader);
+}
 
+glm::mat4 cSkinnedGameObject::GetModelMatrix() const
+{
 	glm::mat4 model = glm::mat4(1.0f);
 	model = glm::translate(model, this->Position);
 	model = glm::rotate(model, glm::radians(this->OrientationEuler.x), glm::vec3(1.0f, 0.0f, 0.0f));
 	model = glm::rotate(model, glm::radians(this->OrientationEuler.y), glm::vec3(0.0f, 1.0f, 0.0f));
 	model = glm::rotate(model, glm::radians(this->OrientationEuler.z), glm::vec3(0.0f, 0.0f, 1.0f));
 	model = glm::scale(model, this->Scale);
-	Shader.setMat4("model", model);
+	return model;
+}
 
-	this->Model->Draw(Shader);
-}
\ No newline at end of file
+const std::vector<glm::mat4>& cSkinnedGameObject::GetBonePalette() const
+{
+	return this->Animation->pose.palette;
+}
+
+cSkinnedMesh* cSkinnedGameObject::GetMesh() const
+{
+	return this->Model;
+}
+void cSkinnedGameObject::DrawPreSkinned(cShaderProgram& Shader)
+{
+	if (this->PreSkinnedVertices)
+		this->PreSkinnedVertices->Draw(Shader);
+}
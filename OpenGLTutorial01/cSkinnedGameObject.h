@@ -9,6 +9,8 @@
 
 #include "cSkinnedMesh.h"
 #include "cAnimationState.h"
+#include "cAnimationInstance.h"
+#include "cPreSkinnedMesh.h"
 
 
 class cSkinnedGameObject
@@ -23,7 +25,19 @@ public:
 	cSkinnedGameObject(std::string modelName, std::string modelDir, glm::vec3 position, glm::vec3 scale, glm::vec3 orientationEuler, std::vector<std::string> charAnimations);
 	cSkinnedGameObject(std::string modelName, std::string modelDir, glm::vec3 position, glm::vec3 scale, glm::vec3 orientationEuler, std::map<int, std::string> charAnimations);
 	cSkinnedGameObject(std::string modelName, std::string modelDir, glm::vec3 position, glm::vec3 scale, glm::vec3 orientationEuler, float speed, std::map<int, std::string> charAnimations);
-	void Draw(cShaderProgram Shader);
+	~cSkinnedGameObject();
+	//Advances the clock and evaluates the pose at the level of detail for this distance from the camera.
+	//Touches no GL and nothing shared but the pose cache, so cAnimationUpdater runs it for many objects at once on worker threads.
+	//With a cache, objects in step with others on the same model share their poses
+	void Update(const glm::vec3& cameraPosition, cPoseCache* poseCache = NULL);
+	//Uploads the pose the last Update wrote and draws. Context thread only
+	void Draw(cShaderProgram& Shader);
+	//What Draw uploads, for cSkinnedInstanceRenderer to pack with other instances instead
+	glm::mat4 GetModelMatrix() const;
+	const std::vector<glm::mat4>& GetBonePalette() const;
+	cSkinnedMesh* GetMesh() const;
+	//Draws the vertices the last cSkinningPass wrote, with a static shader. Does nothing before the first pass
+	void DrawPreSkinned(cShaderProgram& Shader);
 	void Move(float deltaTime);
 	std::vector<std::string> vecCharacterAnimations;
 	std::map<int, std::string> mapCharacterAnimations;
@@ -33,8 +47,24 @@ public:
 	float TurnSpeed;
 	float CurrentSpeed;
 	float CurrentTurnSpeed;
+	//Animation level of detail by distance, see sAnimationLodTier. Empty evaluates every frame in full
+	std::vector<sAnimationLodTier> LodTiers;
+	//The tier the last Update used
+	unsigned int CurrentLodTier;
+	//Made and written by cSkinningPass, NULL until it first skins this object
+	cPreSkinnedMesh* PreSkinnedVertices;
 private:
+	//Shared with every other object using the same model file, see cSkinnedMeshRegistry
 	cSkinnedMesh* Model;
-	std::vector<glm::mat4> vecBoneTransformation;
+	//This object's clip and pose, evaluated into every frame without allocating
+	cAnimationInstance* Animation;
+	//Looked up again only when Draw is handed a different program
+	int UniformsProgramID;
+	sUniform<int> NumBonesUsedUniform;
+	sUniform<glm::mat4> BonesUniform;
+	sUniform<glm::mat4> ModelUniform;
+
+	cSkinnedGameObject(const cSkinnedGameObject&);
+	cSkinnedGameObject& operator=(const cSkinnedGameObject&);
 };
 #endif // !_GAME_OBJECT_
@@ -0,0 +1,92 @@
+#include "cSkinnedInstanceRenderer.h"
+
+#include <algorithm>
+
+#include "cSkinnedGameObject.h"
+#include "cShaderProgram.h"
+
+cSkinnedInstanceRenderer::cSkinnedInstanceRenderer()
+{
+	this->lastDrawCalls = 0;
+	this->lastInstances = 0;
+	this->paletteCapacity = 0;
+	this->modelCapacity = 0;
+	this->uniformsProgramID = -1;
+
+	glGenBuffers(1, &this->paletteBuffer);
+	glGenBuffers(1, &this->modelBuffer);
+	this->maxBlockBytes = 0;
+	glGetInteger64v(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &this->maxBlockBytes);
+	//The spec's minimum, in case the query isn't supported
+	if (this->maxBlockBytes <= 0)
+		this->maxBlockBytes = 16 * 1024 * 1024;
+}
+
+cSkinnedInstanceRenderer::~cSkinnedInstanceRenderer()
+{
+	glDeleteBuffers(1, &this->paletteBuffer);
+	glDeleteBuffers(1, &this->modelBuffer);
+}
+
+void cSkinnedInstanceRenderer::add(cSkinnedGameObject* object)
+{
+	this->queued[object->GetMesh()].push_back(object);
+}
+
+void cSkinnedInstanceRenderer::upload(GLuint buffer, size_t& capacity, const std::vector<glm::mat4>& matrices)
+{
+	size_t bytes = matrices.size() * sizeof(glm::mat4);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+	//Grow by half again so a crowd that keeps growing doesn't reallocate every frame
+	if (bytes > capacity)
+		capacity = std::max(bytes, capacity + capacity / 2);
+	//Orphaning the old storage means the driver doesn't wait for the GPU to finish reading it
+	glBufferData(GL_SHADER_STORAGE_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes, matrices.data());
+}
+
+void cSkinnedInstanceRenderer::flush(cShaderProgram& shader)
+{
+	this->lastDrawCalls = 0;
+	this->lastInstances = 0;
+	shader.useProgram();
+	if (this->uniformsProgramID != shader.ID)
+	{
+		this->uniformsProgramID = shader.ID;
+		this->numBonesUsedUniform = shader.getUniform<int>("numBonesUsed");
+	}
+
+	std::map<cSkinnedMesh*, std::vector<cSkinnedGameObject*> >::iterator itMesh = this->queued.begin();
+	for (itMesh; itMesh != this->queued.end(); itMesh++)
+	{
+		cSkinnedMesh* mesh = itMesh->first;
+		std::vector<cSkinnedGameObject*>& objects = itMesh->second;
+		unsigned int numBones = std::max(mesh->NumBones, 1u);
+		unsigned int maxPerDraw = (unsigned int)std::max<GLint64>(1, this->maxBlockBytes / (numBones * sizeof(glm::mat4)));
+		this->numBonesUsedUniform.set((int)numBones);
+
+		for (unsigned int first = 0; first < objects.size(); first += maxPerDraw)
+		{
+			unsigned int count = std::min(maxPerDraw, (unsigned int)objects.size() - first);
+			this->palettes.resize(count * numBones);
+			this->models.resize(count);
+			for (unsigned int instance = 0; instance < count; instance++)
+			{
+				const std::vector<glm::mat4>& palette = objects[first + instance]->GetBonePalette();
+				std::copy(palette.begin(), palette.begin() + std::min((unsigned int)palette.size(), numBones), this->palettes.begin() + instance * numBones);
+				this->models[instance] = objects[first + instance]->GetModelMatrix();
+			}
+
+			this->upload(this->paletteBuffer, this->paletteCapacity, this->palettes);
+			this->upload(this->modelBuffer, this->modelCapacity, this->models);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PALETTE_BINDING, this->paletteBuffer);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MODEL_BINDING, this->modelBuffer);
+
+			mesh->Draw(shader, count);
+			this->lastDrawCalls += mesh->GetNumMeshes();
+			this->lastInstances += count;
+		}
+	}
+	//Meshes can be released between frames, so none are kept
+	this->queued.clear();
+}
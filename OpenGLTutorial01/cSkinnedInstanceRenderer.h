@@ -0,0 +1,58 @@
+#ifndef _HG_cSkinnedInstanceRenderer_
+#define _HG_cSkinnedInstanceRenderer_
+
+#include <map>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "cShaderProgram.h"
+
+class cSkinnedGameObject;
+class cSkinnedMesh;
+
+//Draws every queued skinned object that shares a cSkinnedMesh in one instanced call per sub-mesh.
+//The bone palettes of all of them go into one shader storage buffer and their model matrices into another,
+//which animInstancedVert.glsl indexes by gl_InstanceID, so there's no per object upload and no bone cap.
+//Needs GL 4.3 and the context thread
+class cSkinnedInstanceRenderer
+{
+public:
+	cSkinnedInstanceRenderer();
+	~cSkinnedInstanceRenderer();
+
+	//Queues the object's current pose for the next flush. The object must have been updated this frame
+	void add(cSkinnedGameObject* object);
+	//Uploads and draws everything queued with a shader built from animInstancedVert.glsl, then empties the queue
+	void flush(cShaderProgram& shader);
+
+	//From the last flush
+	unsigned int lastDrawCalls;
+	unsigned int lastInstances;
+
+private:
+	static const GLuint PALETTE_BINDING = 0;
+	static const GLuint MODEL_BINDING = 1;
+
+	std::map<cSkinnedMesh*, std::vector<cSkinnedGameObject*> > queued;
+	std::vector<glm::mat4> palettes;
+	std::vector<glm::mat4> models;
+
+	GLuint paletteBuffer;
+	GLuint modelBuffer;
+	size_t paletteCapacity;
+	size_t modelCapacity;
+	//Largest shader storage block the driver takes, which caps how many instances fit in one draw
+	GLint64 maxBlockBytes;
+	//Looked up again only when flush is handed a different program
+	int uniformsProgramID;
+	sUniform<int> numBonesUsedUniform;
+
+	void upload(GLuint buffer, size_t& capacity, const std::vector<glm::mat4>& matrices);
+
+	cSkinnedInstanceRenderer(const cSkinnedInstanceRenderer&);
+	cSkinnedInstanceRenderer& operator=(const cSkinnedInstanceRenderer&);
+};
+
+#endif
@@ -7,12 +7,17 @@
 
 #include <glad\glad.h>
 #include <sstream>
+#include <iostream>
+#include <chrono>
 
 #include "cShaderProgram.h"
+#include "cTextureRegistry.h"
+#include "cVertexQuantizer.h"
+#include "cAnimationClipLibrary.h"
 
 #include <SOIL2\SOIL2.h>
 
-unsigned int SMTextureFromFile(const char* path, const std::string &directory, bool gamma = false);
+unsigned int SMTextureFromFile(const char* path, const std::string &directory, const void* owner, bool gamma = false);
 
 glm::mat4 AIMatrixToGLMMatrix(const aiMatrix4x4& mat)
 {
@@ -39,6 +44,7 @@ void cSkinnedMesh::sVertexBoneData::AddBoneData(unsigned int BoneID, float Weigh
 cSkinnedMesh::cSkinnedMesh(const std::string& filename)
 {
 	this->Scene = 0;
+	this->DefaultClip.clip = NULL;
 	
 	this->NumBones = 0;
 	this->NumVertices = 0;
@@ -47,15 +53,29 @@ cSkinnedMesh::cSkinnedMesh(const std::string& filename)
 
 	this->Filename = filename;
 	this->Name = filename;
+	this->MeshBytes = 0;
 
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
 	LoadMeshFromFile(filename);
+	std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - startTime;
+	this->LoadTimeMs = elapsed.count();
 
 	return;
 }
 
 cSkinnedMesh::~cSkinnedMesh()
 {
+	for (unsigned int i = 0; i < this->vecTexturesLoaded.size(); i++)
+	{
+		cTextureRegistry::getInstance().release(this->vecTexturesLoaded[i].ID);
+	}
 
+	delete this->DefaultClip.clip;
+	std::map<std::string, sClipBinding>::iterator itClip = this->MapAnimationNameToClip.begin();
+	for (itClip; itClip != this->MapAnimationNameToClip.end(); itClip++)
+	{
+		cAnimationClipLibrary::getInstance().release(itClip->second.clip);
+	}
 }
 
 bool cSkinnedMesh::LoadMeshFromFile(const std::string &filename)
@@ -75,6 +95,20 @@ bool cSkinnedMesh::LoadMeshFromFile(const std::string &filename)
 	}
 	this->directory = filename.substr(0, filename.find_last_of('/'));
 	processNode(Scene->mRootNode, Scene);
+
+	//Every bone is known now, so the skeleton can be flattened and the built in animation bound to it
+	std::vector<glm::mat4> boneOffsets(this->NumBones);
+	for (unsigned int boneIndex = 0; boneIndex < this->NumBones; boneIndex++)
+	{
+		boneOffsets[boneIndex] = this->VecBoneInfo[boneIndex].BoneOffset;
+	}
+	this->Skeleton.build(Scene->mRootNode, this->MapBoneNameToBoneIndex, boneOffsets);
+	this->Skeleton.allocatePose(this->pose);
+	if (Scene->mNumAnimations > 0)
+	{
+		this->DefaultClip.clip = new cAnimationClip(Scene->mAnimations[0], filename);
+		this->Skeleton.bindClip(this->DefaultClip.clip, this->DefaultClip);
+	}
 	return true;
 }
 
@@ -141,45 +175,102 @@ void cSkinnedMesh::LoadBones(const aiMesh* Mesh, std::vector<sVertexBoneData> &v
 
 float cSkinnedMesh::FindAnimationTotalTime(std::string animationName)
 {
-	std::map< std::string, const aiScene* >::iterator itAnimation = this->MapAnimationNameToScene.find(animationName);
+	std::map<std::string, sClipBinding>::iterator itClip = this->MapAnimationNameToClip.find(animationName);
 
-	if (itAnimation == this->MapAnimationNameToScene.end())
+	if (itClip == this->MapAnimationNameToClip.end())
 	{	
 		return 0.0f;
 	}
-	return (float)itAnimation->second->mAnimations[0]->mDuration;
+	return itClip->second.clip->duration;
 }
 
 bool cSkinnedMesh::LoadMeshAnimation(const std::string &filename)
 {
-	unsigned int Flags = aiProcess_Triangulate | aiProcess_OptimizeMeshes | aiProcess_OptimizeGraph | aiProcess_JoinIdenticalVertices;
+	//The mesh is shared, so every game object using it asks for the same clips
+	if (this->MapAnimationNameToClip.find(filename) != this->MapAnimationNameToClip.end())
+	{
+		return true;
+	}
 
-	Assimp::Importer* pImporter = new Assimp::Importer();
-	const aiScene* pAniScene = pImporter->ReadFile(filename.c_str(), Flags);
-	if (!pAniScene)
+	const cAnimationClip* clip = cAnimationClipLibrary::getInstance().acquire(filename);
+	if (!clip)
 	{
 		return false;
 	}
-	this->MapAnimationNameToScene[filename] = pAniScene;
 
+	sClipBinding binding;
+	this->Skeleton.bindClip(clip, binding);
+	unsigned int numBoundNodes = 0;
+	for (unsigned int nodeIndex = 0; nodeIndex < binding.nodeChannels.size(); nodeIndex++)
+	{
+		numBoundNodes += binding.nodeChannels[nodeIndex] >= 0 ? 1 : 0;
+	}
+	if (numBoundNodes == 0)
+	{
+		std::cout << filename << " doesn't animate any node in " << this->Filename << std::endl;
+		cAnimationClipLibrary::getInstance().release(clip);
+		return false;
+	}
+
+	this->MapAnimationNameToClip[filename] = binding;
 	return true;
 }
 
+const sClipBinding& cSkinnedMesh::FindClip(const std::string& animationName) const
+{
+	std::map<std::string, sClipBinding>::const_iterator itClip = this->MapAnimationNameToClip.find(animationName);
+	if (itClip == this->MapAnimationNameToClip.end())
+	{
+		return this->DefaultClip;
+	}
+	return itClip->second;
+}
+
+void cSkinnedMesh::BoneTransform(float TimeInSeconds,
+	std::string animationName,
+	std::vector<glm::mat4> &FinalTransformation,
+	std::vector<glm::mat4> &Globals,
+	std::vector<glm::mat4> &Offsets)
+{
+	this->BoneTransform(TimeInSeconds, this->FindClip(animationName), FinalTransformation, Globals, Offsets);
+}
+
 void cSkinnedMesh::BoneTransform(float TimeInSeconds,
-	std::string animationName,		// Now we can pick the animation
+	const sClipBinding& clip,
+	std::vector<glm::mat4> &FinalTransformation,
+	std::vector<glm::mat4> &Globals,
+	std::vector<glm::mat4> &Offsets)
+{
+	this->EvaluatePose(TimeInSeconds, clip, this->pose);
+
+	//Assigning into vectors that are already the right size doesn't allocate
+	FinalTransformation = this->pose.palette;
+	Globals = this->pose.boneGlobals;
+	Offsets = this->Skeleton.boneOffsets;
+}
+
+void cSkinnedMesh::EvaluatePose(float TimeInSeconds, const sClipBinding& clip, sSkeletonPose& pose) const
+{
+	//Each clip runs on its own clock, the scene path used the mesh file's animation for every clip
+	float AnimationTime = clip.clip ? clip.clip->getAnimationTime(TimeInSeconds) : 0.0f;
+	this->Skeleton.evaluate(clip, AnimationTime, pose);
+}
+
+void cSkinnedMesh::BoneTransformFromScene(float TimeInSeconds,
+	const aiAnimation* pAnimation,
 	std::vector<glm::mat4> &FinalTransformation,
 	std::vector<glm::mat4> &Globals,
 	std::vector<glm::mat4> &Offsets)
 {
 	glm::mat4 Identity(1.0f);
 
-	float TicksPerSecond = static_cast<float>(this->Scene->mAnimations[0]->mTicksPerSecond != 0 ?
-		this->Scene->mAnimations[0]->mTicksPerSecond : 25.0);
+	float TicksPerSecond = static_cast<float>(pAnimation->mTicksPerSecond != 0 ?
+		pAnimation->mTicksPerSecond : 25.0);
 
 	float TimeInTicks = TimeInSeconds * TicksPerSecond;
-	float AnimationTime = fmod(TimeInTicks, (float)this->Scene->mAnimations[0]->mDuration);
+	float AnimationTime = fmod(TimeInTicks, (float)pAnimation->mDuration);
 
-	this->ReadNodeHierarchy(AnimationTime, animationName, this->Scene->mRootNode, Identity);
+	this->ReadNodeHierarchy(AnimationTime, pAnimation, this->Scene->mRootNode, Identity);
 
 	FinalTransformation.resize(this->NumBones);
 	Globals.resize(this->NumBones);
@@ -245,19 +336,12 @@ unsigned int cSkinnedMesh::FindScaling(float AnimationTime, const aiNodeAnim* pN
 }
 
 void cSkinnedMesh::ReadNodeHierarchy(float AnimationTime,
-	std::string animationName,
+	const aiAnimation* pAnimation,
 	const aiNode* pNode,
 	const glm::mat4 &ParentTransformMatrix)
 {
 	aiString NodeName(pNode->mName.data);
 
-	const aiAnimation* pAnimation = this->Scene->mAnimations[0];
-	std::map< std::string, const aiScene* >::iterator itAnimation = MapAnimationNameToScene.find(animationName);
-	if (itAnimation != MapAnimationNameToScene.end())
-	{
-		pAnimation = reinterpret_cast<const aiAnimation*>(itAnimation->second->mAnimations[0]);
-	}
-
 	glm::mat4 NodeTransformation = AIMatrixToGLMMatrix(pNode->mTransformation);
 	const aiNodeAnim* pNodeAnim = this->FindNodeAnimationChannel(pAnimation, NodeName);
 
@@ -300,7 +384,7 @@ void cSkinnedMesh::ReadNodeHierarchy(float AnimationTime,
 
 	for (unsigned int ChildIndex = 0; ChildIndex != pNode->mNumChildren; ChildIndex++)
 	{
-		this->ReadNodeHierarchy(AnimationTime, animationName,
+		this->ReadNodeHierarchy(AnimationTime, pAnimation,
 			pNode->mChildren[ChildIndex], ObjectBoneTransformation);
 	}
 }
@@ -465,10 +549,20 @@ float cSkinnedMesh::GetAnimationDuration(const aiScene* scene)
 }
 
 
-void cSkinnedMesh::Draw(cShaderProgram shader)
+unsigned int cSkinnedMesh::GetNumMeshes() const
+{
+	return (unsigned int)this->vecMeshes.size();
+}
+
+cMesh& cSkinnedMesh::GetSubMesh(unsigned int index)
+{
+	return this->vecMeshes[index];
+}
+
+void cSkinnedMesh::Draw(cShaderProgram& shader, unsigned int numInstances)
 {
 	for (unsigned int i = 0; i < this->vecMeshes.size(); i++)
-		this->vecMeshes[i].Draw(shader);
+		this->vecMeshes[i].Draw(shader, numInstances);
 }
 
 void cSkinnedMesh::processNode(aiNode * node, const aiScene * scene)
@@ -575,7 +669,20 @@ cMesh cSkinnedMesh::processMesh(aiMesh * mesh, const aiScene * scene)
 	std::vector<sTexture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
 	textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
-	return cMesh(vertices, indices, textures);
+	std::vector<sPackedSkinnedVertex> packedVertices;
+	cVertexQuantizer::packSkinned(vertices.data(), (unsigned int)vertices.size(), packedVertices);
+	sSkinningError error = cVertexQuantizer::measureSkinningError(vertices.data(), packedVertices.data(), (unsigned int)vertices.size());
+	std::cout << "Packed " << this->Filename << " mesh " << mesh->mName.C_Str() << ": " << vertices.size() * sizeof(sSkinnedMeshVertex) / 1024 << " KB -> "
+		<< packedVertices.size() * sizeof(sPackedSkinnedVertex) / 1024 << " KB, max skinning error position " << error.maxPositionError
+		<< " (tolerance " << error.positionTolerance << "), normal " << error.maxNormalErrorDegrees << " deg, tangent "
+		<< error.maxTangentErrorDegrees << " deg (tolerance " << error.frameToleranceDegrees << "), " << error.numRenormalized
+		<< " vertices renormalized" << (error.withinTolerance() ? "" : " OUT OF TOLERANCE");
+	if (error.numBoneIDsOutOfRange > 0)
+		std::cout << ", " << error.numBoneIDsOutOfRange << " vertices with bone IDs over 255";
+	std::cout << std::endl;
+
+	this->MeshBytes += packedVertices.size() * sizeof(sPackedSkinnedVertex) + indices.size() * sizeof(GLuint);
+	return cMesh(packedVertices, indices, textures);
 }
 
 std::vector<sTexture> cSkinnedMesh::loadMaterialTextures(aiMaterial * mat, aiTextureType type, std::string typeName)
@@ -586,30 +693,19 @@ std::vector<sTexture> cSkinnedMesh::loadMaterialTextures(aiMaterial * mat, aiTex
 	{
 		aiString str;
 		mat->GetTexture(type, i, &str);
-		bool skip = false;
-		for (unsigned int j = 0; j < this->vecTexturesLoaded.size(); j++)
-		{
-			if (std::strcmp(this->vecTexturesLoaded[j].path.data(), str.C_Str()) == 0)
-			{
-				textures.push_back(this->vecTexturesLoaded[j]);
-				skip = true;
-				break;
-			}
-		}
-		if (!skip)
-		{
-			sTexture texture;
-			texture.ID = SMTextureFromFile(str.C_Str(), this->directory);
-			texture.type = typeName;
-			texture.path = str.C_Str();
-			textures.push_back(texture);
-			this->vecTexturesLoaded.push_back(texture);
-		}
+
+		//The registry hands back the shared copy if anything has loaded this file already
+		sTexture texture;
+		texture.ID = SMTextureFromFile(str.C_Str(), this->directory, this);
+		texture.type = typeName;
+		texture.path = str.C_Str();
+		textures.push_back(texture);
+		this->vecTexturesLoaded.push_back(texture);
 	}
 	return textures;
 }
 
-unsigned int SMTextureFromFile(const char *path, const std::string &directory, bool gamma)
+unsigned int SMTextureFromFile(const char *path, const std::string &directory, const void* owner, bool gamma)
 {
 	std::string pathString(path);
 	std::size_t count = pathString.find_last_of("/\\");
@@ -618,35 +714,5 @@ unsigned int SMTextureFromFile(const char *path, const std::string &directory, b
 	//std::string filename = std::string(path);
 	filename = directory + '/' + filename;
 
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
-
-	int width, height, nrComponents;
-	unsigned char * data = SOIL_load_image(filename.c_str(), &width, &height, &nrComponents, SOIL_LOAD_AUTO);
-	if (data)
-	{
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		GLenum format;
-		if (nrComponents == 1)
-			format = GL_RED;
-		else if (nrComponents == 3)
-			format = GL_RGB;
-		else if (nrComponents == 4)
-			format = GL_RGBA;
-
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		SOIL_free_image_data(data);
-	}
-	else
-	{
-		printf("Skinned Mesh Texture failed to load.\n");
-	}
-	return textureID;
+	return cTextureRegistry::getInstance().acquire(filename, 0, owner);
 }
\ No newline at end of file
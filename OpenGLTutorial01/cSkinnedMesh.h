@@ -13,6 +13,7 @@
 #include <glm\glm.hpp>
 
 #include "cMesh.h"
+#include "cSkeleton.h"
 class cShaderProgram;
 
 class cSkinnedMesh
@@ -41,10 +42,19 @@ public:
 	std::string Filename;
 	std::string Name;
 
+	//GPU vertex and index bytes over all the meshes, and how long the constructor took
+	size_t MeshBytes;
+	float LoadTimeMs;
+
 	const aiScene* Scene;
 	Assimp::Importer Importer;
 
-	std::map<std::string, const aiScene*> MapAnimationNameToScene;
+	//Clips come from cAnimationClipLibrary and are released with the mesh
+	std::map<std::string, sClipBinding> MapAnimationNameToClip;
+	//The animation that came with the mesh file, played when a name isn't found. clip is NULL if there wasn't one.
+	//The mesh owns this one, since its scene has to stay loaded anyway
+	sClipBinding DefaultClip;
+	cSkeleton Skeleton;
 	std::vector<sVertexBoneData> VecVertexBoneData;
 	std::map<std::string, unsigned int> MapBoneNameToBoneIndex;
 	std::vector<sBoneInfo> VecBoneInfo;
@@ -62,7 +72,16 @@ public:
 	float GetDuration();
 	float GetAnimationDuration(const aiScene* scene);
 
+	//Writes into a pose the caller sized with Skeleton.allocatePose. Doesn't touch the mesh, so any number
+	//of threads can evaluate poses for it at once
+	void EvaluatePose(float time, const sClipBinding& clip, sSkeletonPose& pose) const;
+	//Looks the clip up once, then evaluates it with no further string work
 	void BoneTransform(float time, std::string animationName, std::vector<glm::mat4>& finalTransformation, std::vector<glm::mat4>& globals, std::vector<glm::mat4>& offsets);
+	void BoneTransform(float time, const sClipBinding& clip, std::vector<glm::mat4>& finalTransformation, std::vector<glm::mat4>& globals, std::vector<glm::mat4>& offsets);
+	//The original path that walks the aiNode tree and searches channels by name at every node.
+	//Only kept as the reference cAnimationBenchmark compares against, which keeps the aiAnimation alive itself
+	void BoneTransformFromScene(float time, const aiAnimation* animation, std::vector<glm::mat4>& finalTransformation, std::vector<glm::mat4>& globals, std::vector<glm::mat4>& offsets);
+	const sClipBinding& FindClip(const std::string& animationName) const;
 
 	bool Initialize();
 	bool Initialize(int index);
@@ -81,22 +100,28 @@ public:
 
 	const aiNodeAnim* FindNodeAnimationChannel(const aiAnimation* pAnimation, aiString nodeOrBoneName);
 
-	void ReadNodeHierarchy(float animationTime, std::string animationName, const aiNode* node, const glm::mat4 &parentTransformMatrix);
+	void ReadNodeHierarchy(float animationTime, const aiAnimation* animation, const aiNode* node, const glm::mat4 &parentTransformMatrix);
 	void LoadBones(const aiMesh* mesh, std::vector<sVertexBoneData>& bones);
 
 	//cMesh processMesh(unsigned int meshIndex = 0);
 	//void Close();
 
 
-	void Draw(cShaderProgram shader);
+	void Draw(cShaderProgram& shader, unsigned int numInstances = 1);
+	//Draw calls per Draw
+	unsigned int GetNumMeshes() const;
+	cMesh& GetSubMesh(unsigned int index);
 private:
 	std::vector<cMesh> vecMeshes;
+	//Every texture this mesh holds a registry reference to
 	std::vector<sTexture> vecTexturesLoaded;
 	std::string directory;
 	void loadModel(std::string path);
 	void processNode(aiNode* node, const aiScene* scene);
 	cMesh processMesh(aiMesh* mesh, const aiScene* scene);
 	std::vector<sTexture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
+	//Scratch pose for the BoneTransform overloads that fill vectors
+	sSkeletonPose pose;
 };
 
 #endif // !_SKINNED_MESH_HG_
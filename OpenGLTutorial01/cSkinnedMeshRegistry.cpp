@@ -0,0 +1,72 @@
+#include "cSkinnedMeshRegistry.h"
+
+#include <iostream>
+
+#include "cTextureRegistry.h"
+
+cSkinnedMeshRegistry& cSkinnedMeshRegistry::getInstance()
+{
+	static cSkinnedMeshRegistry registry;
+	return registry;
+}
+
+cSkinnedMeshRegistry::cSkinnedMeshRegistry()
+{
+	numMeshes = 0;
+	numReferences = 0;
+	residentBytes = 0;
+	savedLoadMs = 0.0f;
+	savedBytes = 0;
+}
+
+cSkinnedMesh* cSkinnedMeshRegistry::acquire(const std::string& path)
+{
+	std::string pathKey = cTextureRegistry::normalizePath(path);
+	numReferences++;
+
+	std::unordered_map<std::string, cSkinnedMesh*>::iterator it = mapPathToMesh.find(pathKey);
+	if (it != mapPathToMesh.end())
+	{
+		mapMeshToEntry[it->second].refCount++;
+		savedLoadMs += it->second->LoadTimeMs;
+		savedBytes += it->second->MeshBytes;
+		return it->second;
+	}
+
+	sEntry entry;
+	entry.mesh = new cSkinnedMesh(path);
+	entry.refCount = 1;
+	entry.pathKey = pathKey;
+	mapPathToMesh[pathKey] = entry.mesh;
+	mapMeshToEntry[entry.mesh] = entry;
+
+	numMeshes++;
+	residentBytes += entry.mesh->MeshBytes;
+	return entry.mesh;
+}
+
+void cSkinnedMeshRegistry::release(cSkinnedMesh* mesh)
+{
+	std::unordered_map<cSkinnedMesh*, sEntry>::iterator it = mapMeshToEntry.find(mesh);
+	if (it == mapMeshToEntry.end())
+		return;
+
+	numReferences--;
+	sEntry& entry = it->second;
+	entry.refCount--;
+	if (entry.refCount > 0)
+		return;
+
+	numMeshes--;
+	residentBytes -= mesh->MeshBytes;
+	mapPathToMesh.erase(entry.pathKey);
+	mapMeshToEntry.erase(it);
+	delete mesh;
+}
+
+void cSkinnedMeshRegistry::printReport()
+{
+	std::cout << "Skinned mesh registry: " << numMeshes << " meshes for " << numReferences << " users, "
+		<< residentBytes / 1024 << " KB of vertices and indices resident, " << savedBytes / 1024 << " KB and "
+		<< savedLoadMs << " ms of duplicate loads avoided" << std::endl;
+}
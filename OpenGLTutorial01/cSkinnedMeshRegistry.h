@@ -0,0 +1,46 @@
+#ifndef _HG_cSkinnedMeshRegistry_
+#define _HG_cSkinnedMeshRegistry_
+
+#include <string>
+#include <unordered_map>
+
+#include "cSkinnedMesh.h"
+
+//One cSkinnedMesh per model file, shared by every game object that uses it. The mesh, skeleton,
+//clips and textures are only imported and uploaded the first time; per character state lives in cAnimationInstance
+class cSkinnedMeshRegistry
+{
+public:
+	static cSkinnedMeshRegistry& getInstance();
+
+	//Loads the model if no one has it yet. Every acquire must be matched by a release. Needs the GL context thread
+	cSkinnedMesh* acquire(const std::string& path);
+	void release(cSkinnedMesh* mesh);
+
+	void printReport();
+
+	unsigned int numMeshes;
+	unsigned int numReferences;
+	size_t residentBytes;
+	//Load time and GPU memory the shared references would have cost as separate copies
+	float savedLoadMs;
+	size_t savedBytes;
+
+private:
+	struct sEntry
+	{
+		cSkinnedMesh* mesh;
+		unsigned int refCount;
+		std::string pathKey;
+	};
+
+	std::unordered_map<std::string, cSkinnedMesh*> mapPathToMesh;
+	std::unordered_map<cSkinnedMesh*, sEntry> mapMeshToEntry;
+
+	cSkinnedMeshRegistry();
+
+	cSkinnedMeshRegistry(const cSkinnedMeshRegistry&);
+	cSkinnedMeshRegistry& operator=(const cSkinnedMeshRegistry&);
+};
+
+#endif
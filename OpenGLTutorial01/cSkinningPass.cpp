@@ -0,0 +1,84 @@
+#include "cSkinningPass.h"
+
+#include <algorithm>
+
+#include "cSkinnedGameObject.h"
+#include "cPreSkinnedMesh.h"
+
+cSkinningPass::cSkinningPass()
+{
+	this->program.compileComputeProgram("assets/shaders/", "preSkinComp.glsl");
+	this->modelUniform = this->program.getUniform<glm::mat4>("model");
+	this->paletteStartUniform = this->program.getUniform<int>("paletteStart");
+	this->numBonesUsedUniform = this->program.getUniform<int>("numBonesUsed");
+	this->numVerticesUniform = this->program.getUniform<int>("numVertices");
+	glGenBuffers(1, &this->paletteBuffer);
+	this->paletteCapacity = 0;
+	this->lastObjects = 0;
+	this->lastVertices = 0;
+	this->lastDispatches = 0;
+}
+
+cSkinningPass::~cSkinningPass()
+{
+	glDeleteBuffers(1, &this->paletteBuffer);
+	glDeleteProgram(this->program.ID);
+}
+
+void cSkinningPass::skin(const std::vector<cSkinnedGameObject*>& objects)
+{
+	this->lastObjects = 0;
+	this->lastVertices = 0;
+	this->lastDispatches = 0;
+
+	//Every palette back to back, so there's one upload however many objects there are
+	std::vector<unsigned int> paletteStarts(objects.size());
+	this->palettes.clear();
+	for (unsigned int index = 0; index < objects.size(); index++)
+	{
+		const std::vector<glm::mat4>& palette = objects[index]->GetBonePalette();
+		paletteStarts[index] = (unsigned int)this->palettes.size();
+		this->palettes.insert(this->palettes.end(), palette.begin(), palette.end());
+	}
+	if (this->palettes.empty())
+		return;
+
+	size_t bytes = this->palettes.size() * sizeof(glm::mat4);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->paletteBuffer);
+	if (bytes > this->paletteCapacity)
+		this->paletteCapacity = std::max(bytes, this->paletteCapacity + this->paletteCapacity / 2);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, this->paletteCapacity, NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes, this->palettes.data());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, this->paletteBuffer);
+
+	this->program.useProgram();
+	for (unsigned int index = 0; index < objects.size(); index++)
+	{
+		cSkinnedGameObject* object = objects[index];
+		cSkinnedMesh* mesh = object->GetMesh();
+		if (!object->PreSkinnedVertices || object->PreSkinnedVertices->GetMesh() != mesh)
+		{
+			delete object->PreSkinnedVertices;
+			object->PreSkinnedVertices = new cPreSkinnedMesh(mesh);
+		}
+
+		this->modelUniform.set(object->GetModelMatrix());
+		this->paletteStartUniform.set((int)paletteStarts[index]);
+		this->numBonesUsedUniform.set((int)object->GetBonePalette().size());
+		for (unsigned int subMesh = 0; subMesh < mesh->GetNumMeshes(); subMesh++)
+		{
+			const cMesh& source = mesh->GetSubMesh(subMesh);
+			unsigned int numVertices = source.GetNumVertices();
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, source.GetVertexBuffer());
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, object->PreSkinnedVertices->GetVertexBuffer(subMesh));
+			this->numVerticesUniform.set((int)numVertices);
+			glDispatchCompute((numVertices + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+			this->lastVertices += numVertices;
+			this->lastDispatches++;
+		}
+		this->lastObjects++;
+	}
+
+	//The views read the results as vertex attributes
+	glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
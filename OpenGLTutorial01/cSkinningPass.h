@@ -0,0 +1,47 @@
+#ifndef _HG_cSkinningPass_
+#define _HG_cSkinningPass_
+
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "cShaderProgram.h"
+
+class cSkinnedGameObject;
+
+//Skins every character once a frame on the GPU (preSkinComp.glsl) into its own cPreSkinnedMesh, in world space.
+//Every camera pass after that draws the results like static meshes, so the bone blending and the normal
+//matrix inverse animVert.glsl does per vertex are paid once a frame however many views there are.
+//Run it after the updates and before the first view; it needs the context thread
+class cSkinningPass
+{
+public:
+	cSkinningPass();
+	~cSkinningPass();
+
+	//One palette upload for all of them, then a dispatch per sub-mesh
+	void skin(const std::vector<cSkinnedGameObject*>& objects);
+
+	unsigned int lastObjects;
+	unsigned int lastVertices;
+	unsigned int lastDispatches;
+
+private:
+	static const unsigned int GROUP_SIZE = 64;
+
+	cShaderProgram program;
+	//Looked up once, since the program never changes
+	sUniform<glm::mat4> modelUniform;
+	sUniform<int> paletteStartUniform;
+	sUniform<int> numBonesUsedUniform;
+	sUniform<int> numVerticesUniform;
+	GLuint paletteBuffer;
+	size_t paletteCapacity;
+	std::vector<glm::mat4> palettes;
+
+	cSkinningPass(const cSkinningPass&);
+	cSkinningPass& operator=(const cSkinningPass&);
+};
+
+#endif
@@ -1,14 +1,87 @@
 #include "cSkybox.h"
 
 cSkybox::cSkybox(std::string direct)
+{
+	loadImages(direct);
+	uploadGL();
+}
+
+cSkybox::cSkybox()
+{
+	textureID = 0;
+	VAO = 0;
+	VBO = 0;
+}
+
+cSkybox::cSkybox(std::string direct, cTextureStreamer& streamer)
+{
+	directory = direct;
+	setFaceNames();
+
+	//Comes back holding a placeholder; the real faces arrive over the next few frames
+	textureID = streamer.requestCubeMap(directory, boxNames, GL_RGB);
+	setupCube();
+}
+
+bool cSkybox::loadImages(std::string direct)
 {
 	directory = direct;
+	setFaceNames();
+
+	bool allLoaded = true;
+	for (unsigned int i = 0; i < boxNames.size(); i++)
+	{
+		std::string fullPath = directory + boxNames[i];
+		if (!faceImages[i].load(fullPath))
+		{
+			std::cout << "Cubemap texture failed to load at path: " << boxNames[i] << std::endl;
+			allLoaded = false;
+		}
+	}
+	return allLoaded;
+}
+
+void cSkybox::setFaceNames()
+{
+	boxNames.clear();
+	boxNames.push_back("right.jpg");
+	boxNames.push_back("left.jpg");
+	boxNames.push_back("top.jpg");
+	boxNames.push_back("bottom.jpg");
+	boxNames.push_back("front.jpg");
+	boxNames.push_back("back.jpg");
+}
+
+void cSkybox::uploadGL()
+{
 	skyboxInit();
 }
 
 void cSkybox::skyboxInit()
 {
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+
+	//Faces were decoded by loadImages(), all that's left is the upload
+	for (unsigned int i = 0; i < boxNames.size(); i++)
+	{
+		if (faceImages[i].isLoaded())
+		{
+			faceImages[i].uploadCubeFace(i, GL_RGB);
+		}
+		faceImages[i].free();
+	}
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+	setupCube();
+}
 
+void cSkybox::setupCube()
+{
 	skyboxVertices = new float[108]{
 		// positions          
 		-1.0f,  1.0f, -1.0f,
@@ -54,48 +127,6 @@ void cSkybox::skyboxInit()
 		1.0f, -1.0f,  1.0f
 	};
 
-	boxNames.push_back("right.jpg");
-	boxNames.push_back("left.jpg");
-	boxNames.push_back("top.jpg");
-	boxNames.push_back("bottom.jpg");
-	boxNames.push_back("front.jpg");
-	boxNames.push_back("back.jpg");
-
-	glGenTextures(1, &textureID);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-	int width, height, nrChannels;
-	for (unsigned int i = 0; i < boxNames.size(); i++)
-	{
-		std::string fullPath = directory + boxNames[i];
-		unsigned char *data = SOIL_load_image(fullPath.c_str(), &width, &height, &nrChannels, 0);
-		if (data)
-		{
-			GLenum format;
-			if (nrChannels == 1)
-				format = GL_RED;
-			else if (nrChannels == 3)
-				format = GL_RGB;
-			else if (nrChannels == 4)
-				format = GL_RGBA;
-
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-				0, GL_RGB, width, height, 0, format, GL_UNSIGNED_BYTE, data
-			);
-			SOIL_free_image_data(data);
-		}
-		else
-		{
-			std::cout << "Cubemap texture failed to load at path: " << boxNames[i] << std::endl;
-			SOIL_free_image_data(data);
-		}
-	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
 	glGenVertexArrays(1, &VAO);
 	glBindVertexArray(VAO);
 
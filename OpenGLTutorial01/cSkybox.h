@@ -12,6 +12,9 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <SOIL2/SOIL2.h>
 
+#include "cImage.h"
+#include "cTextureStreamer.h"
+
 class cSkybox
 {
 public:
@@ -22,11 +25,23 @@ public:
 	unsigned int VBO;
 
 	cSkybox(std::string);
+	//Streams the faces in the background instead of loading them here
+	cSkybox(std::string, cTextureStreamer& streamer);
+	//Empty skybox, to be filled in by loadImages() and uploadGL() (see cAssetLoader)
+	cSkybox();
+
+	//Decodes the six faces. Touches no GL state
+	bool loadImages(std::string direct);
+	//Builds the cube map and the cube VAO. Must run on the thread that owns the context
+	void uploadGL();
 
 private:
 	float* skyboxVertices;
+	cImage faceImages[6];
 
+	void setFaceNames();
 	void skyboxInit();
+	void setupCube();
 };
 
 #endif
\ No newline at end of file
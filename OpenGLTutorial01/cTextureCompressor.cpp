@@ -0,0 +1,234 @@
+#include "cTextureCompressor.h"
+
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <sys/stat.h>
+
+#include <SOIL2/SOIL2.h>
+extern "C"
+{
+#include <SOIL2/image_DXT.h>
+}
+
+namespace
+{
+	const unsigned char KTX_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+	const unsigned int KTX_ENDIANNESS = 0x04030201;
+
+	struct sKTXHeader
+	{
+		unsigned char identifier[12];
+		unsigned int endianness;
+		unsigned int glType;
+		unsigned int glTypeSize;
+		unsigned int glFormat;
+		unsigned int glInternalFormat;
+		unsigned int glBaseInternalFormat;
+		unsigned int pixelWidth;
+		unsigned int pixelHeight;
+		unsigned int pixelDepth;
+		unsigned int numberOfArrayElements;
+		unsigned int numberOfFaces;
+		unsigned int numberOfMipmapLevels;
+		unsigned int bytesOfKeyValueData;
+	};
+}
+
+std::string cTextureCompressor::getCachePath(const std::string& sourcePath)
+{
+	return sourcePath + ".ktx";
+}
+
+bool cTextureCompressor::isFresh(const std::string& sourcePath, const std::string& cachePath)
+{
+	struct stat cacheStat;
+	if (stat(cachePath.c_str(), &cacheStat) != 0)
+		return false;
+
+	struct stat sourceStat;
+	if (stat(sourcePath.c_str(), &sourceStat) != 0)
+		return true;
+
+	return cacheStat.st_mtime >= sourceStat.st_mtime;
+}
+
+bool cTextureCompressor::compress(const unsigned char* pixels, int width, int height, int components, sCompressedTexture& out)
+{
+	if (!pixels || width < 1 || height < 1 || components < 1 || components > 4)
+		return false;
+
+	//Only 2 and 4 channel images have alpha worth keeping
+	bool hasAlpha = (components & 1) == 0;
+	out.format = hasAlpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	out.mips.clear();
+	out.data.clear();
+
+	std::vector<unsigned char> level(pixels, pixels + (size_t)width * height * components);
+	int levelWidth = width;
+	int levelHeight = height;
+	while (true)
+	{
+		int encodedSize = 0;
+		unsigned char* encoded = hasAlpha ?
+			convert_image_to_DXT5(&level[0], levelWidth, levelHeight, components, &encodedSize) :
+			convert_image_to_DXT1(&level[0], levelWidth, levelHeight, components, &encodedSize);
+		if (!encoded)
+			return false;
+
+		sCompressedMip mip;
+		mip.width = levelWidth;
+		mip.height = levelHeight;
+		mip.offset = out.data.size();
+		mip.size = encodedSize;
+		out.mips.push_back(mip);
+		out.data.insert(out.data.end(), encoded, encoded + encodedSize);
+		free(encoded);
+
+		if (levelWidth == 1 && levelHeight == 1)
+			break;
+
+		std::vector<unsigned char> nextLevel;
+		downsample(level, levelWidth, levelHeight, components, nextLevel, levelWidth, levelHeight);
+		level.swap(nextLevel);
+	}
+	return true;
+}
+
+void cTextureCompressor::downsample(const std::vector<unsigned char>& source, int width, int height, int components,
+	std::vector<unsigned char>& out, int& outWidth, int& outHeight)
+{
+	outWidth = width > 1 ? width / 2 : 1;
+	outHeight = height > 1 ? height / 2 : 1;
+	out.resize((size_t)outWidth * outHeight * components);
+
+	//2x2 box filter, clamping at the edge so odd sizes and 1 pixel wide levels still work
+	for (int y = 0; y < outHeight; y++)
+	{
+		int y0 = y * 2 < height ? y * 2 : height - 1;
+		int y1 = y * 2 + 1 < height ? y * 2 + 1 : height - 1;
+		for (int x = 0; x < outWidth; x++)
+		{
+			int x0 = x * 2 < width ? x * 2 : width - 1;
+			int x1 = x * 2 + 1 < width ? x * 2 + 1 : width - 1;
+			for (int c = 0; c < components; c++)
+			{
+				int sum = source[((size_t)y0 * width + x0) * components + c]
+					+ source[((size_t)y0 * width + x1) * components + c]
+					+ source[((size_t)y1 * width + x0) * components + c]
+					+ source[((size_t)y1 * width + x1) * components + c];
+				out[((size_t)y * outWidth + x) * components + c] = (unsigned char)((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+bool cTextureCompressor::writeKTX(const std::string& path, const sCompressedTexture& texture)
+{
+	if (texture.mips.empty())
+		return false;
+
+	std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	sKTXHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.identifier, KTX_IDENTIFIER, sizeof(header.identifier));
+	header.endianness = KTX_ENDIANNESS;
+	header.glTypeSize = 1;
+	header.glInternalFormat = texture.format;
+	header.glBaseInternalFormat = texture.format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT ? GL_RGBA : GL_RGB;
+	header.pixelWidth = texture.mips[0].width;
+	header.pixelHeight = texture.mips[0].height;
+	header.numberOfFaces = 1;
+	header.numberOfMipmapLevels = (unsigned int)texture.mips.size();
+	file.write((const char*)&header, sizeof(header));
+
+	//BC blocks are 8 or 16 bytes, so every level is already 4 byte aligned and needs no padding
+	for (int index = 0; index < texture.mips.size(); index++)
+	{
+		const sCompressedMip& mip = texture.mips[index];
+		unsigned int imageSize = (unsigned int)mip.size;
+		file.write((const char*)&imageSize, sizeof(imageSize));
+		file.write((const char*)&texture.data[mip.offset], mip.size);
+	}
+	return file.good();
+}
+
+bool cTextureCompressor::readKTX(const std::string& path, sCompressedTexture& texture)
+{
+	std::ifstream file(path.c_str(), std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	sKTXHeader header;
+	if (!file.read((char*)&header, sizeof(header)))
+		return false;
+	if (memcmp(header.identifier, KTX_IDENTIFIER, sizeof(header.identifier)) != 0 ||
+		header.endianness != KTX_ENDIANNESS ||
+		header.numberOfFaces != 1 ||
+		header.numberOfMipmapLevels == 0 ||
+		(header.glInternalFormat != GL_COMPRESSED_RGB_S3TC_DXT1_EXT && header.glInternalFormat != GL_COMPRESSED_RGBA_S3TC_DXT5_EXT))
+	{
+		return false;
+	}
+	file.seekg(header.bytesOfKeyValueData, std::ios::cur);
+
+	texture.format = header.glInternalFormat;
+	texture.mips.clear();
+	texture.data.clear();
+
+	int levelWidth = header.pixelWidth;
+	int levelHeight = header.pixelHeight;
+	for (unsigned int level = 0; level < header.numberOfMipmapLevels; level++)
+	{
+		unsigned int imageSize;
+		if (!file.read((char*)&imageSize, sizeof(imageSize)))
+			return false;
+
+		sCompressedMip mip;
+		mip.width = levelWidth;
+		mip.height = levelHeight;
+		mip.offset = texture.data.size();
+		mip.size = imageSize;
+		texture.data.resize(mip.offset + imageSize);
+		if (!file.read((char*)&texture.data[mip.offset], imageSize))
+			return false;
+		texture.mips.push_back(mip);
+
+		levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+		levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+	}
+	return true;
+}
+
+int cTextureCompressor::compressFiles(const std::vector<std::string>& filenames)
+{
+	int numFailed = 0;
+	for (int index = 0; index < filenames.size(); index++)
+	{
+		const std::string& filename = filenames[index];
+
+		int width, height, components;
+		unsigned char* pixels = SOIL_load_image(filename.c_str(), &width, &height, &components, SOIL_LOAD_AUTO);
+
+		sCompressedTexture texture;
+		bool compressed = compress(pixels, width, height, components, texture);
+		if (pixels)
+			SOIL_free_image_data(pixels);
+
+		if (!compressed || !writeKTX(getCachePath(filename), texture))
+		{
+			std::cout << "Could not compress " << filename << std::endl;
+			numFailed++;
+			continue;
+		}
+
+		size_t rawBytes = (size_t)width * height * components;
+		std::cout << filename << ": " << rawBytes / 1024 << " KB -> " << texture.mips[0].size / 1024
+			<< " KB (" << texture.mips.size() << " mips, " << texture.data.size() / 1024 << " KB total)" << std::endl;
+	}
+	return numFailed;
+}
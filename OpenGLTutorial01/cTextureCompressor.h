@@ -0,0 +1,55 @@
+#ifndef _HG_cTextureCompressor_
+#define _HG_cTextureCompressor_
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+//Not part of core GL, so glad doesn't give us these
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+struct sCompressedMip
+{
+	int width;
+	int height;
+	size_t offset;
+	size_t size;
+};
+
+//A block compressed image with its full mip chain, every level back to back in data
+struct sCompressedTexture
+{
+	GLenum format;
+	std::vector<sCompressedMip> mips;
+	std::vector<unsigned char> data;
+};
+
+//Turns decoded pixels into BC1 (opaque) or BC3 (with alpha) with a box filtered mip chain,
+//and reads/writes the result as a KTX 1.1 file next to the source image.
+//Pure CPU code: no GL calls, safe to run on any thread or without a context at all
+class cTextureCompressor
+{
+public:
+	static std::string getCachePath(const std::string& sourcePath);
+	//True if the .ktx exists and is at least as new as the source image
+	static bool isFresh(const std::string& sourcePath, const std::string& cachePath);
+
+	static bool compress(const unsigned char* pixels, int width, int height, int components, sCompressedTexture& out);
+	static bool writeKTX(const std::string& path, const sCompressedTexture& texture);
+	static bool readKTX(const std::string& path, sCompressedTexture& texture);
+
+	//Offline mode: compresses each image file and writes its .ktx. Returns how many failed
+	static int compressFiles(const std::vector<std::string>& filenames);
+
+private:
+	static void downsample(const std::vector<unsigned char>& source, int width, int height, int components,
+		std::vector<unsigned char>& out, int& outWidth, int& outHeight);
+};
+
+#endif
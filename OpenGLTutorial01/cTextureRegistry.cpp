@@ -0,0 +1,260 @@
+#include "cTextureRegistry.h"
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <cctype>
+#include <algorithm>
+
+namespace
+{
+	std::string makeContentKey(unsigned long long contentHash, int width, int height)
+	{
+		std::ostringstream hashString;
+		hashString << std::hex << contentHash << ':' << std::dec << width << 'x' << height;
+		return hashString.str();
+	}
+}
+
+cTextureRegistry& cTextureRegistry::getInstance()
+{
+	static cTextureRegistry registry;
+	return registry;
+}
+
+cTextureRegistry::cTextureRegistry()
+{
+	numTextures = 0;
+	residentBytes = 0;
+	savedBytes = 0;
+	duplicateBytes = 0;
+	streamer = NULL;
+}
+
+void cTextureRegistry::setStreamer(cTextureStreamer* textureStreamer)
+{
+	std::unique_lock<std::mutex> lock(registryMutex);
+	streamer = textureStreamer;
+}
+
+std::string cTextureRegistry::normalizePath(const std::string& path)
+{
+	//Split on either slash, dropping "." and resolving ".." where we can
+	std::vector<std::string> parts;
+	std::string part;
+	for (size_t index = 0; index <= path.size(); index++)
+	{
+		char c = index < path.size() ? path[index] : '/';
+		if (c != '/' && c != '\\')
+		{
+#ifdef _WIN32
+			part += (char)std::tolower((unsigned char)c);
+#else
+			part += c;
+#endif
+			continue;
+		}
+
+		if (part == "..")
+		{
+			if (!parts.empty() && parts.back() != "..")
+				parts.pop_back();
+			else
+				parts.push_back(part);
+		}
+		else if (!part.empty() && part != ".")
+		{
+			parts.push_back(part);
+		}
+		part.clear();
+	}
+
+	std::string normalized;
+	for (int index = 0; index < parts.size(); index++)
+	{
+		if (index > 0)
+			normalized += '/';
+		normalized += parts[index];
+	}
+	return normalized;
+}
+
+unsigned int cTextureRegistry::addReference(unsigned int textureID, const void* owner)
+{
+	sEntry& entry = mapTextureToEntry[textureID];
+	entry.refCount++;
+	//Only a new owner would have uploaded its own copy without us
+	if (std::find(entry.owners.begin(), entry.owners.end(), owner) == entry.owners.end())
+	{
+		entry.owners.push_back(owner);
+		savedBytes += entry.bytes;
+	}
+	return textureID;
+}
+
+unsigned int cTextureRegistry::addEntry(sEntry& entry, const void* owner)
+{
+	entry.refCount = 1;
+	entry.owners.push_back(owner);
+	mapPathToTexture[entry.pathKey] = entry.textureID;
+	if (!entry.contentKey.empty())
+		mapContentToTexture[entry.contentKey] = entry.textureID;
+	mapTextureToEntry[entry.textureID] = entry;
+
+	numTextures++;
+	residentBytes += entry.bytes;
+	return entry.textureID;
+}
+
+bool cTextureRegistry::isResident(const std::string& path)
+{
+	std::unique_lock<std::mutex> lock(registryMutex);
+	return mapPathToTexture.find(normalizePath(path)) != mapPathToTexture.end();
+}
+
+unsigned int cTextureRegistry::acquire(const std::string& path, GLenum internalFormat, const void* owner)
+{
+	std::string pathKey = normalizePath(path);
+	{
+		std::unique_lock<std::mutex> lock(registryMutex);
+		std::unordered_map<std::string, unsigned int>::iterator it = mapPathToTexture.find(pathKey);
+		if (it != mapPathToTexture.end())
+		{
+			return addReference(it->second, owner);
+		}
+
+		if (streamer)
+		{
+			//The contents aren't known until the streamer has decoded them. It fills them in with textureStreamed
+			sEntry entry;
+			entry.textureID = streamer->requestTexture2D(path, internalFormat);
+			entry.bytes = 0;
+			entry.pathKey = pathKey;
+			return addEntry(entry, owner);
+		}
+	}
+
+	cImage image;
+	if (!image.load(path))
+	{
+		std::cout << "Texture failed to load at path: " << path << std::endl;
+
+		std::unique_lock<std::mutex> lock(registryMutex);
+		std::unordered_map<std::string, unsigned int>::iterator it = mapPathToTexture.find(pathKey);
+		if (it != mapPathToTexture.end())
+		{
+			return addReference(it->second, owner);
+		}
+
+		//Still tracked, so release deletes it and the next acquire of the same path doesn't try the file again
+		sEntry entry;
+		glGenTextures(1, &entry.textureID);
+		entry.bytes = 0;
+		entry.pathKey = pathKey;
+		return addEntry(entry, owner);
+	}
+	return acquire(path, image, internalFormat, owner);
+}
+
+unsigned int cTextureRegistry::acquire(const std::string& path, cImage& image, GLenum internalFormat, const void* owner)
+{
+	std::unique_lock<std::mutex> lock(registryMutex);
+
+	std::string pathKey = normalizePath(path);
+	std::unordered_map<std::string, unsigned int>::iterator it = mapPathToTexture.find(pathKey);
+	if (it != mapPathToTexture.end())
+	{
+		return addReference(it->second, owner);
+	}
+
+	//New path, but it might still be a copy of something we already have
+	std::string contentKey = makeContentKey(image.contentHash, image.width, image.height);
+	it = mapContentToTexture.find(contentKey);
+	if (it != mapContentToTexture.end())
+	{
+		mapPathToTexture[pathKey] = it->second;
+		return addReference(it->second, owner);
+	}
+
+	//0 means keep whatever channels the file has
+	GLenum uploadFormat = internalFormat != 0 ? internalFormat : image.getFormat();
+
+	sEntry entry;
+	entry.textureID = image.uploadTexture2D(uploadFormat);
+	entry.bytes = image.getGPUSizeBytes(uploadFormat);
+	entry.pathKey = pathKey;
+	entry.contentKey = contentKey;
+	return addEntry(entry, owner);
+}
+
+void cTextureRegistry::textureStreamed(unsigned int textureID, unsigned long long contentHash, int width, int height, size_t bytes)
+{
+	std::unique_lock<std::mutex> lock(registryMutex);
+
+	//Released before it finished, or not one of ours (a skybox, say)
+	std::unordered_map<unsigned int, sEntry>::iterator it = mapTextureToEntry.find(textureID);
+	if (it == mapTextureToEntry.end())
+		return;
+
+	sEntry& entry = it->second;
+	entry.bytes = bytes;
+	residentBytes += bytes;
+	//Every owner past the first was sharing it before its size was known
+	savedBytes += bytes * (entry.owners.size() - 1);
+
+	std::string contentKey = makeContentKey(contentHash, width, height);
+	std::unordered_map<std::string, unsigned int>::iterator contentIt = mapContentToTexture.find(contentKey);
+	if (contentIt == mapContentToTexture.end())
+	{
+		entry.contentKey = contentKey;
+		mapContentToTexture[contentKey] = textureID;
+		return;
+	}
+
+	//Too late for the owners it already has, but anyone asking for one of its paths gets the first copy from now on
+	duplicateBytes += bytes;
+	for (std::unordered_map<std::string, unsigned int>::iterator pathIt = mapPathToTexture.begin(); pathIt != mapPathToTexture.end(); pathIt++)
+	{
+		if (pathIt->second == textureID)
+			pathIt->second = contentIt->second;
+	}
+}
+
+void cTextureRegistry::release(unsigned int textureID)
+{
+	std::unique_lock<std::mutex> lock(registryMutex);
+
+	std::unordered_map<unsigned int, sEntry>::iterator it = mapTextureToEntry.find(textureID);
+	if (it == mapTextureToEntry.end())
+		return;
+
+	sEntry& entry = it->second;
+	entry.refCount--;
+	if (entry.refCount > 0)
+		return;
+
+	//Last user is gone. Drop every path that pointed at it, not just the first one
+	for (std::unordered_map<std::string, unsigned int>::iterator pathIt = mapPathToTexture.begin(); pathIt != mapPathToTexture.end();)
+	{
+		if (pathIt->second == textureID)
+			pathIt = mapPathToTexture.erase(pathIt);
+		else
+			pathIt++;
+	}
+	if (!entry.contentKey.empty())
+		mapContentToTexture.erase(entry.contentKey);
+
+	numTextures--;
+	residentBytes -= entry.bytes;
+	glDeleteTextures(1, &textureID);
+	mapTextureToEntry.erase(it);
+}
+
+void cTextureRegistry::printReport()
+{
+	std::unique_lock<std::mutex> lock(registryMutex);
+	std::cout << "Texture registry: " << numTextures << " textures, "
+		<< residentBytes / 1024 << " KB resident, "
+		<< savedBytes / 1024 << " KB of duplicate uploads avoided, "
+		<< duplicateBytes / 1024 << " KB streamed before it was known to be a copy" << std::endl;
+}
@@ -0,0 +1,82 @@
+#ifndef _HG_cTextureRegistry_
+#define _HG_cTextureRegistry_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+#include <glad/glad.h>
+
+#include "cImage.h"
+#include "cTextureStreamer.h"
+
+//One GL texture per distinct image file, shared by every model in the process.
+//Textures are found by normalized path first, then by a hash of the file contents,
+//so the same image reached through two different paths is still only decoded and uploaded once.
+//The format isn't part of either key: the first acquire's format is the one every later caller shares
+class cTextureRegistry
+{
+public:
+	static cTextureRegistry& getInstance();
+
+	static std::string normalizePath(const std::string& path);
+
+	//Returns a texture for the file, decoding and uploading it only if no one has it yet.
+	//Every acquire must be matched by a release. Needs the GL context thread.
+	//An internalFormat of 0 keeps whatever channels the file has. owner is whoever holds the reference
+	//(a model, say); acquiring again for the same owner isn't counted in savedBytes.
+	//A file that fails to load still gets an (empty) texture, which has to be released like any other
+	unsigned int acquire(const std::string& path, GLenum internalFormat, const void* owner);
+	//Same, for an image that has already been decoded (on a worker thread, say)
+	unsigned int acquire(const std::string& path, cImage& image, GLenum internalFormat, const void* owner);
+	void release(unsigned int textureID);
+
+	//With a streamer attached, a path acquire that misses returns a placeholder
+	//straight away and leaves the decode and upload to the streamer
+	void setStreamer(cTextureStreamer* textureStreamer);
+
+	//Called by the streamer once a texture it was asked for is fully up. Fills in the size and contents the
+	//placeholder entry couldn't know, so later acquires of the same image under another path share it.
+	//If it turns out to be a copy of one already resident, its paths lead to that one from now on
+	void textureStreamed(unsigned int textureID, unsigned long long contentHash, int width, int height, size_t bytes);
+
+	//Safe from any thread. Lets loaders skip decoding images that are already on the GPU
+	bool isResident(const std::string& path);
+
+	void printReport();
+
+	unsigned int numTextures;
+	size_t residentBytes;
+	//GPU memory that would have been spent on duplicate copies, one per extra owner
+	size_t savedBytes;
+	//Streamed textures that turned out to be copies of one already resident, found too late to share
+	size_t duplicateBytes;
+
+private:
+	struct sEntry
+	{
+		unsigned int textureID;
+		unsigned int refCount;
+		size_t bytes;
+		std::string pathKey;
+		std::string contentKey;
+		//Everyone who has acquired it, so a second acquire by the same owner isn't counted as a saving
+		std::vector<const void*> owners;
+	};
+
+	std::unordered_map<std::string, unsigned int> mapPathToTexture;
+	std::unordered_map<std::string, unsigned int> mapContentToTexture;
+	std::unordered_map<unsigned int, sEntry> mapTextureToEntry;
+	std::mutex registryMutex;
+	cTextureStreamer* streamer;
+
+	cTextureRegistry();
+	unsigned int addReference(unsigned int textureID, const void* owner);
+	unsigned int addEntry(sEntry& entry, const void* owner);
+
+	cTextureRegistry(const cTextureRegistry&);
+	cTextureRegistry& operator=(const cTextureRegistry&);
+};
+
+#endif
@@ -0,0 +1,411 @@
+#include "cTextureStreamer.h"
+#include "cTextureRegistry.h"
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	const unsigned char PLACEHOLDER_PIXEL[4] = { 128, 128, 128, 255 };
+}
+
+cTextureStreamer::cTextureStreamer(unsigned int numDecodeThreads, unsigned int numPixelBuffers) : decodePool(numDecodeThreads)
+{
+	//4 MB a frame is a couple of milliseconds of memcpy and upload on anything recent
+	uploadBudgetBytes = 4 * 1024 * 1024;
+	bytesStagedLastFrame = 0;
+	numPending = 0;
+	nextPixelBuffer = 0;
+
+	for (unsigned int index = 0; index < numPixelBuffers; index++)
+	{
+		sPixelBuffer pixelBuffer;
+		glGenBuffers(1, &pixelBuffer.ID);
+		pixelBuffer.size = 0;
+		pixelBuffer.fence = 0;
+		pixelBuffers.push_back(pixelBuffer);
+	}
+}
+
+cTextureStreamer::~cTextureStreamer()
+{
+	decodePool.wait();
+
+	for (int index = 0; index < decodedJobs.size(); index++)
+		deleteJob(decodedJobs[index]);
+	for (int index = 0; index < stagingJobs.size(); index++)
+		deleteJob(stagingJobs[index]);
+
+	for (int index = 0; index < pixelBuffers.size(); index++)
+	{
+		if (pixelBuffers[index].fence)
+			glDeleteSync(pixelBuffers[index].fence);
+		glDeleteBuffers(1, &pixelBuffers[index].ID);
+	}
+}
+
+unsigned int cTextureStreamer::requestTexture2D(const std::string& filename, GLenum internalFormat)
+{
+	std::vector<std::string> filenames;
+	filenames.push_back(filename);
+	sStreamJob* job = queueJob(GL_TEXTURE_2D, filenames, internalFormat);
+	return job->textureID;
+}
+
+unsigned int cTextureStreamer::requestCubeMap(const std::string& directory, const std::vector<std::string>& faces, GLenum internalFormat)
+{
+	std::vector<std::string> filenames;
+	for (int index = 0; index < faces.size(); index++)
+	{
+		filenames.push_back(directory + faces[index]);
+	}
+	sStreamJob* job = queueJob(GL_TEXTURE_CUBE_MAP, filenames, internalFormat);
+	return job->textureID;
+}
+
+cTextureStreamer::sStreamJob* cTextureStreamer::queueJob(GLenum target, const std::vector<std::string>& filenames, GLenum internalFormat)
+{
+	sStreamJob* job = new sStreamJob();
+	job->target = target;
+	job->internalFormat = internalFormat;
+	job->filenames = filenames;
+	job->numLevels = 1;
+	job->allocated = false;
+	job->nextRegion = 0;
+	job->nextRow = 0;
+	job->failed = false;
+
+	//Placeholder goes in now, so the ID is safe to bind from the very first frame
+	glGenTextures(1, &job->textureID);
+	glBindTexture(target, job->textureID);
+	if (target == GL_TEXTURE_CUBE_MAP)
+	{
+		for (unsigned int face = 0; face < 6; face++)
+		{
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXEL);
+		}
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	}
+	else
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXEL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+	glBindTexture(target, 0);
+
+	numPending++;
+	decodePool.submit([this, job]()
+	{
+		for (int index = 0; index < job->filenames.size(); index++)
+		{
+			cImage* image = new cImage();
+			if (!image->load(job->filenames[index]))
+			{
+				job->failed = true;
+			}
+			job->images.push_back(image);
+		}
+		if (!job->failed)
+			buildRegions(job);
+
+		std::unique_lock<std::mutex> lock(decodedMutex);
+		decodedJobs.push_back(job);
+	});
+
+	return job;
+}
+
+void cTextureStreamer::buildRegions(sStreamJob* job)
+{
+	for (unsigned int index = 0; index < job->images.size(); index++)
+	{
+		cImage* image = job->images[index];
+		sUploadRegion region;
+		region.target = job->target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + index : GL_TEXTURE_2D;
+		if (image->isCompressed())
+		{
+			const sCompressedTexture& compressed = image->compressed;
+			for (int level = 0; level < compressed.mips.size(); level++)
+			{
+				const sCompressedMip& mip = compressed.mips[level];
+				region.level = level;
+				region.width = mip.width;
+				region.height = mip.height;
+				region.internalFormat = compressed.format;
+				region.format = compressed.format;
+				region.compressed = true;
+				region.source = compressed.data.data() + mip.offset;
+				region.numRows = (mip.height + 3) / 4;
+				region.rowBytes = mip.size / region.numRows;
+				region.size = mip.size;
+				job->regions.push_back(region);
+			}
+			job->numLevels = std::max(job->numLevels, (int)compressed.mips.size());
+			continue;
+		}
+
+		region.level = 0;
+		region.width = image->width;
+		region.height = image->height;
+		region.internalFormat = job->internalFormat != 0 ? job->internalFormat : image->getFormat();
+		region.format = image->getFormat();
+		region.compressed = false;
+		region.source = image->getData();
+		region.numRows = image->height;
+		region.rowBytes = (size_t)image->width * image->components;
+		region.size = region.rowBytes * region.numRows;
+		job->regions.push_back(region);
+
+		//glGenerateMipmap fills in the rest of a 2D texture's chain at the end. Cube maps don't use one
+		if (job->target == GL_TEXTURE_2D)
+		{
+			int numLevels = 1;
+			for (int size = std::max(image->width, image->height); size > 1; size /= 2)
+				numLevels++;
+			job->numLevels = std::max(job->numLevels, numLevels);
+		}
+	}
+}
+
+void cTextureStreamer::update()
+{
+	{
+		std::unique_lock<std::mutex> lock(decodedMutex);
+		while (!decodedJobs.empty())
+		{
+			sStreamJob* job = decodedJobs.front();
+			decodedJobs.pop_front();
+			if (job->failed)
+			{
+				std::cout << "Streamed texture failed to load: " << job->filenames[0] << std::endl;
+				deleteJob(job);
+				numPending--;
+				continue;
+			}
+			stagingJobs.push_back(job);
+		}
+	}
+
+	bytesStagedLastFrame = 0;
+
+	//Jobs whose last band went up on an earlier frame. Mips get a frame of their own rather than piling onto an upload
+	bool generatedMips = false;
+	while (!stagingJobs.empty() && stagingJobs.front()->nextRegion >= stagingJobs.front()->regions.size())
+	{
+		sStreamJob* job = stagingJobs.front();
+		generatedMips = finishJob(job) || generatedMips;
+		stagingJobs.pop_front();
+		deleteJob(job);
+		numPending--;
+	}
+	if (generatedMips || stagingJobs.empty())
+		return;
+
+	//A row bigger than the whole budget still goes, on its own
+	const sStreamJob* firstJob = stagingJobs.front();
+	size_t capacity = std::max(uploadBudgetBytes, firstJob->regions[firstJob->nextRegion].rowBytes);
+	sPixelBuffer* pixelBuffer = acquirePixelBuffer(capacity);
+	//Every PBO is still being read by the GPU; try again next frame
+	if (!pixelBuffer)
+		return;
+
+	//Plan this frame's bands first, so the PBO is only bound while they're copied and uploaded
+	std::vector<sChunk> chunks;
+	size_t numBytes = 0;
+	bool full = false;
+	for (unsigned int index = 0; index < stagingJobs.size() && !full; index++)
+	{
+		sStreamJob* job = stagingJobs[index];
+		while (job->nextRegion < job->regions.size())
+		{
+			const sUploadRegion& region = job->regions[job->nextRegion];
+			int numRows = (int)std::min((size_t)(region.numRows - job->nextRow), (capacity - numBytes) / region.rowBytes);
+			if (numRows == 0)
+			{
+				full = true;
+				break;
+			}
+			if (!job->allocated)
+				allocateStorage(job);
+
+			sChunk chunk;
+			chunk.job = job;
+			chunk.region = job->nextRegion;
+			chunk.firstRow = job->nextRow;
+			chunk.numRows = numRows;
+			chunk.offset = numBytes;
+			chunks.push_back(chunk);
+			numBytes += numRows * region.rowBytes;
+
+			job->nextRow += numRows;
+			if (job->nextRow == region.numRows)
+			{
+				job->nextRegion++;
+				job->nextRow = 0;
+			}
+		}
+	}
+
+	uploadChunks(*pixelBuffer, chunks, numBytes);
+	bytesStagedLastFrame = numBytes;
+}
+
+bool cTextureStreamer::isIdle()
+{
+	return numPending == 0;
+}
+
+cTextureStreamer::sPixelBuffer* cTextureStreamer::acquirePixelBuffer(size_t numBytes)
+{
+	for (unsigned int tries = 0; tries < pixelBuffers.size(); tries++)
+	{
+		unsigned int index = (nextPixelBuffer + tries) % pixelBuffers.size();
+		sPixelBuffer& pixelBuffer = pixelBuffers[index];
+		if (pixelBuffer.fence)
+		{
+			GLenum status = glClientWaitSync(pixelBuffer.fence, 0, 0);
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+				continue;
+			glDeleteSync(pixelBuffer.fence);
+			pixelBuffer.fence = 0;
+		}
+
+		//One frame's worth, never a whole texture
+		if (pixelBuffer.size < numBytes)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer.ID);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, numBytes, NULL, GL_STREAM_DRAW);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			pixelBuffer.size = numBytes;
+		}
+
+		nextPixelBuffer = (index + 1) % pixelBuffers.size();
+		return &pixelBuffer;
+	}
+	return NULL;
+}
+
+void cTextureStreamer::allocateStorage(sStreamJob* job)
+{
+	glBindTexture(job->target, job->textureID);
+
+	//The placeholder moves past the last real level and stays the only one sampled until finishJob,
+	//so the levels below it can be filled in over as many frames as it takes
+	unsigned int numFaces = job->target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+	for (unsigned int face = 0; face < numFaces; face++)
+	{
+		GLenum target = job->target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+		glTexImage2D(target, job->numLevels, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXEL);
+	}
+	glTexParameteri(job->target, GL_TEXTURE_BASE_LEVEL, job->numLevels);
+	glTexParameteri(job->target, GL_TEXTURE_MAX_LEVEL, job->numLevels);
+
+	//Storage only, the pixels follow in bands
+	for (unsigned int index = 0; index < job->regions.size(); index++)
+	{
+		const sUploadRegion& region = job->regions[index];
+		if (region.compressed)
+			glCompressedTexImage2D(region.target, region.level, region.internalFormat, region.width, region.height, 0, (GLsizei)region.size, NULL);
+		else
+			glTexImage2D(region.target, region.level, region.internalFormat, region.width, region.height, 0, region.format, GL_UNSIGNED_BYTE, NULL);
+	}
+
+	glBindTexture(job->target, 0);
+	job->allocated = true;
+}
+
+void cTextureStreamer::uploadChunks(sPixelBuffer& pixelBuffer, const std::vector<sChunk>& chunks, size_t numBytes)
+{
+	if (chunks.empty())
+		return;
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer.ID);
+	//The fence has already said the GPU is done with whatever was in here
+	unsigned char* destination = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, numBytes,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (destination)
+	{
+		for (unsigned int index = 0; index < chunks.size(); index++)
+		{
+			const sChunk& chunk = chunks[index];
+			const sUploadRegion& region = chunk.job->regions[chunk.region];
+			memcpy(destination + chunk.offset, region.source + chunk.firstRow * region.rowBytes, chunk.numRows * region.rowBytes);
+		}
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
+	else
+	{
+		//Couldn't map it, so these bands go straight from the images instead
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (unsigned int index = 0; index < chunks.size(); index++)
+	{
+		const sChunk& chunk = chunks[index];
+		const sUploadRegion& region = chunk.job->regions[chunk.region];
+		//With a PBO bound the data pointer is an offset into it, and the copy runs on the GPU's time
+		const void* data = destination ? (const void*)chunk.offset : (const void*)(region.source + chunk.firstRow * region.rowBytes);
+		GLsizei dataBytes = (GLsizei)(chunk.numRows * region.rowBytes);
+
+		glBindTexture(chunk.job->target, chunk.job->textureID);
+		if (region.compressed)
+		{
+			//Bands of whole 4x4 blocks, the last one cut off by the bottom edge
+			int y = chunk.firstRow * 4;
+			int height = std::min(chunk.numRows * 4, region.height - y);
+			glCompressedTexSubImage2D(region.target, region.level, 0, y, region.width, height, region.format, dataBytes, data);
+		}
+		else
+		{
+			glTexSubImage2D(region.target, region.level, 0, chunk.firstRow, region.width, chunk.numRows, region.format, GL_UNSIGNED_BYTE, data);
+		}
+		glBindTexture(chunk.job->target, 0);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	//The PBO can't be refilled until the GPU has finished reading it
+	if (destination)
+		pixelBuffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool cTextureStreamer::finishJob(sStreamJob* job)
+{
+	glBindTexture(job->target, job->textureID);
+	glTexParameteri(job->target, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(job->target, GL_TEXTURE_MAX_LEVEL, job->numLevels - 1);
+
+	//Compressed images bring their own mip chain
+	bool generateMips = job->target == GL_TEXTURE_2D && job->numLevels > 1 && !job->regions[0].compressed;
+	if (generateMips)
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+	glBindTexture(job->target, 0);
+
+	//Only now are the contents known, so the registry can share it with the same image under other paths
+	if (job->target == GL_TEXTURE_2D)
+	{
+		cImage* image = job->images[0];
+		cTextureRegistry::getInstance().textureStreamed(job->textureID, image->contentHash, image->width, image->height,
+			image->getGPUSizeBytes(job->regions[0].internalFormat));
+	}
+	return generateMips;
+}
+
+void cTextureStreamer::deleteJob(sStreamJob* job)
+{
+	for (int index = 0; index < job->images.size(); index++)
+	{
+		delete job->images[index];
+	}
+	delete job;
+}
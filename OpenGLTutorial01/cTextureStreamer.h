@@ -0,0 +1,115 @@
+#ifndef _HG_cTextureStreamer_
+#define _HG_cTextureStreamer_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+#include <glad/glad.h>
+
+#include "cThreadPool.h"
+#include "cImage.h"
+
+//Streams textures in without stalling a frame. A request hands back a real texture ID straight away,
+//holding a 1x1 placeholder. The files are decoded on background threads, then update() sends them to the GPU
+//a band of rows at a time: each frame copies at most uploadBudgetBytes into one pixel buffer object from a
+//small ring and uploads just that much from it. The placeholder stays the only level sampled until every
+//band is in; a frame later the mip chain is generated and the real image takes over under the same ID
+class cTextureStreamer
+{
+public:
+	cTextureStreamer(unsigned int numDecodeThreads = 2, unsigned int numPixelBuffers = 3);
+	~cTextureStreamer();
+
+	//An internalFormat of 0 keeps whatever channels the file has
+	unsigned int requestTexture2D(const std::string& filename, GLenum internalFormat);
+	//Faces are in GL_TEXTURE_CUBE_MAP_POSITIVE_X order
+	unsigned int requestCubeMap(const std::string& directory, const std::vector<std::string>& faces, GLenum internalFormat);
+
+	//Call once a frame on the context thread. Copies and uploads at most uploadBudgetBytes
+	//(or one row, if a single row is bigger than that)
+	void update();
+	bool isIdle();
+
+	size_t uploadBudgetBytes;
+	size_t bytesStagedLastFrame;
+	unsigned int numPending;
+
+private:
+	//One face at one mip level, sent up a band of rows at a time
+	struct sUploadRegion
+	{
+		GLenum target;
+		int level;
+		int width;
+		int height;
+		GLenum internalFormat;
+		//Of the pixels in source. The block format when compressed
+		GLenum format;
+		bool compressed;
+		const unsigned char* source;
+		//Bytes in a row of pixels, or in a row of 4x4 blocks when compressed
+		size_t rowBytes;
+		int numRows;
+		//Of the whole level, for glCompressedTexImage2D
+		size_t size;
+	};
+
+	struct sStreamJob
+	{
+		GLenum target;
+		GLenum internalFormat;
+		unsigned int textureID;
+		std::vector<std::string> filenames;
+		std::vector<cImage*> images;
+		std::vector<sUploadRegion> regions;
+		//Mip levels the finished texture has. The placeholder sits at this level until then
+		int numLevels;
+		bool allocated;
+		unsigned int nextRegion;
+		int nextRow;
+		bool failed;
+	};
+
+	//A band of rows copied into this frame's PBO, waiting to be uploaded from it
+	struct sChunk
+	{
+		sStreamJob* job;
+		unsigned int region;
+		int firstRow;
+		int numRows;
+		size_t offset;
+	};
+
+	struct sPixelBuffer
+	{
+		unsigned int ID;
+		size_t size;
+		GLsync fence;
+	};
+
+	cThreadPool decodePool;
+	std::vector<sPixelBuffer> pixelBuffers;
+	unsigned int nextPixelBuffer;
+
+	std::mutex decodedMutex;
+	std::deque<sStreamJob*> decodedJobs;
+	//Only touched on the context thread
+	std::deque<sStreamJob*> stagingJobs;
+
+	sStreamJob* queueJob(GLenum target, const std::vector<std::string>& filenames, GLenum internalFormat);
+	//CPU only, run on the decode thread once the images are in
+	void buildRegions(sStreamJob* job);
+	sPixelBuffer* acquirePixelBuffer(size_t numBytes);
+	void allocateStorage(sStreamJob* job);
+	void uploadChunks(sPixelBuffer& pixelBuffer, const std::vector<sChunk>& chunks, size_t numBytes);
+	//Mips and the switch from the placeholder, once every band is up. True if it generated mips
+	bool finishJob(sStreamJob* job);
+	void deleteJob(sStreamJob* job);
+
+	cTextureStreamer(const cTextureStreamer&);
+	cTextureStreamer& operator=(const cTextureStreamer&);
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "cThreadPool.h"
+
+cThreadPool::cThreadPool(unsigned int numThreads)
+{
+	numBusy = 0;
+	stopping = false;
+
+	if (numThreads == 0)
+		numThreads = std::thread::hardware_concurrency();
+	if (numThreads == 0)
+		numThreads = 1;
+
+	for (unsigned int index = 0; index < numThreads; index++)
+	{
+		workers.push_back(std::thread(&cThreadPool::workerLoop, this));
+	}
+}
+
+cThreadPool::~cThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(queueMutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+
+	for (int index = 0; index < workers.size(); index++)
+	{
+		workers[index].join();
+	}
+}
+
+void cThreadPool::submit(std::function<void()> job)
+{
+	{
+		std::unique_lock<std::mutex> lock(queueMutex);
+		jobs.push(job);
+	}
+	jobAvailable.notify_one();
+}
+
+void cThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(queueMutex);
+	while (!jobs.empty() || numBusy > 0)
+	{
+		allDone.wait(lock);
+	}
+}
+
+unsigned int cThreadPool::getNumThreads()
+{
+	return (unsigned int)workers.size();
+}
+
+void cThreadPool::workerLoop()
+{
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			while (!stopping && jobs.empty())
+			{
+				jobAvailable.wait(lock);
+			}
+			if (stopping && jobs.empty())
+				return;
+
+			job = jobs.front();
+			jobs.pop();
+			numBusy++;
+		}
+
+		job();
+
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			numBusy--;
+			if (jobs.empty() && numBusy == 0)
+				allDone.notify_all();
+		}
+	}
+}
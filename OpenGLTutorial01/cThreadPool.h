@@ -0,0 +1,40 @@
+#ifndef _HG_cThreadPool_
+#define _HG_cThreadPool_
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+//Fixed set of worker threads pulling jobs off a shared queue
+class cThreadPool
+{
+public:
+	//0 threads means one per hardware core
+	cThreadPool(unsigned int numThreads = 0);
+	~cThreadPool();
+
+	void submit(std::function<void()> job);
+	//Blocks until the queue is empty and every worker is idle
+	void wait();
+
+	unsigned int getNumThreads();
+
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()> > jobs;
+	std::mutex queueMutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable allDone;
+	unsigned int numBusy;
+	bool stopping;
+
+	void workerLoop();
+
+	cThreadPool(const cThreadPool&);
+	cThreadPool& operator=(const cThreadPool&);
+};
+
+#endif
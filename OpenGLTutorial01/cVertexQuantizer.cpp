@@ -0,0 +1,424 @@
+#include "cVertexQuantizer.h"
+
+#include <cmath>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+	unsigned short quantizeUnorm16(float value, float minimum, float extent)
+	{
+		if (extent <= 0.0f)
+			return 0;
+		float normalized = (value - minimum) / extent;
+		if (normalized < 0.0f)
+			normalized = 0.0f;
+		else if (normalized > 1.0f)
+			normalized = 1.0f;
+		return (unsigned short)floorf(normalized * 65535.0f + 0.5f);
+	}
+
+	float signNotZero(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	//Same rule GL uses to turn a normalized signed short back into a float
+	float snorm16ToFloat(short value)
+	{
+		float result = value / 32767.0f;
+		return result < -1.0f ? -1.0f : result;
+	}
+
+	short quantizeSnorm16(float value)
+	{
+		float scaled = floorf(value * 32767.0f + 0.5f);
+		return (short)(scaled < -32767.0f ? -32767.0f : (scaled > 32767.0f ? 32767.0f : scaled));
+	}
+
+	float angleDegrees(glm::vec3 first, glm::vec3 second)
+	{
+		if (glm::length(first) <= 0.0f || glm::length(second) <= 0.0f)
+			return 0.0f;
+		//atan2 rather than acos, which has no precision left this close to zero
+		return glm::degrees(atan2f(glm::length(glm::cross(first, second)), glm::dot(first, second)));
+	}
+
+	//Same blend animVert.glsl does, with the model matrix left out
+	glm::mat4 blendBones(const std::vector<glm::mat4>& palette, const int boneIDs[4], const float weights[4])
+	{
+		glm::mat4 result = palette[boneIDs[0]] * weights[0];
+		for (int influence = 1; influence < 4; influence++)
+		{
+			result += palette[boneIDs[influence]] * weights[influence];
+		}
+		return result;
+	}
+
+	//Small LCG so every run tests the same poses
+	float nextRandom(unsigned int& seed)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		return (seed >> 8) / 16777216.0f;
+	}
+}
+
+bool sSkinningError::withinTolerance()
+{
+	return maxPositionError <= positionTolerance &&
+		maxNormalErrorDegrees <= frameToleranceDegrees &&
+		maxTangentErrorDegrees <= frameToleranceDegrees &&
+		numBoneIDsOutOfRange == 0;
+}
+
+bool sQuantizationError::withinTolerance()
+{
+	return maxPositionError <= positionTolerance &&
+		maxNormalErrorDegrees <= normalToleranceDegrees &&
+		maxTexCoordError <= texCoordTolerance;
+}
+
+void cVertexQuantizer::quantize(const sVertex* vertices, unsigned int numVertices, sCompactMeshData& out)
+{
+	out.vertices.resize(numVertices);
+	out.positionMin = glm::vec3(0.0f);
+	out.positionExtent = glm::vec3(0.0f);
+	out.texCoordMin = glm::vec2(0.0f);
+	out.texCoordExtent = glm::vec2(0.0f);
+	if (numVertices == 0)
+		return;
+
+	glm::vec3 positionMax = vertices[0].Position;
+	glm::vec2 texCoordMax = vertices[0].TexCoords;
+	out.positionMin = vertices[0].Position;
+	out.texCoordMin = vertices[0].TexCoords;
+	for (unsigned int index = 1; index < numVertices; index++)
+	{
+		out.positionMin = glm::min(out.positionMin, vertices[index].Position);
+		positionMax = glm::max(positionMax, vertices[index].Position);
+		out.texCoordMin = glm::min(out.texCoordMin, vertices[index].TexCoords);
+		texCoordMax = glm::max(texCoordMax, vertices[index].TexCoords);
+	}
+	out.positionExtent = positionMax - out.positionMin;
+	out.texCoordExtent = texCoordMax - out.texCoordMin;
+
+	for (unsigned int index = 0; index < numVertices; index++)
+	{
+		const sVertex& vertex = vertices[index];
+		sCompactVertex& compact = out.vertices[index];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			compact.Position[axis] = quantizeUnorm16(vertex.Position[axis], out.positionMin[axis], out.positionExtent[axis]);
+		}
+		compact.Position[3] = 0;
+		encodeNormal(vertex.Normal, compact.Normal);
+		for (int axis = 0; axis < 2; axis++)
+		{
+			compact.TexCoords[axis] = quantizeUnorm16(vertex.TexCoords[axis], out.texCoordMin[axis], out.texCoordExtent[axis]);
+		}
+	}
+}
+
+sQuantizationError cVertexQuantizer::measureError(const sVertex* vertices, const sCompactMeshData& compact)
+{
+	sQuantizationError error;
+	error.maxPositionError = 0.0f;
+	error.maxNormalErrorDegrees = 0.0f;
+	error.maxTexCoordError = 0.0f;
+
+	//Rounding can be off by half a step on each axis, so allow a whole step along the diagonal
+	error.positionTolerance = glm::length(compact.positionExtent) / 65535.0f;
+	error.texCoordTolerance = glm::length(compact.texCoordExtent) / 65535.0f;
+	error.normalToleranceDegrees = 0.01f;
+
+	for (int index = 0; index < compact.vertices.size(); index++)
+	{
+		const sVertex& vertex = vertices[index];
+		const sCompactVertex& packed = compact.vertices[index];
+
+		float positionError = glm::length(decodePosition(packed, compact) - vertex.Position);
+		if (positionError > error.maxPositionError)
+			error.maxPositionError = positionError;
+
+		float texCoordError = glm::length(decodeTexCoords(packed, compact) - vertex.TexCoords);
+		if (texCoordError > error.maxTexCoordError)
+			error.maxTexCoordError = texCoordError;
+
+		//Degenerate normals have no direction to lose
+		float normalLength = glm::length(vertex.Normal);
+		if (normalLength > 0.0f)
+		{
+			//atan2 rather than acos, which has no precision left this close to zero
+			glm::vec3 original = vertex.Normal / normalLength;
+			glm::vec3 decoded = decodeNormal(packed.Normal);
+			float normalError = glm::degrees(atan2f(glm::length(glm::cross(decoded, original)), glm::dot(decoded, original)));
+			if (normalError > error.maxNormalErrorDegrees)
+				error.maxNormalErrorDegrees = normalError;
+		}
+	}
+
+	return error;
+}
+
+void cVertexQuantizer::encodeNormal(glm::vec3 normal, short out[2])
+{
+	float length = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+	if (length <= 0.0f)
+	{
+		out[0] = 0;
+		out[1] = 0;
+		return;
+	}
+
+	//Project onto the octahedron, then fold the lower half over the upper one
+	glm::vec2 projected(normal.x / length, normal.y / length);
+	if (normal.z < 0.0f)
+	{
+		projected = glm::vec2((1.0f - fabsf(projected.y)) * signNotZero(projected.x),
+			(1.0f - fabsf(projected.x)) * signNotZero(projected.y));
+	}
+
+	glm::vec3 target = glm::normalize(normal);
+	float bestCosine = -2.0f;
+	float baseX = floorf(projected.x * 32767.0f);
+	float baseY = floorf(projected.y * 32767.0f);
+	for (int corner = 0; corner < 4; corner++)
+	{
+		float x = baseX + (corner & 1);
+		float y = baseY + (corner >> 1);
+		short candidate[2];
+		candidate[0] = (short)(x < -32767.0f ? -32767.0f : (x > 32767.0f ? 32767.0f : x));
+		candidate[1] = (short)(y < -32767.0f ? -32767.0f : (y > 32767.0f ? 32767.0f : y));
+
+		float cosine = glm::dot(decodeNormal(candidate), target);
+		if (cosine > bestCosine)
+		{
+			bestCosine = cosine;
+			out[0] = candidate[0];
+			out[1] = candidate[1];
+		}
+	}
+}
+
+glm::vec3 cVertexQuantizer::decodeNormal(const short encoded[2])
+{
+	glm::vec3 normal(snorm16ToFloat(encoded[0]), snorm16ToFloat(encoded[1]), 0.0f);
+	normal.z = 1.0f - fabsf(normal.x) - fabsf(normal.y);
+	if (normal.z < 0.0f)
+	{
+		float x = normal.x;
+		normal.x = (1.0f - fabsf(normal.y)) * signNotZero(x);
+		normal.y = (1.0f - fabsf(x)) * signNotZero(normal.y);
+	}
+	return glm::normalize(normal);
+}
+
+glm::vec3 cVertexQuantizer::decodePosition(const sCompactVertex& vertex, const sCompactMeshData& mesh)
+{
+	glm::vec3 normalized(vertex.Position[0] / 65535.0f, vertex.Position[1] / 65535.0f, vertex.Position[2] / 65535.0f);
+	return mesh.positionMin + normalized * mesh.positionExtent;
+}
+
+glm::vec2 cVertexQuantizer::decodeTexCoords(const sCompactVertex& vertex, const sCompactMeshData& mesh)
+{
+	glm::vec2 normalized(vertex.TexCoords[0] / 65535.0f, vertex.TexCoords[1] / 65535.0f);
+	return mesh.texCoordMin + normalized * mesh.texCoordExtent;
+}
+
+
+void cVertexQuantizer::packSkinned(const sSkinnedMeshVertex* vertices, unsigned int numVertices, std::vector<sPackedSkinnedVertex>& out)
+{
+	out.resize(numVertices);
+	for (unsigned int index = 0; index < numVertices; index++)
+	{
+		const sSkinnedMeshVertex& vertex = vertices[index];
+		sPackedSkinnedVertex& packed = out[index];
+		packed.Position = vertex.Position;
+		packed.TexCoords = vertex.TexCoords;
+		encodeTangentFrame(vertex.Normal, vertex.Tangent, vertex.BiTangent, packed.TangentFrame);
+		for (int influence = 0; influence < 4; influence++)
+		{
+			//Out of range IDs are clamped here and reported by measureSkinningError
+			float boneID = vertex.BoneID[influence];
+			packed.BoneID[influence] = (unsigned char)(boneID < 0.0f ? 0.0f : (boneID > 255.0f ? 255.0f : boneID));
+		}
+		quantizeBoneWeights(vertex.BoneWeights, packed.BoneWeights);
+	}
+}
+
+sSkinningError cVertexQuantizer::measureSkinningError(const sSkinnedMeshVertex* vertices, const sPackedSkinnedVertex* packed, unsigned int numVertices)
+{
+	sSkinningError error;
+	error.maxPositionError = 0.0f;
+	error.maxNormalErrorDegrees = 0.0f;
+	error.maxTangentErrorDegrees = 0.0f;
+	error.frameToleranceDegrees = 0.05f;
+	error.numRenormalized = 0;
+	error.numBoneIDsOutOfRange = 0;
+
+	float radius = 0.0f;
+	for (unsigned int index = 0; index < numVertices; index++)
+	{
+		radius = glm::max(radius, glm::length(vertices[index].Position));
+	}
+	//Rigid bones and translations no longer than the radius keep every bone's copy of a vertex within
+	//2 * radius of the origin. Each weight can be off by one step, and there are four of them
+	error.positionTolerance = 4.0f * 2.0f * radius / 65535.0f + radius * 1e-5f;
+
+	unsigned int seed = 12345;
+	const int numPoses = 4;
+	std::vector<glm::mat4> palette(256);
+	for (int pose = 0; pose < numPoses; pose++)
+	{
+		for (int bone = 0; bone < palette.size(); bone++)
+		{
+			glm::vec3 axis(nextRandom(seed) - 0.5f, nextRandom(seed) - 0.5f, nextRandom(seed) - 0.5f);
+			if (glm::length(axis) < 0.01f)
+				axis = glm::vec3(0.0f, 1.0f, 0.0f);
+			float angle = (nextRandom(seed) - 0.5f) * glm::pi<float>();
+			glm::vec3 translation = glm::vec3(nextRandom(seed) - 0.5f, nextRandom(seed) - 0.5f, nextRandom(seed) - 0.5f) * radius;
+			palette[bone] = glm::rotate(glm::translate(glm::mat4(1.0f), translation), angle, glm::normalize(axis));
+		}
+
+		for (unsigned int index = 0; index < numVertices; index++)
+		{
+			const sSkinnedMeshVertex& vertex = vertices[index];
+			const sPackedSkinnedVertex& packedVertex = packed[index];
+
+			int referenceIDs[4];
+			int packedIDs[4];
+			float referenceWeights[4];
+			float packedWeights[4];
+			float weightSum = 0.0f;
+			bool outOfRange = false;
+			for (int influence = 0; influence < 4; influence++)
+			{
+				referenceIDs[influence] = (int)vertex.BoneID[influence];
+				if (referenceIDs[influence] < 0 || referenceIDs[influence] > 255)
+					outOfRange = true;
+				packedIDs[influence] = packedVertex.BoneID[influence];
+				referenceWeights[influence] = vertex.BoneWeights[influence] > 0.0f ? vertex.BoneWeights[influence] : 0.0f;
+				packedWeights[influence] = packedVertex.BoneWeights[influence] / 65535.0f;
+				weightSum += referenceWeights[influence];
+			}
+			if (outOfRange)
+			{
+				if (pose == 0)
+					error.numBoneIDsOutOfRange++;
+				continue;
+			}
+			//Unweighted vertices collapse to the origin either way, with no normal to compare
+			if (weightSum <= 0.0f)
+				continue;
+			if (pose == 0 && fabsf(weightSum - 1.0f) > 1e-4f)
+				error.numRenormalized++;
+			for (int influence = 0; influence < 4; influence++)
+			{
+				referenceWeights[influence] /= weightSum;
+			}
+
+			glm::mat4 referenceTransform = blendBones(palette, referenceIDs, referenceWeights);
+			glm::mat4 packedTransform = blendBones(palette, packedIDs, packedWeights);
+
+			glm::vec3 referencePosition = glm::vec3(referenceTransform * glm::vec4(vertex.Position, 1.0f));
+			glm::vec3 packedPosition = glm::vec3(packedTransform * glm::vec4(packedVertex.Position, 1.0f));
+			error.maxPositionError = glm::max(error.maxPositionError, glm::length(packedPosition - referencePosition));
+
+			//The tangent is compared against its orthogonalized version, which is all the frame can hold
+			glm::vec3 decodedNormal, decodedTangent, decodedBitangent;
+			decodeTangentFrame(packedVertex.TangentFrame, decodedNormal, decodedTangent, decodedBitangent);
+			glm::vec3 referenceTangent(0.0f);
+			if (glm::length(vertex.Normal) > 0.0f && glm::length(vertex.Tangent) > 0.0f)
+			{
+				glm::vec3 normal = glm::normalize(vertex.Normal);
+				referenceTangent = vertex.Tangent - normal * glm::dot(normal, vertex.Tangent);
+			}
+
+			glm::mat3 referenceNormalMatrix = glm::mat3(glm::inverse(glm::transpose(referenceTransform)));
+			glm::mat3 packedNormalMatrix = glm::mat3(glm::inverse(glm::transpose(packedTransform)));
+			error.maxNormalErrorDegrees = glm::max(error.maxNormalErrorDegrees,
+				angleDegrees(referenceNormalMatrix * vertex.Normal, packedNormalMatrix * decodedNormal));
+			error.maxTangentErrorDegrees = glm::max(error.maxTangentErrorDegrees,
+				angleDegrees(referenceNormalMatrix * referenceTangent, packedNormalMatrix * decodedTangent));
+		}
+	}
+
+	return error;
+}
+
+void cVertexQuantizer::encodeTangentFrame(glm::vec3 normal, glm::vec3 tangent, glm::vec3 bitangent, short out[4])
+{
+	glm::vec3 n = glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f, 0.0f, 1.0f);
+	glm::vec3 t = tangent - n * glm::dot(n, tangent);
+	//Meshes without tangents still need some frame, any direction along the surface will do
+	if (glm::length(t) < 1e-6f)
+		t = glm::cross(n, fabsf(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f));
+	t = glm::normalize(t);
+	glm::vec3 b = glm::cross(n, t);
+	bool mirrored = glm::dot(b, bitangent) < 0.0f;
+
+	glm::quat frame = glm::normalize(glm::quat_cast(glm::mat3(t, b, n)));
+	//q and -q are the same rotation, so w is free to carry the handedness
+	if (frame.w < 0.0f)
+		frame = -frame;
+	out[0] = quantizeSnorm16(frame.x);
+	out[1] = quantizeSnorm16(frame.y);
+	out[2] = quantizeSnorm16(frame.z);
+	out[3] = quantizeSnorm16(frame.w);
+	//snorm16 has no negative zero, keep w off zero so its sign survives
+	if (out[3] == 0)
+		out[3] = 1;
+	if (mirrored)
+	{
+		for (int component = 0; component < 4; component++)
+		{
+			out[component] = -out[component];
+		}
+	}
+}
+
+void cVertexQuantizer::decodeTangentFrame(const short encoded[4], glm::vec3& normal, glm::vec3& tangent, glm::vec3& bitangent)
+{
+	glm::vec4 q = glm::normalize(glm::vec4(snorm16ToFloat(encoded[0]), snorm16ToFloat(encoded[1]),
+		snorm16ToFloat(encoded[2]), snorm16ToFloat(encoded[3])));
+	tangent = glm::vec3(1.0f - 2.0f * (q.y * q.y + q.z * q.z), 2.0f * (q.x * q.y + q.w * q.z), 2.0f * (q.x * q.z - q.w * q.y));
+	normal = glm::vec3(2.0f * (q.x * q.z + q.w * q.y), 2.0f * (q.y * q.z - q.w * q.x), 1.0f - 2.0f * (q.x * q.x + q.y * q.y));
+	bitangent = glm::cross(normal, tangent) * (encoded[3] < 0 ? -1.0f : 1.0f);
+}
+
+void cVertexQuantizer::quantizeBoneWeights(const float weights[4], unsigned short out[4])
+{
+	double sum = 0.0;
+	for (int influence = 0; influence < 4; influence++)
+	{
+		sum += weights[influence] > 0.0f ? weights[influence] : 0.0f;
+	}
+	if (sum <= 0.0)
+	{
+		out[0] = out[1] = out[2] = out[3] = 0;
+		return;
+	}
+
+	//Round everything down, then hand the missing steps to the weights that lost the most
+	double remainders[4];
+	unsigned int total = 0;
+	for (int influence = 0; influence < 4; influence++)
+	{
+		double scaled = (weights[influence] > 0.0f ? weights[influence] : 0.0f) / sum * 65535.0;
+		out[influence] = (unsigned short)floor(scaled);
+		remainders[influence] = scaled - out[influence];
+		total += out[influence];
+	}
+	while (total < 65535)
+	{
+		int largest = 0;
+		for (int influence = 1; influence < 4; influence++)
+		{
+			if (remainders[influence] > remainders[largest])
+				largest = influence;
+		}
+		out[largest]++;
+		remainders[largest] = -1.0;
+		total++;
+	}
+}
@@ -0,0 +1,67 @@
+#ifndef _HG_cVertexQuantizer_
+#define _HG_cVertexQuantizer_
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "cMesh.h"
+
+//Worst case difference between a mesh and its quantized copy, and what we're willing to accept
+struct sQuantizationError
+{
+	float maxPositionError;
+	float positionTolerance;
+	float maxNormalErrorDegrees;
+	float normalToleranceDegrees;
+	float maxTexCoordError;
+	float texCoordTolerance;
+
+	bool withinTolerance();
+};
+
+//Worst case difference between skinning the full float vertices and the packed ones, over a set of test poses.
+//The float side uses the renormalized weights, so this only measures what packing loses
+struct sSkinningError
+{
+	float maxPositionError;
+	float positionTolerance;
+	float maxNormalErrorDegrees;
+	float maxTangentErrorDegrees;
+	float frameToleranceDegrees;
+	//Vertices whose imported weights didn't add up to 1 and were scaled at import
+	unsigned int numRenormalized;
+	//Bone IDs that don't fit in a byte, these vertices will skin to the wrong bones
+	unsigned int numBoneIDsOutOfRange;
+
+	bool withinTolerance();
+};
+
+//Converts full float vertices to sCompactVertex and back. Pure CPU code, safe on any thread.
+//The decode functions do exactly what the vertex shaders do, so measureError() sees what the GPU will see
+class cVertexQuantizer
+{
+public:
+	static void quantize(const sVertex* vertices, unsigned int numVertices, sCompactMeshData& out);
+	static sQuantizationError measureError(const sVertex* vertices, const sCompactMeshData& compact);
+
+	//Octahedral normal encoding. Picks whichever of the four nearest 16 bit codes decodes closest to the input
+	static void encodeNormal(glm::vec3 normal, short out[2]);
+	static glm::vec3 decodeNormal(const short encoded[2]);
+
+	static glm::vec3 decodePosition(const sCompactVertex& vertex, const sCompactMeshData& mesh);
+	static glm::vec2 decodeTexCoords(const sCompactVertex& vertex, const sCompactMeshData& mesh);
+
+	static void packSkinned(const sSkinnedMeshVertex* vertices, unsigned int numVertices, std::vector<sPackedSkinnedVertex>& out);
+	//CPU reference for animVert.glsl: skins both versions of every vertex with random rigid bone palettes and compares
+	static sSkinningError measureSkinningError(const sSkinnedMeshVertex* vertices, const sPackedSkinnedVertex* packed, unsigned int numVertices);
+
+	//Normal, tangent and bitangent as one quaternion. The tangent is made orthogonal to the normal first,
+	//the bitangent is rebuilt from the other two and the sign of w
+	static void encodeTangentFrame(glm::vec3 normal, glm::vec3 tangent, glm::vec3 bitangent, short out[4]);
+	static void decodeTangentFrame(const short encoded[4], glm::vec3& normal, glm::vec3& tangent, glm::vec3& bitangent);
+
+	//unorm16 weights that add up to exactly 65535. Weights that don't add up to 1 are scaled until they do
+	static void quantizeBoneWeights(const float weights[4], unsigned short out[4]);
+};
+
+#endif
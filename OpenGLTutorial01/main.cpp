@@ -23,6 +23,15 @@
 #include "cScreenQuad.h"
 #include "cPlaneObject.h"
 #include "cFrameBuffer.h"
+#include "cAssetLoader.h"
+#include "cImage.h"
+#include "cTextureRegistry.h"
+#include "cTextureStreamer.h"
+#include "cTextureCompressor.h"
+#include "cAnimationBenchmark.h"
+#include "cSharedUniforms.h"
+#include "cLightManager.h"
+#include "cLightClusterPass.h"
 
 //Setting up a camera GLOBAL
 cCamera Camera(glm::vec3(0.0f, 0.0f, 3.0f),		//Camera Position
@@ -70,15 +79,29 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 unsigned int loadCubeMap(std::string directory, std::vector<std::string> faces);
 
-int main()
+int main(int argc, char** argv)
 {
+	//Offline mode: OpenGLTutorial01 --compress-textures a.png b.jpg ... writes the .ktx files and quits, no window needed
+	if (argc > 1 && std::string(argv[1]) == "--compress-textures")
+	{
+		std::vector<std::string> filenames(argv + 2, argv + argc);
+		return cTextureCompressor::compressFiles(filenames) == 0 ? 0 : 1;
+	}
+
+	//Benchmark mode: OpenGLTutorial01 --benchmark-animation [model.fbx [clip.fbx ...]] times the animation code and quits.
+	//It still needs a (hidden) window, because the skinned mesh uploads itself on load
+	bool benchmarkAnimation = argc > 1 && std::string(argv[1]) == "--benchmark-animation";
+
 	glfwInit();
 
 	srand(time(NULL));
 
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	//4.3 for the storage buffers the lights live in, and the compute shaders for light culling and pre-skinning
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	if (benchmarkAnimation)
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
 	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
 	if (window == NULL)
@@ -95,6 +118,27 @@ int main()
 		std::cout << "Failed to initialzed GLAD" << std::endl;
 		return -1;
 	}
+	//The light clusters are built with a compute shader every frame, so there's no running without it
+	if (!GLAD_GL_VERSION_4_3)
+	{
+		std::cout << "OpenGL 4.3 is needed, this driver gave " << GLVersion.major << "." << GLVersion.minor << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+	//Without it every compressed texture would fail to upload and draw black, so they load uncompressed instead
+	cImage::compressTextures = cImage::isCompressionSupported();
+	if (!cImage::compressTextures)
+		std::cout << "GL_EXT_texture_compression_s3tc isn't supported, textures will load uncompressed" << std::endl;
+
+	if (benchmarkAnimation)
+	{
+		std::vector<std::string> clipFiles;
+		if (argc > 3)
+			clipFiles.assign(argv + 3, argv + argc);
+		int result = cAnimationBenchmark::run(argc > 2 ? argv[2] : "", clipFiles);
+		glfwTerminate();
+		return result;
+	}
 
 	glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
 
@@ -106,7 +150,8 @@ int main()
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
 
-	//Set up all our programs
+	//Set up all our programs, with the cluster sizes clusters.glsl needs defined first
+	cLightClusterPass::defineShaderConstants();
 	cShaderProgram* myProgram = new cShaderProgram();
 	myProgram->compileProgram("assets/shaders/", "vertShader.glsl", "fragShader.glsl");
 	mapShaderToName["mainProgram"] = myProgram;
@@ -115,6 +160,16 @@ int main()
 	myProgram->compileProgram("assets/shaders/", "animVert.glsl", "animFrag.glsl");
 	mapShaderToName["skinProgram"] = myProgram;
 
+	//For crowds drawn through cSkinnedInstanceRenderer
+	myProgram = new cShaderProgram();
+	myProgram->compileProgram("assets/shaders/", "animInstancedVert.glsl", "animFrag.glsl");
+	mapShaderToName["skinInstancedProgram"] = myProgram;
+
+	//For background crowds drawn through cBakedAnimation
+	myProgram = new cShaderProgram();
+	myProgram->compileProgram("assets/shaders/", "animBakedVert.glsl", "animFrag.glsl");
+	mapShaderToName["skinBakedProgram"] = myProgram;
+
 	myProgram = new cShaderProgram();
 	myProgram->compileProgram("assets/shaders/", "skyBoxVert.glsl", "skyBoxFrag.glsl");
 	mapShaderToName["skyboxProgram"] = myProgram;
@@ -127,41 +182,35 @@ int main()
 	myProgram->compileProgram("assets/shaders/", "quadVert.glsl", "quadFrag.glsl");
 	mapShaderToName["quadProgram"] = myProgram;
 
-	//Assemble all our models
+	//Assemble all our models and the static texture. The loader imports and decodes them all in parallel
+	cAssetLoader assetLoader;
+
+	//The terrain and lander are the heaviest meshes and get drawn three times a frame, so they use the compact vertex layout
 	std::string path = "assets/models/landing_site/CuriosityQR_xyz_n_uv.obj";
-	mapModelsToNames["Surface"] = new cModel(path);
+	mapModelsToNames["Surface"] = assetLoader.addModel(path, true);
 
 	path = "assets/models/lander/Entire_Lander_45686_faces.ply";
-	mapModelsToNames["Rover"] = new cModel(path);
+	mapModelsToNames["Rover"] = assetLoader.addModel(path, true);
 
 	path = "assets/models/tv_body/RetroTV.edited.bodyonly.ply";
-	mapModelsToNames["TV"] = new cModel(path);
+	mapModelsToNames["TV"] = assetLoader.addModel(path);
 
 	path = "assets/models/tv_screen/RetroTV.obj";
-	mapModelsToNames["Screen"] = new cModel(path);
+	mapModelsToNames["Screen"] = assetLoader.addModel(path);
 
 	unsigned int staticTexture;
-	glGenTextures(1, &staticTexture);
-	glBindTexture(GL_TEXTURE_2D, staticTexture);
-	// set the texture wrapping parameters
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	// set texture filtering parameters
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	// load image, create texture and generate mipmaps
-	int width, height, nrChannels;
-	unsigned char *data = SOIL_load_image("assets/textures/static_texture_by_rachaelwrites.png", &width, &height, &nrChannels, 0);
-	if (data)
-	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
-	{
-		std::cout << "Failed to load texture" << std::endl;
-	}
-	SOIL_free_image_data(data);
+	assetLoader.addTexture("assets/textures/static_texture_by_rachaelwrites.png", &staticTexture);
+
+	assetLoader.loadAll();
+	cTextureRegistry::getInstance().printReport();
+
+	//Anything loaded from here on streams in over the first few frames instead of blocking
+	cTextureStreamer* textureStreamer = new cTextureStreamer();
+	cTextureRegistry::getInstance().setStreamer(textureStreamer);
+
+	//The skyboxes are the biggest images we have, so they stream too
+	cSkybox daybox("assets/textures/skybox/", *textureStreamer);
+	cSkybox skybox("assets/textures/spacebox/", *textureStreamer);
 
 	//Making 3 frame buffers, one for each camera type, and one to draw at the end
 	cFrameBuffer mainFrameBuffer(SCR_HEIGHT, SCR_WIDTH);
@@ -194,10 +243,6 @@ int main()
 		glm::vec3(-0.212666675, -0.253757894, 0.943599463)
 	};
 
-	//Load the skyboxes
-	cSkybox daybox("assets/textures/skybox/");
-	cSkybox skybox("assets/textures/spacebox/");
-
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
 	mapShaderToName["skyboxProgram"]->useProgram();
@@ -213,63 +258,88 @@ int main()
 	mapShaderToName["mainProgram"]->useProgram();
 	mapShaderToName["mainProgram"]->setInt("skybox", 0);
 	mapShaderToName["mainProgram"]->setInt("reflectRefract", 0);
-	//Light settings go in here until I've made a class for them
+	//The lights live in storage buffers fragShader.glsl loops over, so any number of them costs no uniform calls
+	cLightManager* lightManager = new cLightManager();
 	{
 		//http://devernay.free.fr/cours/opengl/materials.html
-		mapShaderToName["mainProgram"]->setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
-		mapShaderToName["mainProgram"]->setVec3("dirLight.ambient", 0.15f, 0.15f, 0.15f);
-		mapShaderToName["mainProgram"]->setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
-		mapShaderToName["mainProgram"]->setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
-
-		mapShaderToName["mainProgram"]->setVec3("pointLights[0].position", pointLightPositions[0]);
-		mapShaderToName["mainProgram"]->setFloat("pointLights[0].constant", 1.0f);
-		mapShaderToName["mainProgram"]->setFloat("pointLights[0].linear", 0.09f);
-		mapShaderToName["mainProgram"]->setFloat("pointLights[0].quadratic", 0.032f);
-		mapShaderToName["mainProgram"]->setVec3("pointLights[0].ambient", 0.05f, 0.05f, 0.05f);
-		mapShaderToName["mainProgram"]->setVec3("pointLights[0].diffuse", 0.8f, 0.8f, 0.8f);
-		mapShaderToName["mainProgram"]->setVec3("pointLights[0].specular", 1.0f, 1.0f, 1.0f);
-
-		mapShaderToName["mainProgram"]->setVec3("pointLights[1].position", pointLightPositions[1]);
-		mapShaderToName["mainProgram"]->setFloat("pointLights[1].constant", 1.0f);
-		mapShaderToName["mainProgram"]->setFloat("pointLights[1].linear", 0.09f);
-		mapShaderToName["mainProgram"]->setFloat("pointLights[1].quadratic", 0.032f);
-		mapShaderToName["mainProgram"]->setVec3("pointLights[1].ambient", 0.05f, 0.05f, 0.05f);
-		mapShaderToName["mainProgram"]->setVec3("pointLights[1].diffuse", 0.8f, 0.8f, 0.8f);
-		mapShaderToName["mainProgram"]->setVec3("pointLights[1].specular", 1.0f, 1.0f, 1.0f);
-
-		mapShaderToName["mainProgram"]->setVec3("pointLights[2].position", pointLightPositions[2]);
-		mapShaderToName["mainProgram"]->setFloat("pointLights[2].constant", 1.0f);
-		mapShaderToName["mainProgram"]->setFloat("pointLights[2].linear", 0.09f);
-		mapShaderToName["mainProgram"]->setFloat("pointLights[2].quadratic", 0.032f);
-		mapShaderToName["mainProgram"]->setVec3("pointLights[2].ambient", 0.05f, 0.05f, 0.05f);
-		mapShaderToName["mainProgram"]->setVec3("pointLights[2].diffuse", 0.8f, 0.8f, 0.8f);
-		mapShaderToName["mainProgram"]->setVec3("pointLights[2].specular", 1.0f, 1.0f, 1.0f);
-
-		mapShaderToName["mainProgram"]->setVec3("pointLights[3].position", pointLightPositions[3]);
-		mapShaderToName["mainProgram"]->setFloat("pointLights[3].constant", 1.0f);
-		mapShaderToName["mainProgram"]->setFloat("pointLights[3].linear", 0.09f);
-		mapShaderToName["mainProgram"]->setFloat("pointLights[3].quadratic", 0.032f);
-		mapShaderToName["mainProgram"]->setVec3("pointLights[3].ambient", 0.05f, 0.05f, 0.05f);
-		mapShaderToName["mainProgram"]->setVec3("pointLights[3].diffuse", 0.8f, 0.8f, 0.8f);
-		mapShaderToName["mainProgram"]->setVec3("pointLights[3].specular", 1.0f, 1.0f, 1.0f);
-
-		mapShaderToName["mainProgram"]->setVec3("spotLight.position", glm::vec3(0.0f, 6.0f, 0.0f));
-		mapShaderToName["mainProgram"]->setVec3("spotLight.direction", glm::vec3(0.0f, -1.0f, 0.0f));
-		mapShaderToName["mainProgram"]->setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-		mapShaderToName["mainProgram"]->setFloat("spotLight.outerCutOff", glm::cos(glm::radians(15.0f)));
-		mapShaderToName["mainProgram"]->setFloat("spotLight.constant", 1.0f);
-		mapShaderToName["mainProgram"]->setFloat("spotLight.linear", 0.09f);
-		mapShaderToName["mainProgram"]->setFloat("spotLight.quadratic", 0.032f);
-		mapShaderToName["mainProgram"]->setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-		mapShaderToName["mainProgram"]->setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-		mapShaderToName["mainProgram"]->setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
+		sDirectionalLight dirLight;
+		dirLight.direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+		dirLight.ambient = glm::vec3(0.15f, 0.15f, 0.15f);
+		dirLight.diffuse = glm::vec3(0.4f, 0.4f, 0.4f);
+		dirLight.specular = glm::vec3(0.5f, 0.5f, 0.5f);
+		lightManager->add(dirLight);
+
+		for (unsigned int index = 0; index < 4; index++)
+		{
+			sPointLight pointLight;
+			pointLight.position = pointLightPositions[index];
+			pointLight.constant = 1.0f;
+			pointLight.linear = 0.09f;
+			pointLight.quadratic = 0.032f;
+			pointLight.ambient = glm::vec3(0.05f, 0.05f, 0.05f);
+			pointLight.diffuse = glm::vec3(0.8f, 0.8f, 0.8f);
+			pointLight.specular = glm::vec3(1.0f, 1.0f, 1.0f);
+			lightManager->add(pointLight);
+		}
+
+		sSpotLight spotLight;
+		spotLight.position = glm::vec3(0.0f, 6.0f, 0.0f);
+		spotLight.direction = glm::vec3(0.0f, -1.0f, 0.0f);
+		spotLight.cutOff = glm::cos(glm::radians(12.5f));
+		spotLight.outerCutOff = glm::cos(glm::radians(15.0f));
+		spotLight.constant = 1.0f;
+		spotLight.linear = 0.09f;
+		spotLight.quadratic = 0.032f;
+		spotLight.ambient = glm::vec3(0.0f, 0.0f, 0.0f);
+		spotLight.diffuse = glm::vec3(1.0f, 1.0f, 1.0f);
+		spotLight.specular = glm::vec3(1.0f, 1.0f, 1.0f);
+		lightManager->add(spotLight);
 		//http://wiki.ogre3d.org/tiki-index.php?page=-Point+Light+Attenuation
+
+		//Small coloured lights scattered over the mars surface. Each reaches a few units, so the clusters keep
+		//a fragment's light count low however many there are
+		const unsigned int NUM_SURFACE_LIGHTS = 256;
+		for (unsigned int index = 0; index < NUM_SURFACE_LIGHTS; index++)
+		{
+			sPointLight surfaceLight;
+			surfaceLight.position = glm::vec3(-10.0f + (rand() % 1001) / 1000.0f * 30.0f, -5.5f, 5.0f + (rand() % 1001) / 1000.0f * 35.0f);
+			surfaceLight.constant = 1.0f;
+			surfaceLight.linear = 0.7f;
+			surfaceLight.quadratic = 20.0f;
+			surfaceLight.diffuse = glm::vec3((rand() % 1001) / 1000.0f, (rand() % 1001) / 1000.0f, (rand() % 1001) / 1000.0f) * 0.8f;
+			lightManager->add(surfaceLight);
+		}
 	}
 
+	//Lists which of those lights reach each part of each of the three views
+	cLightClusterPass* lightClusterPass = new cLightClusterPass(3);
+
 	glm::vec3 roverPos = glm::vec3(4.435f, -6.796f, 23.341f);
 
 	float sceneTime = 0.0f;
 
+	//Everything the render loop sets, looked up once so the loop does no string lookups at all
+	cShaderProgram& mainProgram = *mapShaderToName["mainProgram"];
+	cShaderProgram& simpleProgram = *mapShaderToName["simpleProgram"];
+	cShaderProgram& skyboxProgram = *mapShaderToName["skyboxProgram"];
+	cShaderProgram& quadProgram = *mapShaderToName["quadProgram"];
+	sUniform<glm::mat4> mainModel = mainProgram.getUniform<glm::mat4>("model");
+	sUniform<glm::mat4> simpleModel = simpleProgram.getUniform<glm::mat4>("model");
+	sUniform<float> simpleStaticTime = simpleProgram.getUniform<float>("staticTime");
+	sUniform<float> simpleRandOffsetX = simpleProgram.getUniform<float>("randOffsetX");
+	sUniform<float> simpleRandOffsetY = simpleProgram.getUniform<float>("randOffsetY");
+	sUniform<int> quadDrawType = quadProgram.getUniform<int>("drawType");
+	cModel* surfaceModel = mapModelsToNames["Surface"];
+	cModel* roverModel = mapModelsToNames["Rover"];
+	cModel* tvModel = mapModelsToNames["TV"];
+	cModel* screenModel = mapModelsToNames["Screen"];
+
+	//The camera for each of the three views, written once per view and read by every program
+	const unsigned int ROTATING_VIEW = 0;
+	const unsigned int STATIC_VIEW = 1;
+	const unsigned int ROOM_VIEW = 2;
+	cSharedUniforms* sharedUniforms = new cSharedUniforms(3);
+
 	while (!glfwWindowShouldClose(window))
 	{
 		processInput(window);
@@ -278,6 +348,9 @@ int main()
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
+		//Feed a frame's worth of any pending texture data to the GPU
+		textureStreamer->update();
+
 		//If there's static on either TV screen, count down to make it go away
 		if (staticTime > 0.0f)
 		{
@@ -340,12 +413,13 @@ int main()
 		}
 		//END OF CODE
 
-		mapShaderToName["mainProgram"]->useProgram();
-		mapShaderToName["mainProgram"]->setVec3("cameraPos", RotatingCamera.position);
+		sharedUniforms->setFrame(currentFrame, deltaTime, SCR_WIDTH, SCR_HEIGHT);
+		//Only sends lights that changed since last frame
+		lightManager->update();
 
 		glm::mat4 projection = glm::perspective(glm::radians(RotatingCamera.zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-		glm::mat4 view = RotatingCamera.getViewMatrix();
-		glm::mat4 skyboxView = glm::mat4(glm::mat3(RotatingCamera.getViewMatrix()));
+		sharedUniforms->setView(ROTATING_VIEW, RotatingCamera.getViewMatrix(), projection, RotatingCamera.position);
+		lightClusterPass->cull(ROTATING_VIEW);
 
 		//Begin by drawing the mars scene to the first frame buffer
 		glBindFramebuffer(GL_FRAMEBUFFER, rotatingFrameBuffer.FBO);
@@ -356,28 +430,24 @@ int main()
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		//Draw the mars surface
-		mapShaderToName["mainProgram"]->useProgram();
+		mainProgram.useProgram();
 		glm::mat4 model = glm::mat4(1.0f);
 		model = glm::translate(model, glm::vec3(0.0f, -5.0f, 0.0f));
 		model = glm::scale(model, glm::vec3(0.2f));
-		mapShaderToName["mainProgram"]->setMat4("projection", projection);
-		mapShaderToName["mainProgram"]->setMat4("view", view);
-		mapShaderToName["mainProgram"]->setMat4("model", model);
+		mainModel.set(model);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, skybox.textureID);
-		mapModelsToNames["Surface"]->Draw(*mapShaderToName["mainProgram"]);
+		surfaceModel->Draw(mainProgram);
 
 		model = glm::mat4(1.0f);
 		model = glm::translate(model, roverPos);
 		model = glm::scale(model, glm::vec3(0.04f));
-		mapShaderToName["mainProgram"]->setMat4("model", model);
-		mapModelsToNames["Rover"]->Draw(*mapShaderToName["mainProgram"]);
+		mainModel.set(model);
+		roverModel->Draw(mainProgram);
 
 		//Drawing the space skybox
-		mapShaderToName["skyboxProgram"]->useProgram();
+		skyboxProgram.useProgram();
 
 		glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
-		mapShaderToName["skyboxProgram"]->setMat4("projection", projection);
-		mapShaderToName["skyboxProgram"]->setMat4("view", skyboxView);
 
 		glBindVertexArray(skybox.VAO);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, skybox.textureID);
@@ -385,12 +455,9 @@ int main()
 		glDepthFunc(GL_LESS);
 
 		//Draw the static camera image
-		mapShaderToName["mainProgram"]->useProgram();
-		mapShaderToName["mainProgram"]->setVec3("cameraPos", StaticCamera.position);
-
 		projection = glm::perspective(glm::radians(StaticCamera.zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-		view = StaticCamera.getViewMatrix();
-		skyboxView = glm::mat4(glm::mat3(StaticCamera.getViewMatrix()));
+		sharedUniforms->setView(STATIC_VIEW, StaticCamera.getViewMatrix(), projection, StaticCamera.position);
+		lightClusterPass->cull(STATIC_VIEW);
 
 		glBindFramebuffer(GL_FRAMEBUFFER, staticFrameBuffer.FBO);
 
@@ -400,28 +467,24 @@ int main()
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		//Draw the mars surface
-		mapShaderToName["mainProgram"]->useProgram();
+		mainProgram.useProgram();
 		model = glm::mat4(1.0f);
 		model = glm::translate(model, glm::vec3(0.0f, -5.0f, 0.0f));
 		model = glm::scale(model, glm::vec3(0.2f));
-		mapShaderToName["mainProgram"]->setMat4("projection", projection);
-		mapShaderToName["mainProgram"]->setMat4("view", view);
-		mapShaderToName["mainProgram"]->setMat4("model", model);
+		mainModel.set(model);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, skybox.textureID);
-		mapModelsToNames["Surface"]->Draw(*mapShaderToName["mainProgram"]);
+		surfaceModel->Draw(mainProgram);
 
 		model = glm::mat4(1.0f);
 		model = glm::translate(model, roverPos);
 		model = glm::scale(model, glm::vec3(0.04f));
-		mapShaderToName["mainProgram"]->setMat4("model", model);
-		mapModelsToNames["Rover"]->Draw(*mapShaderToName["mainProgram"]);
+		mainModel.set(model);
+		roverModel->Draw(mainProgram);
 
 		//Drawing the space skybox
-		mapShaderToName["skyboxProgram"]->useProgram();
+		skyboxProgram.useProgram();
 
 		glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
-		mapShaderToName["skyboxProgram"]->setMat4("projection", projection);
-		mapShaderToName["skyboxProgram"]->setMat4("view", skyboxView);
 
 		glBindVertexArray(skybox.VAO);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, skybox.textureID);
@@ -434,19 +497,17 @@ int main()
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		projection = glm::perspective(glm::radians(Camera.zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-		view = Camera.getViewMatrix();
-		skyboxView = glm::mat4(glm::mat3(Camera.getViewMatrix()));
+		sharedUniforms->setView(ROOM_VIEW, Camera.getViewMatrix(), projection, Camera.position);
+		lightClusterPass->cull(ROOM_VIEW);
 
 		//Making TV number 1
-		mapShaderToName["mainProgram"]->useProgram();
+		mainProgram.useProgram();
 		model = glm::mat4(1.0f);
 		model = glm::translate(model, glm::vec3(-1.5f, -0.75, 0.0f));
 		model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
 		model = glm::scale(model, glm::vec3(0.02f));
-		mapShaderToName["mainProgram"]->setMat4("projection", projection);
-		mapShaderToName["mainProgram"]->setMat4("view", view);
-		mapShaderToName["mainProgram"]->setMat4("model", model);
-		mapModelsToNames["TV"]->Draw(*mapShaderToName["mainProgram"]);
+		mainModel.set(model);
+		tvModel->Draw(mainProgram);
 
 		//Generate random numbers for the static this frame
 		int intXOffset = rand() % 1001;		//Random number from 0 to 1000
@@ -454,17 +515,15 @@ int main()
 		float floatXOffset = (float)intXOffset / 1000.0f;
 		float floatYOffset = (float)intYOffset / 1000.0f;
 
-		mapShaderToName["simpleProgram"]->useProgram();
+		simpleProgram.useProgram();
 		model = glm::mat4(1.0f);
 		model = glm::translate(model, glm::vec3(-1.5f, -0.75, 0.0f));
 		model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
 		model = glm::scale(model, glm::vec3(0.02f));
-		mapShaderToName["simpleProgram"]->setMat4("projection", projection);
-		mapShaderToName["simpleProgram"]->setMat4("view", view);
-		mapShaderToName["simpleProgram"]->setMat4("model", model);
-		mapShaderToName["simpleProgram"]->setFloat("staticTime", staticTime);
-		mapShaderToName["simpleProgram"]->setFloat("randOffsetX", floatXOffset);
-		mapShaderToName["simpleProgram"]->setFloat("randOffsetY", floatYOffset);
+		simpleModel.set(model);
+		simpleStaticTime.set(staticTime);
+		simpleRandOffsetX.set(floatXOffset);
+		simpleRandOffsetY.set(floatYOffset);
 		glActiveTexture(GL_TEXTURE0);
 		if (TV1Channel)
 		{
@@ -476,16 +535,16 @@ int main()
 		}	
 		glActiveTexture(GL_TEXTURE1);
 		glBindTexture(GL_TEXTURE_2D, staticTexture);
-		mapModelsToNames["Screen"]->Draw(*mapShaderToName["simpleProgram"]);
+		screenModel->Draw(simpleProgram);
 
 		//And here's TV number 2
-		mapShaderToName["mainProgram"]->useProgram();
+		mainProgram.useProgram();
 		model = glm::mat4(1.0f);
 		model = glm::translate(model, glm::vec3(1.5f, -0.75, 0.0f));
 		model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
 		model = glm::scale(model, glm::vec3(0.02f));
-		mapShaderToName["mainProgram"]->setMat4("model", model);
-		mapModelsToNames["TV"]->Draw(*mapShaderToName["mainProgram"]);
+		mainModel.set(model);
+		tvModel->Draw(mainProgram);
 
 		//Generate random numbers for the static this frame
 		intXOffset = rand() % 1001;		//Random number from 0 to 1000
@@ -493,15 +552,15 @@ int main()
 		floatXOffset = (float)intXOffset / 1000.0f;
 		floatYOffset = (float)intYOffset / 1000.0f;
 
-		mapShaderToName["simpleProgram"]->useProgram();
+		simpleProgram.useProgram();
 		model = glm::mat4(1.0f);
 		model = glm::translate(model, glm::vec3(1.5f, -0.75, 0.0f));
 		model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
 		model = glm::scale(model, glm::vec3(0.02f));
-		mapShaderToName["simpleProgram"]->setMat4("model", model);
-		mapShaderToName["simpleProgram"]->setFloat("staticTime", staticTime2);
-		mapShaderToName["simpleProgram"]->setFloat("randOffsetX", floatXOffset);
-		mapShaderToName["simpleProgram"]->setFloat("randOffsetY", floatYOffset);
+		simpleModel.set(model);
+		simpleStaticTime.set(staticTime2);
+		simpleRandOffsetX.set(floatXOffset);
+		simpleRandOffsetY.set(floatYOffset);
 		glActiveTexture(GL_TEXTURE0);
 		if (TV2Channel)
 		{
@@ -513,13 +572,11 @@ int main()
 		}
 		glActiveTexture(GL_TEXTURE1);
 		glBindTexture(GL_TEXTURE_2D, staticTexture);
-		mapModelsToNames["Screen"]->Draw(*mapShaderToName["simpleProgram"]);
+		screenModel->Draw(simpleProgram);
 
-		mapShaderToName["skyboxProgram"]->useProgram();
+		skyboxProgram.useProgram();
 
 		glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
-		mapShaderToName["skyboxProgram"]->setMat4("projection", projection);
-		mapShaderToName["skyboxProgram"]->setMat4("view", skyboxView);
 
 		glBindVertexArray(skybox.VAO);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, daybox.textureID);
@@ -533,8 +590,8 @@ int main()
 		glClear(GL_COLOR_BUFFER_BIT);
 
 		//Paste the entire scene onto a quad as a single texture
-		mapShaderToName["quadProgram"]->useProgram();
-		mapShaderToName["quadProgram"]->setInt("drawType", drawType);
+		quadProgram.useProgram();
+		quadDrawType.set(drawType);
 		glBindVertexArray(screenQuad.VAO);
 		glBindTexture(GL_TEXTURE_2D, mainFrameBuffer.textureID);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -546,6 +603,13 @@ int main()
 		glfwPollEvents();
 	}
 
+	//The streamer owns GL objects, so it has to go while the context is still alive
+	cTextureRegistry::getInstance().setStreamer(NULL);
+	delete textureStreamer;
+	delete sharedUniforms;
+	delete lightManager;
+	delete lightClusterPass;
+
 	glfwTerminate();
 
 	return 0;